@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Calibración y umbral de KBENCH() (kbench.h), compartidos por todas las
+ * suites: un solo parámetro slack y un solo cronometraje del bucle de
+ * referencia, hecho al cargar.
+ */
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/compiler.h>
+
+#include "kbench.h"
+
+#define KBENCH_REF_ITERS	1000000
+
+static unsigned int slack = 300;
+module_param(slack, uint, 0644);
+MODULE_PARM_DESC(slack, "Holgura de los microbenchmarks KUnit en % de la base");
+
+static unsigned long ref_ps;
+module_param(ref_ps, ulong, 0444);
+MODULE_PARM_DESC(ref_ps, "ps por unidad del bucle de referencia en esta máquina");
+
+/* Una unidad: multiplicación y suma dependientes de la anterior */
+static noinline u64 kbench_ref_loop(u64 x, unsigned int n)
+{
+	while (n--) {
+		x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+		OPTIMIZER_HIDE_VAR(x);
+	}
+	return x;
+}
+
+/* Tiempo por unidad y bases en unidades: base * ref_ps es la cota en ps */
+void kbench_check(struct kunit *test, const char *name, u64 ns, unsigned int base)
+{
+	u64 limit_ps = div_u64((u64)base * ref_ps * READ_ONCE(slack), 100);
+
+	kunit_info(test, "bench %s: %llu ns/iter (base %u x %lu ps)\n",
+		   name, ns, base, ref_ps);
+	KUNIT_EXPECT_LE_MSG(test, ns * 1000, limit_ps,
+			    "%s más lento que la base", name);
+}
+EXPORT_SYMBOL_GPL(kbench_check);
+
+static int __init kbench_init(void)
+{
+	u64 best = U64_MAX, t0;
+	int r;
+
+	for (r = 0; r < KBENCH_ROUNDS; r++) {
+		t0 = ktime_get_ns();
+		kbench_ref_loop(t0, KBENCH_REF_ITERS);
+		best = min(best, ktime_get_ns() - t0);
+		cond_resched();
+	}
+	ref_ps = max_t(u64, div_u64(best * 1000, KBENCH_REF_ITERS), 1);
+	pr_info("kbench: referencia %lu ps/unidad, slack %u%%\n", ref_ps, slack);
+	return 0;
+}
+
+static void __exit kbench_exit(void)
+{
+}
+
+module_init(kbench_init);
+module_exit(kbench_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Jaime Garcia Coronel j.gcoronel@condumex.com.mx");
+MODULE_DESCRIPTION("Calibración de los microbenchmarks KUnit del repo");
@@ -0,0 +1,43 @@
+#ifndef KBENCH_H
+#define KBENCH_H
+
+/*
+ * Microbenchmarks dentro de las suites KUnit del repo.
+ *
+ * Las suites no corren con kunit.py: van incluidas en los módulos
+ * (make KUNIT=1 define MY_KUNIT) y las ejecuta el propio insmod, en el
+ * orden de kunit/run_kunit.sh. kbench.ko se carga antes que todos.
+ *
+ * KBENCH() mide ns por iteración (mejor de KBENCH_ROUNDS rondas, para
+ * quitar ruido de interrupciones) y lo compara con la base del test en
+ * unidades del bucle de referencia de kbench.ko, que se cronometra al
+ * cargarlo en la misma máquina. Una unidad son ~1 ns en un x86 de
+ * 3-4 GHz, así que las bases se leen como ns de esa máquina. Falla si
+ * pasa de la base por kbench.slack/100.
+ */
+#include <kunit/test.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+
+#define KBENCH_ROUNDS	5
+
+void kbench_check(struct kunit *test, const char *name, u64 ns, unsigned int base);
+
+#define KBENCH(test, name, iters, base, body)				\
+do {									\
+	u64 __best = U64_MAX, __t0, __ns;				\
+	unsigned int __r, __i;						\
+									\
+	for (__r = 0; __r < KBENCH_ROUNDS; __r++) {			\
+		__t0 = ktime_get_ns();					\
+		for (__i = 0; __i < (iters); __i++) {			\
+			body;						\
+		}							\
+		__ns = div_u64(ktime_get_ns() - __t0, (iters));		\
+		__best = min(__best, __ns);				\
+		cond_resched();						\
+	}								\
+	kbench_check(test, name, __best, (base));			\
+} while (0)
+
+#endif /* KBENCH_H */
@@ -0,0 +1,63 @@
+#!/bin/sh
+# Corre las suites KUnit de los módulos del repo sobre gpio-sim. Van
+# dentro de los módulos y corren al cargarlos: kunit.py no las ve.
+#
+# Kernel con kunit/.kunitconfig (UML o QEMU), módulos compilados con
+#   make -C memacct && make -C kunit &&
+#   for d in myioctl mychar myiiodr; do make -C $d KUNIT=1; done
+# y este script como root desde la raíz del repo:
+#   KBENCH_SLACK=500 ./kunit/run_kunit.sh
+set -e
+
+SIM=/sys/kernel/config/gpio-sim/blink
+LABEL=blink-sim
+SLACK=${KBENCH_SLACK:-300}
+
+mountpoint -q /sys/kernel/config || mount -t configfs none /sys/kernel/config
+mountpoint -q /sys/kernel/debug || mount -t debugfs none /sys/kernel/debug
+
+# Chip simulado con las líneas 16/20/21 que usan los motores y 24/25 de
+# entrada para my_iio_pulse
+modprobe gpio-sim
+if [ ! -d $SIM ]; then
+	mkdir $SIM $SIM/bank0
+	echo 32 > $SIM/bank0/num_lines
+	echo $LABEL > $SIM/bank0/label
+	echo 1 > $SIM/live
+fi
+
+modprobe industrialio_triggered_buffer 2>/dev/null || true
+
+insmod kunit/kbench.ko slack=$SLACK
+insmod memacct/memacct.ko
+insmod myioctl/blink_journal.ko
+insmod myioctl/kthread_blink_nodt.ko chip=$LABEL
+insmod myioctl/timer_blink_nodt.ko chip=$LABEL
+insmod myioctl/hrtimer_blink_char_nodt.ko chip=$LABEL
+
+# Probe asíncrono: esperar a que los motores terminen antes de blinkctl
+for m in kthread_blink_nodt timer_blink_nodt hrtimer_blink_char_nodt; do
+	i=0
+	while [ "$(cat /sys/module/$m/parameters/probe_us)" = 0 ] && [ $i -lt 50 ]; do
+		sleep 0.1
+		i=$((i + 1))
+	done
+done
+
+insmod myioctl/blink_ctrl_ioctl.ko
+insmod mychar/simple_char.ko
+insmod myiiodr/my_iio_dummy.ko
+insmod myiiodr/my_iio_pulse.ko chip=$LABEL lines=24,25
+
+fail=0
+for s in blinkctl hrtimer_blink simple_char my_iio_dummy my_iio_pulse; do
+	r=/sys/kernel/debug/kunit/$s/results
+	echo "=== $s"
+	cat $r
+	grep -q "not ok" $r && fail=1
+done
+
+rmmod my_iio_pulse my_iio_dummy simple_char blink_ctrl_ioctl \
+	hrtimer_blink_char_nodt timer_blink_nodt kthread_blink_nodt blink_journal memacct kbench
+
+exit $fail
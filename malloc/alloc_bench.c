@@ -0,0 +1,372 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Microbenchmark de asignadores del kernel.
+ *
+ * /sys/kernel/debug/my_kmalloc_dummy/alloc_bench/
+ *   size        bytes por objeto (kmalloc, cache, mempool, vmalloc, percpu)
+ *   order       orden para alloc_pages
+ *   batch       objetos vivos a la vez por hilo
+ *   iterations  rondas de asignar batch + liberar batch
+ *   threads     kthreads, repartidos en orden por las CPUs en línea
+ *   gfp         0 = GFP_KERNEL, 1 = GFP_ATOMIC, 2 = GFP_NOWAIT
+ *   run         escribir el nombre de una prueba, o "all"
+ *   results     ns/op de asignar y de liberar, Mops/s y tasa de fallos
+ *
+ * Asignar y liberar se cronometran por separado: el costo de liberar no
+ * se esconde dentro del de asignar.
+ */
+#include <linux/module.h>
+#include <linux/slab.h>       /* kmalloc, kmem_cache_* */
+#include <linux/vmalloc.h>    /* vmalloc */
+#include <linux/mm.h>         /* kvmalloc, alloc_pages */
+#include <linux/mempool.h>
+#include <linux/percpu.h>
+#include <linux/kthread.h>
+#include <linux/completion.h>
+#include <linux/wait.h>
+#include <linux/cpu.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
+
+#include "my_kmalloc.h"
+
+enum bench_test {
+	BENCH_KMALLOC,
+	BENCH_KMEM_CACHE,
+	BENCH_MEMPOOL,
+	BENCH_VMALLOC,
+	BENCH_KVMALLOC,
+	BENCH_PAGES,
+	BENCH_PERCPU,
+	BENCH__MAX
+};
+
+static const char * const bench_names[BENCH__MAX] = {
+	[BENCH_KMALLOC]    = "kmalloc",
+	[BENCH_KMEM_CACHE] = "kmem_cache",
+	[BENCH_MEMPOOL]    = "mempool",
+	[BENCH_VMALLOC]    = "vmalloc",
+	[BENCH_KVMALLOC]   = "kvmalloc",
+	[BENCH_PAGES]      = "pages",
+	[BENCH_PERCPU]     = "percpu",
+};
+
+static const char * const gfp_names[] = { "kernel", "atomic", "nowait" };
+static const gfp_t gfp_modes[] = { GFP_KERNEL, GFP_ATOMIC, GFP_NOWAIT };
+
+struct bench_result {
+	bool valid;
+	u32 size, order, threads, gfp;
+	u64 ops, fails;
+	u64 alloc_ns, free_ns;        /* suma del tiempo de todos los hilos */
+	u64 wall_ns;
+};
+
+/* Una ejecución: vive en la pila de bench_run_one() hasta el kthread_stop */
+struct bench_run {
+	enum bench_test test;
+	gfp_t gfp;
+	u32 size, order, batch, iterations;
+	struct kmem_cache *cache;
+	mempool_t *pool;
+	atomic_t pending;
+	struct completion done;
+	wait_queue_head_t start_wq;
+	bool go;
+};
+
+struct bench_thread {
+	struct bench_run *run;
+	struct task_struct *task;
+	u64 alloc_ns, free_ns, ops, fails;
+};
+
+static u32 b_size = 256;
+static u32 b_order;
+static u32 b_batch = 64;
+static u32 b_iterations = 1000;
+static u32 b_threads = 1;
+static u32 b_gfp;
+
+/* Copia de los parámetros de debugfs, tomada y validada una vez por run */
+struct bench_params {
+	u32 size, order, batch, iterations, threads, gfp;
+};
+
+static struct bench_result results[BENCH__MAX];
+static DEFINE_MUTEX(bench_lock);
+
+static void *bench_alloc(struct bench_run *r)
+{
+	switch (r->test) {
+	case BENCH_KMALLOC:    return kmalloc(r->size, r->gfp);
+	case BENCH_KMEM_CACHE: return kmem_cache_alloc(r->cache, r->gfp);
+	case BENCH_MEMPOOL:    return mempool_alloc(r->pool, r->gfp);
+	case BENCH_VMALLOC:    return vmalloc(r->size);   /* siempre GFP_KERNEL */
+	case BENCH_KVMALLOC:   return kvmalloc(r->size, r->gfp);
+	case BENCH_PAGES:      return alloc_pages(r->gfp, r->order);
+	case BENCH_PERCPU:
+		return (void __force *)__alloc_percpu_gfp(r->size, sizeof(long), r->gfp);
+	default:               return NULL;
+	}
+}
+
+static void bench_free(struct bench_run *r, void *p)
+{
+	switch (r->test) {
+	case BENCH_KMALLOC:    kfree(p); break;
+	case BENCH_KMEM_CACHE: kmem_cache_free(r->cache, p); break;
+	case BENCH_MEMPOOL:    mempool_free(p, r->pool); break;
+	case BENCH_VMALLOC:    vfree(p); break;
+	case BENCH_KVMALLOC:   kvfree(p); break;
+	case BENCH_PAGES:      __free_pages(p, r->order); break;
+	case BENCH_PERCPU:     free_percpu((void __percpu __force *)p); break;
+	default:               break;
+	}
+}
+
+static int bench_thread_fn(void *arg)
+{
+	struct bench_thread *t = arg;
+	struct bench_run *r = t->run;
+	void **objs;
+	u32 i, j;
+	u64 t0;
+
+	objs = kcalloc(r->batch, sizeof(*objs), GFP_KERNEL);
+	wait_event(r->start_wq, READ_ONCE(r->go));
+
+	for (i = 0; objs && i < r->iterations; i++) {
+		t0 = ktime_get_ns();
+		for (j = 0; j < r->batch; j++)
+			objs[j] = bench_alloc(r);
+		t->alloc_ns += ktime_get_ns() - t0;
+
+		t0 = ktime_get_ns();
+		for (j = 0; j < r->batch; j++) {
+			if (objs[j])
+				bench_free(r, objs[j]);
+			else
+				t->fails++;
+		}
+		t->free_ns += ktime_get_ns() - t0;
+		t->ops += r->batch;
+		cond_resched();
+	}
+	kfree(objs);
+
+	if (atomic_dec_and_test(&r->pending))
+		complete(&r->done);
+
+	/* Sigue vivo hasta kthread_stop(): el controlador lee t después */
+	set_current_state(TASK_INTERRUPTIBLE);
+	while (!kthread_should_stop()) {
+		schedule();
+		set_current_state(TASK_INTERRUPTIBLE);
+	}
+	__set_current_state(TASK_RUNNING);
+	return 0;
+}
+
+static int bench_setup(struct bench_run *r, unsigned int nthreads)
+{
+	switch (r->test) {
+	case BENCH_KMEM_CACHE:
+		r->cache = kmem_cache_create("my_kmalloc_bench", r->size, 0, 0, NULL);
+		return r->cache ? 0 : -ENOMEM;
+	case BENCH_MEMPOOL:
+		/* Reserva suficiente para que ningún hilo dependa de kmalloc */
+		r->pool = mempool_create_kmalloc_pool(r->batch * nthreads, r->size);
+		return r->pool ? 0 : -ENOMEM;
+	case BENCH_PAGES:
+		return r->order < MAX_ORDER ? 0 : -EINVAL;
+	case BENCH_PERCPU:
+		return r->size <= PCPU_MIN_UNIT_SIZE ? 0 : -EINVAL;
+	default:
+		return 0;
+	}
+}
+
+static void bench_teardown(struct bench_run *r)
+{
+	if (r->pool)
+		mempool_destroy(r->pool);
+	kmem_cache_destroy(r->cache);
+}
+
+static int bench_run_one(enum bench_test test, const struct bench_params *p)
+{
+	struct bench_run r = {
+		.test       = test,
+		.gfp        = gfp_modes[p->gfp],
+		.size       = p->size,
+		.order      = p->order,
+		.batch      = p->batch,
+		.iterations = p->iterations,
+	};
+	struct bench_result *res = &results[test];
+	struct bench_thread *th;
+	unsigned int i, n = p->threads, created = 0;
+	int cpu, ret;
+	u64 t0;
+
+	ret = bench_setup(&r, n);
+	if (ret)
+		goto out;
+
+	th = kcalloc(n, sizeof(*th), GFP_KERNEL);
+	if (!th) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	atomic_set(&r.pending, n);
+	init_completion(&r.done);
+	init_waitqueue_head(&r.start_wq);
+
+	cpus_read_lock();
+	cpu = cpumask_first(cpu_online_mask);
+	for (i = 0; i < n; i++) {
+		struct task_struct *task;
+
+		th[i].run = &r;
+		task = kthread_create_on_node(bench_thread_fn, &th[i],
+					      cpu_to_node(cpu), "kmbench/%u", i);
+		if (IS_ERR(task))
+			break;
+		kthread_bind(task, cpu);
+		th[i].task = task;
+		wake_up_process(task);
+		created++;
+
+		cpu = cpumask_next(cpu, cpu_online_mask);
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first(cpu_online_mask);
+	}
+
+	if (!created) {
+		cpus_read_unlock();
+		kfree(th);
+		ret = -ENOMEM;
+		goto out;
+	}
+	/* Los hilos no creados no van a descontar pending */
+	if (created < n)
+		atomic_sub(n - created, &r.pending);
+
+	t0 = ktime_get_ns();
+	WRITE_ONCE(r.go, true);
+	wake_up_all(&r.start_wq);
+	wait_for_completion(&r.done);
+
+	memset(res, 0, sizeof(*res));
+	res->wall_ns = ktime_get_ns() - t0;
+	for (i = 0; i < created; i++) {
+		kthread_stop(th[i].task);
+		res->ops      += th[i].ops;
+		res->fails    += th[i].fails;
+		res->alloc_ns += th[i].alloc_ns;
+		res->free_ns  += th[i].free_ns;
+	}
+	cpus_read_unlock();
+
+	res->valid   = true;
+	res->size    = r.size;
+	res->order   = r.order;
+	res->threads = created;
+	res->gfp     = p->gfp;
+	kfree(th);
+out:
+	bench_teardown(&r);
+	return ret;
+}
+
+static ssize_t bench_run_write(struct file *f, const char __user *ubuf,
+			       size_t len, loff_t *off)
+{
+	struct bench_params p;
+	char name[16];
+	int i, ret = -EINVAL;
+
+	if (len >= sizeof(name))
+		return -EINVAL;
+	if (copy_from_user(name, ubuf, len))
+		return -EFAULT;
+	name[len] = '\0';
+
+	/*
+	 * Los ficheros de debugfs se escriben sin bench_lock: se leen una
+	 * sola vez y se valida la copia, que es lo único que ve el run.
+	 */
+	mutex_lock(&bench_lock);
+	p.size       = READ_ONCE(b_size);
+	p.order      = READ_ONCE(b_order);
+	p.batch      = READ_ONCE(b_batch);
+	p.iterations = READ_ONCE(b_iterations);
+	p.threads    = READ_ONCE(b_threads);
+	p.gfp        = READ_ONCE(b_gfp);
+	if (!p.batch || !p.iterations || !p.threads || p.threads > 4 * num_online_cpus() ||
+	    p.gfp >= ARRAY_SIZE(gfp_modes) || !p.size) {
+		mutex_unlock(&bench_lock);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < BENCH__MAX; i++) {
+		if (!sysfs_streq(name, "all") && !sysfs_streq(name, bench_names[i]))
+			continue;
+		ret = bench_run_one(i, &p);
+		if (ret)
+			break;
+	}
+	mutex_unlock(&bench_lock);
+
+	return ret ? ret : len;
+}
+
+static const struct file_operations bench_run_fops = {
+	.owner = THIS_MODULE,
+	.write = bench_run_write,
+};
+
+static int bench_results_show(struct seq_file *m, void *v)
+{
+	int i;
+
+	seq_puts(m, "test        size     order gfp     threads ops        alloc_ns/op free_ns/op Mops/s   fails      fail%\n");
+
+	mutex_lock(&bench_lock);
+	for (i = 0; i < BENCH__MAX; i++) {
+		struct bench_result *r = &results[i];
+		u64 ops = max_t(u64, r->ops, 1);
+		u64 fail_bp = div64_u64(r->fails * 10000, ops);
+
+		if (!r->valid)
+			continue;
+		seq_printf(m, "%-11s %-8u %-5u %-7s %-7u %-10llu %-11llu %-10llu %-8llu %-10llu %llu.%02llu\n",
+			   bench_names[i], r->size, r->order, gfp_names[r->gfp],
+			   r->threads, r->ops,
+			   div64_u64(r->alloc_ns, ops), div64_u64(r->free_ns, ops),
+			   div64_u64(r->ops * 1000, max_t(u64, r->wall_ns, 1)),
+			   r->fails, fail_bp / 100, fail_bp % 100);
+	}
+	mutex_unlock(&bench_lock);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(bench_results);
+
+void alloc_bench_init(struct my_dev *dev)
+{
+	struct dentry *d = debugfs_create_dir("alloc_bench", dev->dbg);
+
+	debugfs_create_u32("size", 0644, d, &b_size);
+	debugfs_create_u32("order", 0644, d, &b_order);
+	debugfs_create_u32("batch", 0644, d, &b_batch);
+	debugfs_create_u32("iterations", 0644, d, &b_iterations);
+	debugfs_create_u32("threads", 0644, d, &b_threads);
+	debugfs_create_u32("gfp", 0644, d, &b_gfp);
+	debugfs_create_file("run", 0200, d, NULL, &bench_run_fops);
+	debugfs_create_file("results", 0444, d, NULL, &bench_results_fops);
+}
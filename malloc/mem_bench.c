@@ -0,0 +1,424 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Benchmark de acceso a memoria según el asignador que dio el buffer.
+ *
+ * /sys/kernel/debug/my_kmalloc_dummy/mem_bench/
+ *   size     bytes del buffer (kmalloc hasta KMALLOC_MAX_SIZE, pages
+ *            hasta el orden máximo del buddy)
+ *   passes   pasadas por patrón
+ *   cpu      CPU donde corre la medición (>= nr_cpu_ids: la actual)
+ *   run      escribir kmalloc, vmalloc, vmalloc_huge, pages, vmalloc_user o all
+ *   results  MB/s de lectura/escritura secuencial y aleatoria, y ns por
+ *            acceso en una persecución de punteros (latencia pura)
+ *
+ * kmalloc y alloc_pages viven en el mapeo lineal (entradas de TLB grandes);
+ * vmalloc usa PTEs de 4 KiB salvo vmalloc_huge, que intenta PMDs.
+ * vmalloc_user es el asignador de big_array, pero con un buffer propio:
+ * big_array está exportado por mmap y no se puede pisar.
+ */
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/mm.h>
+#include <linux/kthread.h>
+#include <linux/completion.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mutex.h>
+
+#include "my_kmalloc.h"
+#include "memacct.h"
+
+#define MB_LINE		64	/* una línea de caché por salto en la persecución */
+
+const char * const mb_buf_names[MB__MAX] = {
+	[MB_KMALLOC]      = "kmalloc",
+	[MB_VMALLOC]      = "vmalloc",
+	[MB_VMALLOC_HUGE] = "vmalloc_huge",
+	[MB_PAGES]        = "pages",
+	[MB_VMALLOC_USER] = "vmalloc_user",
+};
+
+static const char * const mb_pat_names[MB_PAT__MAX] = {
+	[MB_SEQ_READ]  = "seq_read",
+	[MB_SEQ_WRITE] = "seq_write",
+	[MB_RAND_READ] = "rand_read",
+	[MB_CHASE]     = "chase",
+};
+
+struct mb_result {
+	bool valid;
+	size_t size;
+	struct mb_sample s;
+};
+
+static size_t mb_size = 2 * 1024 * 1024;
+static u32 mb_passes = 8;
+static u32 mb_cpu = U32_MAX;
+
+static struct mb_result mb_results[MB__MAX][MB_PAT__MAX];
+static DEFINE_MUTEX(mb_lock);
+static u64 mb_sink;	/* evita que el compilador elimine las lecturas */
+
+/* ---------- núcleos de medición ---------- */
+static u64 mb_seq_read(const u64 *p, size_t n)
+{
+	u64 s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	size_t i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		s0 += p[i];
+		s1 += p[i + 1];
+		s2 += p[i + 2];
+		s3 += p[i + 3];
+	}
+	return s0 + s1 + s2 + s3;
+}
+
+static void mb_seq_write(u64 *p, size_t n, u64 v)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		p[i] = v;
+}
+
+/* Lecturas independientes en posiciones pseudoaleatorias (LCG) */
+static u64 mb_rand_read(const u64 *p, size_t n, u64 count)
+{
+	u64 x = 0x9e3779b97f4a7c15ULL, s = 0;
+
+	while (count--) {
+		x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+		s += p[mul_u64_u64_shr(x >> 32, n, 32)];
+	}
+	return s;
+}
+
+/* Cada línea guarda el índice de la siguiente: cargas dependientes */
+static u32 mb_chase(const u32 *lines, u64 steps)
+{
+	u32 i = 0;
+
+	while (steps--)
+		i = READ_ONCE(lines[(size_t)i * (MB_LINE / sizeof(u32))]);
+	return i;
+}
+
+/* Ciclo único que recorre todas las líneas (algoritmo de Sattolo) */
+static int mb_chase_setup(u32 *lines, size_t nlines)
+{
+	u32 *perm;
+	u64 x = 0x2545f4914f6cdd1dULL;
+	size_t i;
+
+	perm = kvmalloc_array(nlines, sizeof(*perm), GFP_KERNEL);
+	if (!perm)
+		return -ENOMEM;
+
+	for (i = 0; i < nlines; i++)
+		perm[i] = i;
+	for (i = nlines - 1; i > 0; i--) {
+		size_t j;
+
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		j = mul_u64_u64_shr(x >> 32, i, 32);
+		swap(perm[i], perm[j]);
+	}
+	for (i = 0; i < nlines; i++)
+		lines[(size_t)i * (MB_LINE / sizeof(u32))] = perm[i];
+
+	kvfree(perm);
+	return 0;
+}
+
+int mem_bench_measure(void *buf, size_t size, u32 passes,
+		      struct mb_sample out[MB_PAT__MAX])
+{
+	size_t n = size / sizeof(u64);
+	size_t nlines = min_t(size_t, size / MB_LINE, U32_MAX);
+	u64 t0, s = 0;
+	u32 i;
+	int ret;
+
+	if (!n || !nlines || !passes)
+		return -EINVAL;
+
+	/* Calentamiento: páginas y TLB en un estado comparable */
+	mb_seq_write(buf, n, 0);
+
+	t0 = ktime_get_ns();
+	for (i = 0; i < passes; i++)
+		s += mb_seq_read(buf, n);
+	out[MB_SEQ_READ].ns = ktime_get_ns() - t0;
+	out[MB_SEQ_READ].bytes = (u64)n * sizeof(u64) * passes;
+	out[MB_SEQ_READ].accesses = (u64)n * passes;
+
+	t0 = ktime_get_ns();
+	for (i = 0; i < passes; i++)
+		mb_seq_write(buf, n, i);
+	out[MB_SEQ_WRITE].ns = ktime_get_ns() - t0;
+	out[MB_SEQ_WRITE].bytes = out[MB_SEQ_READ].bytes;
+	out[MB_SEQ_WRITE].accesses = out[MB_SEQ_READ].accesses;
+
+	t0 = ktime_get_ns();
+	s += mb_rand_read(buf, n, (u64)n * passes);
+	out[MB_RAND_READ].ns = ktime_get_ns() - t0;
+	out[MB_RAND_READ].bytes = (u64)n * sizeof(u64) * passes;
+	out[MB_RAND_READ].accesses = (u64)n * passes;
+
+	ret = mb_chase_setup(buf, nlines);
+	if (ret)
+		return ret;
+	t0 = ktime_get_ns();
+	s += mb_chase(buf, (u64)nlines * passes);
+	out[MB_CHASE].ns = ktime_get_ns() - t0;
+	out[MB_CHASE].bytes = (u64)nlines * MB_LINE * passes;
+	out[MB_CHASE].accesses = (u64)nlines * passes;
+
+	WRITE_ONCE(mb_sink, s);
+	return 0;
+}
+
+/* ---------- ejecución en una CPU fija ---------- */
+struct mb_job {
+	void *buf;
+	size_t size;
+	u32 passes;
+	int ret;
+	struct mb_sample out[MB_PAT__MAX];
+	struct completion done;
+};
+
+static int mb_thread(void *arg)
+{
+	struct mb_job *job = arg;
+
+	job->ret = mem_bench_measure(job->buf, job->size, job->passes, job->out);
+	complete(&job->done);
+
+	/* Sigue vivo hasta kthread_stop(): job está en la pila del llamador */
+	set_current_state(TASK_INTERRUPTIBLE);
+	while (!kthread_should_stop()) {
+		schedule();
+		set_current_state(TASK_INTERRUPTIBLE);
+	}
+	__set_current_state(TASK_RUNNING);
+	return 0;
+}
+
+int mem_bench_on_cpu(unsigned int cpu, void *buf, size_t size, u32 passes,
+		     struct mb_sample out[MB_PAT__MAX])
+{
+	struct mb_job job = {
+		.buf = buf, .size = size, .passes = passes,
+	};
+	struct task_struct *task;
+
+	if (cpu >= nr_cpu_ids)
+		cpu = raw_smp_processor_id();
+	if (!cpu_online(cpu))
+		return -EINVAL;
+
+	init_completion(&job.done);
+	task = kthread_create_on_cpu(mb_thread, &job, cpu, "kmmem/%u");
+	if (IS_ERR(task))
+		return PTR_ERR(task);
+	wake_up_process(task);
+	wait_for_completion(&job.done);
+	kthread_stop(task);
+
+	memcpy(out, job.out, sizeof(job.out));
+	return job.ret;
+}
+
+/* ---------- buffers de cada asignador ---------- */
+/* nid = NUMA_NO_NODE deja la elección al asignador */
+int mem_bench_alloc(struct my_dev *dev, enum mb_buf kind, size_t size,
+		    int nid, struct mem_bench_buf *b)
+{
+	memset(b, 0, sizeof(*b));
+	b->kind = kind;
+	b->size = size;
+
+	switch (kind) {
+	case MB_KMALLOC:
+		if (size > KMALLOC_MAX_SIZE)
+			return -E2BIG;
+		b->p = kmalloc_node(size, GFP_KERNEL | __GFP_NOWARN, nid);
+		break;
+	case MB_VMALLOC:
+		b->p = vmalloc_node(size, nid);
+		break;
+	case MB_VMALLOC_HUGE:
+		/* No hay variante por nodo exportada */
+		if (nid != NUMA_NO_NODE)
+			return -EOPNOTSUPP;
+		b->p = vmalloc_huge(size, GFP_KERNEL);
+		break;
+	case MB_PAGES:
+		/* Físicamente contiguo; con orden >= PMD queda en una página enorme */
+		b->order = get_order(size);
+		if (b->order >= MAX_ORDER)
+			return -E2BIG;
+		b->page = alloc_pages_node(nid, GFP_KERNEL | __GFP_COMP | __GFP_NOWARN,
+					   b->order);
+		b->p = b->page ? page_address(b->page) : NULL;
+		break;
+	case MB_VMALLOC_USER:
+		/* Como big_array (puesto a cero, mapeable); sin variante por nodo */
+		if (nid != NUMA_NO_NODE)
+			return -EOPNOTSUPP;
+		b->p = vmalloc_user(size);
+		break;
+	default:
+		return -EINVAL;
+	}
+	if (!b->p)
+		return -ENOMEM;
+
+	b->acct = dev->acct_bench;
+	memacct_add(b->acct, b->size);
+	return 0;
+}
+
+/* Páginas del buffer por nodo; counts tiene nr_node_ids entradas */
+void mem_bench_nodes(const void *p, size_t size, unsigned int *counts)
+{
+	size_t off;
+
+	for (off = 0; off < size; off += PAGE_SIZE) {
+		const void *a = p + off;
+		struct page *pg = is_vmalloc_addr(a) ? vmalloc_to_page(a) :
+						       virt_to_page(a);
+
+		if (pg)
+			counts[page_to_nid(pg)]++;
+	}
+}
+
+void mem_bench_free(struct mem_bench_buf *b)
+{
+	switch (b->kind) {
+	case MB_KMALLOC:
+		kfree(b->p);
+		break;
+	case MB_VMALLOC:
+	case MB_VMALLOC_HUGE:
+	case MB_VMALLOC_USER:
+		vfree(b->p);
+		break;
+	case MB_PAGES:
+		if (b->page)
+			__free_pages(b->page, b->order);
+		break;
+	default:
+		break;
+	}
+	if (b->p)
+		memacct_sub(b->acct, b->size);
+	b->p = NULL;
+}
+
+/* ---------- debugfs ---------- */
+static int mb_run_one(struct my_dev *dev, enum mb_buf kind)
+{
+	struct mb_sample out[MB_PAT__MAX];
+	struct mem_bench_buf b;
+	int i, ret;
+
+	ret = mem_bench_alloc(dev, kind, mb_size, NUMA_NO_NODE, &b);
+	if (ret)
+		return ret;
+
+	ret = mem_bench_on_cpu(mb_cpu, b.p, b.size, mb_passes, out);
+	if (!ret) {
+		for (i = 0; i < MB_PAT__MAX; i++) {
+			mb_results[kind][i].valid = true;
+			mb_results[kind][i].size = b.size;
+			mb_results[kind][i].s = out[i];
+		}
+	}
+	mem_bench_free(&b);
+	return ret;
+}
+
+static ssize_t mb_run_write(struct file *f, const char __user *ubuf,
+			    size_t len, loff_t *off)
+{
+	struct my_dev *dev = file_inode(f)->i_private;
+	char name[16];
+	bool all;
+	int i, ret = -EINVAL;
+
+	if (len >= sizeof(name))
+		return -EINVAL;
+	if (copy_from_user(name, ubuf, len))
+		return -EFAULT;
+	name[len] = '\0';
+	all = sysfs_streq(name, "all");
+
+	mutex_lock(&mb_lock);
+	for (i = 0; i < MB__MAX; i++) {
+		if (!all && !sysfs_streq(name, mb_buf_names[i]))
+			continue;
+		ret = mb_run_one(dev, i);
+		/* Con "all" un tamaño fuera de rango para kmalloc/pages no corta */
+		if (all && ret == -E2BIG)
+			ret = 0;
+		if (ret)
+			break;
+	}
+	mutex_unlock(&mb_lock);
+
+	return ret ? ret : len;
+}
+
+static const struct file_operations mb_run_fops = {
+	.owner = THIS_MODULE,
+	.open  = simple_open,
+	.write = mb_run_write,
+};
+
+void mem_bench_print(struct seq_file *m, const char *buf, const char *pat,
+		     const struct mb_sample *s)
+{
+	u64 ns = max_t(u64, s->ns, 1);
+	u64 cns = div64_u64(ns * 100, max_t(u64, s->accesses, 1));
+
+	/* bytes/ns * 1000 = MB/s */
+	seq_printf(m, "%-12s %-10s %-10llu %llu.%02llu\n", buf, pat,
+		   div64_u64(s->bytes * 1000, ns), cns / 100, cns % 100);
+}
+
+static int mb_results_show(struct seq_file *m, void *v)
+{
+	int i, j;
+
+	seq_puts(m, "buffer       pattern    MB/s       ns/acc\n");
+	mutex_lock(&mb_lock);
+	for (i = 0; i < MB__MAX; i++)
+		for (j = 0; j < MB_PAT__MAX; j++)
+			if (mb_results[i][j].valid)
+				mem_bench_print(m, mb_buf_names[i], mb_pat_names[j],
+						&mb_results[i][j].s);
+	mutex_unlock(&mb_lock);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(mb_results);
+
+void mem_bench_init(struct my_dev *dev)
+{
+	struct dentry *d = debugfs_create_dir("mem_bench", dev->dbg);
+
+	debugfs_create_size_t("size", 0644, d, &mb_size);
+	debugfs_create_u32("passes", 0644, d, &mb_passes);
+	debugfs_create_u32("cpu", 0644, d, &mb_cpu);
+	debugfs_create_file("run", 0200, d, dev, &mb_run_fops);
+	debugfs_create_file("results", 0444, d, NULL, &mb_results_fops);
+}
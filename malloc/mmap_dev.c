@@ -0,0 +1,279 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Exporta los buffers de my_dev a user space sin copias.
+ *
+ *   /dev/my_kmalloc_dummy_dma       dma_buf (kmalloc, contiguo)  remap_pfn_range()
+ *   /dev/my_kmalloc_dummy_big       big_array (vmalloc_user)     remap_vmalloc_range()
+ *   /dev/my_kmalloc_dummy_coherent  dma_alloc_coherent()         dma_mmap_coherent()
+ *
+ * Los tres aceptan también read()/write()/lseek() sobre el mismo buffer,
+ * para comparar la copia clásica contra mmap() (ver mmap_bench.c).
+ */
+#include <linux/module.h>
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/io.h>
+#include <linux/vmalloc.h>
+#include <linux/dma-mapping.h>
+#include <linux/miscdevice.h>
+#include <linux/kref.h>
+
+#include "my_kmalloc.h"
+#include "memacct.h"
+
+static unsigned long coherent_size = 1024 * 1024;
+module_param(coherent_size, ulong, 0444);
+MODULE_PARM_DESC(coherent_size, "Bytes del buffer dma_alloc_coherent (0 = no crearlo)");
+
+static const char * const map_names[MY_MAP__MAX] = {
+	[MY_MAP_DMA]      = DRIVER_NAME "_dma",
+	[MY_MAP_BIG]      = DRIVER_NAME "_big",
+	[MY_MAP_COHERENT] = DRIVER_NAME "_coherent",
+};
+
+static struct my_map *to_map(struct file *f)
+{
+	return container_of(f->private_data, struct my_map, misc);
+}
+
+/* El buffer es del map: se libera con la última referencia */
+static void map_free_buf(struct my_map *map)
+{
+	switch (map->kind) {
+	case MY_MAP_DMA:
+		kfree(map->buf);
+		break;
+	case MY_MAP_BIG:
+		vfree(map->buf);
+		break;
+	case MY_MAP_COHERENT:
+		dma_free_coherent(map->dev, map->size, map->buf, map->dma);
+		break;
+	default:
+		break;
+	}
+	memacct_sub(map->acct, map->size);
+	put_device(map->dev);
+}
+
+static void map_release(struct kref *ref)
+{
+	struct my_map *map = container_of(ref, struct my_map, ref);
+
+	map_free_buf(map);
+	memacct_kfree(map->acct, map, sizeof(*map));
+}
+
+static void map_put(struct my_map *map)
+{
+	kref_put(&map->ref, map_release);
+}
+
+/* misc_open() llama aquí con misc_mtx: misc_deregister() aún no ha vuelto */
+static int map_open(struct inode *inode, struct file *f)
+{
+	kref_get(&to_map(f)->ref);
+	return 0;
+}
+
+static int map_file_release(struct inode *inode, struct file *f)
+{
+	map_put(to_map(f));
+	return 0;
+}
+
+static loff_t map_llseek(struct file *f, loff_t off, int whence)
+{
+	return fixed_size_llseek(f, off, whence, to_map(f)->size);
+}
+
+static ssize_t map_read(struct file *f, char __user *ubuf, size_t len,
+			loff_t *ppos)
+{
+	struct my_map *map = to_map(f);
+
+	return simple_read_from_buffer(ubuf, len, ppos, map->buf, map->size);
+}
+
+static ssize_t map_write(struct file *f, const char __user *ubuf, size_t len,
+			 loff_t *ppos)
+{
+	struct my_map *map = to_map(f);
+
+	return simple_write_to_buffer(map->buf, map->size, ppos, ubuf, len);
+}
+
+/* Cada VMA (también las copias de fork() y los trozos de un split) retiene el map */
+static void map_vm_open(struct vm_area_struct *vma)
+{
+	struct my_map *map = vma->vm_private_data;
+
+	kref_get(&map->ref);
+}
+
+static void map_vm_close(struct vm_area_struct *vma)
+{
+	map_put(vma->vm_private_data);
+}
+
+static const struct vm_operations_struct map_vm_ops = {
+	.open  = map_vm_open,
+	.close = map_vm_close,
+};
+
+static int map_mmap(struct file *f, struct vm_area_struct *vma)
+{
+	struct my_map *map = to_map(f);
+	unsigned long len = vma->vm_end - vma->vm_start;
+	unsigned long off = vma->vm_pgoff << PAGE_SHIFT;
+	int ret;
+
+	if (off >= PAGE_ALIGN(map->size) || len > PAGE_ALIGN(map->size) - off)
+		return -EINVAL;
+
+	switch (map->kind) {
+	case MY_MAP_DMA:
+		/* kmalloc(4096) queda alineado a página: una sola PFN contigua */
+		ret = remap_pfn_range(vma, vma->vm_start,
+				      (virt_to_phys(map->buf) >> PAGE_SHIFT) +
+				      vma->vm_pgoff, len, vma->vm_page_prot);
+		break;
+	case MY_MAP_BIG:
+		/* Inserta página a página; exige VM_USERMAP (vmalloc_user) */
+		ret = remap_vmalloc_range(vma, map->buf, vma->vm_pgoff);
+		break;
+	case MY_MAP_COHERENT:
+		ret = dma_mmap_coherent(map->dev, vma, map->buf, map->dma,
+					map->size);
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+	if (ret)
+		return ret;
+
+	/* ->open no se llama para la VMA original */
+	vma->vm_ops = &map_vm_ops;
+	vma->vm_private_data = map;
+	kref_get(&map->ref);
+	return 0;
+}
+
+static const struct file_operations map_fops = {
+	.owner   = THIS_MODULE,
+	.open    = map_open,
+	.release = map_file_release,
+	.llseek  = map_llseek,
+	.read    = map_read,
+	.write   = map_write,
+	.mmap    = map_mmap,
+};
+
+/*
+ * Se queda con buf pase lo que pase: si falla, ya está liberado. La
+ * referencia inicial es del registro; la sueltan mmap_dev_exit() o el error.
+ */
+static int map_register(struct my_dev *dev, struct device *parent,
+			enum my_map_kind kind, void *buf, size_t size,
+			dma_addr_t dma)
+{
+	struct my_map *map;
+	int ret;
+
+	map = memacct_kzalloc(dev->acct_buf, sizeof(*map), GFP_KERNEL);
+	if (!map) {
+		struct my_map tmp = {
+			.kind = kind, .buf = buf, .size = size, .dma = dma,
+			.dev = get_device(parent), .acct = dev->acct_buf,
+		};
+
+		map_free_buf(&tmp);
+		return -ENOMEM;
+	}
+
+	kref_init(&map->ref);
+	map->kind = kind;
+	map->buf = buf;
+	map->size = size;
+	map->dma = dma;
+	map->dev = get_device(parent);
+	map->acct = dev->acct_buf;
+	map->misc.minor = MISC_DYNAMIC_MINOR;
+	map->misc.name = map_names[kind];
+	map->misc.fops = &map_fops;
+	map->misc.parent = parent;
+	map->misc.mode = 0600;
+
+	ret = misc_register(&map->misc);
+	if (ret) {
+		map_put(map);
+		return ret;
+	}
+	dev->maps[kind] = map;
+	return 0;
+}
+
+/*
+ * dma_buf y big_array pasan a los maps, también si esto falla: se
+ * liberan con la última referencia (registro, fd abierto o VMA), que
+ * puede sobrevivir a un unbind por sysfs.
+ */
+int mmap_dev_init(struct my_dev *dev, struct device *parent)
+{
+	dma_addr_t dma = 0;
+	void *buf = NULL;
+	size_t size;
+	int ret;
+
+	ret = map_register(dev, parent, MY_MAP_DMA, dev->dma_buf, 4096, 0);
+	if (ret) {
+		memacct_sub(dev->acct_buf, 2 * 1024 * 1024);
+		vfree(dev->big_array);
+		return ret;
+	}
+	ret = map_register(dev, parent, MY_MAP_BIG, dev->big_array,
+			   2 * 1024 * 1024, 0);
+	if (ret)
+		goto err;
+
+	if (!coherent_size)
+		return 0;
+
+	/* Un platform_device sin DT no trae máscara DMA: se fija una de 32 bits */
+	size = PAGE_ALIGN(coherent_size);
+	ret = dma_coerce_mask_and_coherent(parent, DMA_BIT_MASK(32));
+	if (!ret) {
+		buf = dma_alloc_coherent(parent, size, &dma, GFP_KERNEL);
+		ret = buf ? 0 : -ENOMEM;
+	}
+	if (ret) {
+		/* Opcional: sin DMA coherente el resto sigue funcionando */
+		printk(KERN_WARNING "Sin buffer coherente (%d)\n", ret);
+		return 0;
+	}
+	memacct_add(dev->acct_buf, size);
+
+	ret = map_register(dev, parent, MY_MAP_COHERENT, buf, size, dma);
+	if (ret)
+		goto err;
+	return 0;
+
+err:
+	mmap_dev_exit(dev, parent);
+	return ret;
+}
+
+/* Sin nodos nuevos; los buffers viven mientras quede un fd o un mapeo */
+void mmap_dev_exit(struct my_dev *dev, struct device *parent)
+{
+	int i;
+
+	for (i = 0; i < MY_MAP__MAX; i++) {
+		if (!dev->maps[i])
+			continue;
+		misc_deregister(&dev->maps[i]->misc);
+		map_put(dev->maps[i]);
+		dev->maps[i] = NULL;
+	}
+}
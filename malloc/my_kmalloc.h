@@ -0,0 +1,117 @@
+#ifndef MY_KMALLOC_H
+#define MY_KMALLOC_H
+
+#define DRIVER_NAME "my_kmalloc_dummy"
+
+#include <linux/types.h>
+#include <linux/miscdevice.h>
+#include <linux/kref.h>
+
+struct dentry;
+struct page;
+struct memacct;
+
+/* mmap_dev.c: un char device por buffer exportado */
+enum my_map_kind {
+	MY_MAP_DMA,
+	MY_MAP_BIG,
+	MY_MAP_COHERENT,
+	MY_MAP__MAX
+};
+
+/*
+ * Vive aparte de my_dev: un fd abierto o un mmap() puede durar más que el
+ * dispositivo (unbind por sysfs). Lo retienen el registro, cada fd y cada VMA.
+ */
+struct my_map {
+	struct miscdevice misc;
+	struct kref       ref;
+	enum my_map_kind  kind;
+	void             *buf;
+	size_t            size;		/* alineado a página en COHERENT */
+	dma_addr_t        dma;		/* MY_MAP_COHERENT */
+	struct device    *dev;		/* referencia para dma_free_coherent() */
+	struct memacct   *acct;
+};
+
+struct my_dev {
+	/* 4 KiB contiguos en RAM física —útil para DMA o registros MMIO */
+	void        *dma_buf;
+
+	/* 2 MiB virtuales (pueden estar fragmentados físicamente);
+	 * vmalloc_user() para poder mapearlos en user space */
+	char        *big_array;
+
+	/* /dev/my_kmalloc_dummy_{dma,big,coherent}; dueños de los buffers */
+	struct my_map *maps[MY_MAP__MAX];
+
+	/* /sys/kernel/debug/my_kmalloc_dummy: benchmarks y estado */
+	struct dentry *dbg;
+
+	/* memacct: buffers del dispositivo y buffers de los benchmarks */
+	struct memacct *acct_buf;
+	struct memacct *acct_bench;
+};
+
+struct device;
+
+int  mmap_dev_init(struct my_dev *dev, struct device *parent);
+void mmap_dev_exit(struct my_dev *dev, struct device *parent);
+
+/* alloc_bench.c: microbenchmark de asignadores */
+void alloc_bench_init(struct my_dev *dev);
+
+/* mem_bench.c: ancho de banda y latencia según el asignador */
+enum mb_buf {
+	MB_KMALLOC,
+	MB_VMALLOC,
+	MB_VMALLOC_HUGE,
+	MB_PAGES,
+	MB_VMALLOC_USER,
+	MB__MAX
+};
+
+enum mb_pattern {
+	MB_SEQ_READ,
+	MB_SEQ_WRITE,
+	MB_RAND_READ,
+	MB_CHASE,
+	MB_PAT__MAX
+};
+
+struct mb_sample {
+	u64 ns;
+	u64 bytes;
+	u64 accesses;
+};
+
+struct mem_bench_buf {
+	enum mb_buf  kind;
+	void        *p;
+	size_t       size;
+	struct page *page;	/* MB_PAGES */
+	unsigned int order;
+	struct memacct *acct;
+};
+
+struct seq_file;
+
+extern const char * const mb_buf_names[MB__MAX];
+
+int  mem_bench_alloc(struct my_dev *dev, enum mb_buf kind, size_t size,
+		     int nid, struct mem_bench_buf *b);
+void mem_bench_free(struct mem_bench_buf *b);
+void mem_bench_nodes(const void *p, size_t size, unsigned int *counts);
+int  mem_bench_measure(void *buf, size_t size, u32 passes,
+		       struct mb_sample out[MB_PAT__MAX]);
+int  mem_bench_on_cpu(unsigned int cpu, void *buf, size_t size, u32 passes,
+		      struct mb_sample out[MB_PAT__MAX]);
+void mem_bench_print(struct seq_file *m, const char *buf, const char *pat,
+		     const struct mb_sample *s);
+void mem_bench_init(struct my_dev *dev);
+
+/* numa_bench.c: buffers por nodo/CPU y acceso cruzado entre nodos */
+void numa_bench_init(struct my_dev *dev);
+void numa_bench_exit(struct my_dev *dev);
+
+#endif /* MY_KMALLOC_H */
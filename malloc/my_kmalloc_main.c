@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: GPL-2.0
+#include <linux/module.h>
+#include <linux/platform_device.h>
+#include <linux/vmalloc.h>   /* vmalloc/vfree */
+#include <linux/slab.h>      /* kmalloc/kfree/kzalloc */
+#include <linux/debugfs.h>
+
+#include "my_kmalloc.h"
+#include "memacct.h"
+
+static struct my_dev *pdev_priv;
+static struct memacct *acct_buf, *acct_bench;
+
+/* ---------- Probe: se ejecuta al detectar el dispositivo ---------- */
+static int my_probe(struct platform_device *pdev)
+{
+	int ret = 0;
+
+	/* kzalloc: estructura del dispositivo, inicializada a cero           */
+	pdev_priv = memacct_kzalloc(acct_buf, sizeof(*pdev_priv), GFP_KERNEL);
+	if (!pdev_priv)
+		return -ENOMEM;
+	pdev_priv->acct_buf = acct_buf;
+	pdev_priv->acct_bench = acct_bench;
+
+	/* kmalloc: bloque pequeño y físicamente contiguo (p. ej. para DMA)   */
+	pdev_priv->dma_buf = kmalloc(4096, GFP_KERNEL);      /* 4 KiB */
+	if (!pdev_priv->dma_buf) {
+		ret = -ENOMEM;
+		goto err_free_priv;
+	}
+	memacct_add(acct_buf, 4096);
+
+	/* vmalloc: bloque grande; solo necesita continuidad virtual.
+	 * vmalloc_user() lo pone a cero y lo marca mapeable (VM_USERMAP)     */
+	pdev_priv->big_array = vmalloc_user(2 * 1024 * 1024); /* 2 MiB */
+	if (!pdev_priv->big_array) {
+		ret = -ENOMEM;
+		goto err_free_kmalloc;
+	}
+	memacct_add(acct_buf, 2 * 1024 * 1024);
+
+	/* Desde aquí dma_buf y big_array son de los maps (mmap_dev.c) */
+	ret = mmap_dev_init(pdev_priv, &pdev->dev);
+	if (ret)
+		goto err_free_priv;
+
+	pdev_priv->dbg = debugfs_create_dir(DRIVER_NAME, NULL);
+	alloc_bench_init(pdev_priv);
+	mem_bench_init(pdev_priv);
+	numa_bench_init(pdev_priv);
+
+	printk(KERN_INFO "Buffers asignados con éxito\n");
+	return 0;
+
+err_free_kmalloc:
+	memacct_kfree(acct_buf, pdev_priv->dma_buf, 4096);
+err_free_priv:
+	memacct_kfree(acct_buf, pdev_priv, sizeof(*pdev_priv));
+	return ret;
+}
+
+/* ---------- Remove: se llama al desconectar el dispositivo ---------- */
+static int my_remove(struct platform_device *pdev)
+{
+	/* Espera a que termine cualquier benchmark en curso */
+	debugfs_remove_recursive(pdev_priv->dbg);
+	numa_bench_exit(pdev_priv);
+	/* vfree()/kfree() de big_array y dma_buf con la última referencia */
+	mmap_dev_exit(pdev_priv, &pdev->dev);
+
+	memacct_kfree(acct_buf, pdev_priv, sizeof(*pdev_priv)); /* inverso de kzalloc() */
+	printk(KERN_INFO "Buffers liberados\n");
+	return 0;
+}
+
+static struct platform_driver my_platform_driver = {
+	.probe  = my_probe,
+	.remove = my_remove,
+	.driver = {
+		.name = DRIVER_NAME,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
+	},
+};
+
+static struct platform_device *my_device;
+
+static int __init my_init(void)
+{
+	int ret;
+
+	acct_buf = memacct_register(KBUILD_MODNAME, "buffers");
+	acct_bench = memacct_register(KBUILD_MODNAME, "bench");
+
+	my_device = platform_device_register_simple(DRIVER_NAME, -1, NULL, 0);
+	ret = platform_driver_register(&my_platform_driver);
+	if (ret) {
+		memacct_unregister(acct_bench);
+		memacct_unregister(acct_buf);
+	}
+	return ret;
+}
+
+static void __exit my_exit(void)
+{
+	platform_driver_unregister(&my_platform_driver);
+	platform_device_unregister(my_device);
+	memacct_unregister(acct_bench);
+	memacct_unregister(acct_buf);
+}
+module_init(my_init);
+module_exit(my_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Tu Nombre");
+
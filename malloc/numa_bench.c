@@ -0,0 +1,292 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Colocación NUMA de buffers y coste del acceso entre nodos.
+ *
+ * /sys/kernel/debug/my_kmalloc_dummy/numa/
+ *   size     bytes de cada buffer del conjunto
+ *   passes   pasadas por medición
+ *   alloc    "<asignador> node" un buffer por nodo con memoria,
+ *            "<asignador> cpu"  un buffer por CPU en línea, en su nodo,
+ *            "free" libera el conjunto. Asignador: kmalloc, vmalloc o pages
+ *   buffers  nodo pedido y páginas por nodo donde acabó cada buffer
+ *            (incluye dma_buf y big_array del dispositivo)
+ *   run      mide cada buffer desde la primera CPU de cada nodo
+ *   matrix   MB/s de lectura secuencial y ns por acceso dependiente,
+ *            filas = buffer, columnas = nodo de la CPU que lee
+ *
+ * En QEMU, dos nodos:
+ *   -smp 4 -m 2G -object memory-backend-ram,id=m0,size=1G
+ *   -object memory-backend-ram,id=m1,size=1G
+ *   -numa node,nodeid=0,cpus=0-1,memdev=m0 -numa node,nodeid=1,cpus=2-3,memdev=m1
+ */
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/mm.h>
+#include <linux/nodemask.h>
+#include <linux/topology.h>
+#include <linux/cpu.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+#include <linux/mutex.h>
+#include <linux/math64.h>
+
+#include "my_kmalloc.h"
+
+struct nb_set {
+	struct mem_bench_buf b;
+	int nid;		/* nodo pedido */
+	int cpu;		/* dueño en modo "cpu", -1 en modo "node" */
+};
+
+struct nb_cell {
+	bool valid;
+	u64 mbps;		/* lectura secuencial */
+	u64 chase_cns;		/* centésimas de ns por acceso */
+};
+
+static size_t nb_size = 4 * 1024 * 1024;
+static u32 nb_passes = 4;
+
+static struct nb_set *nb_sets;		/* nr_cpu_ids entradas como máximo */
+static unsigned int nb_nr;
+static struct nb_cell *nb_cells;	/* nb_nr * nr_node_ids */
+static DEFINE_MUTEX(nb_lock);
+
+static void nb_free_sets(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < nb_nr; i++)
+		mem_bench_free(&nb_sets[i].b);
+	kfree(nb_sets);
+	kfree(nb_cells);
+	nb_sets = NULL;
+	nb_cells = NULL;
+	nb_nr = 0;
+}
+
+static int nb_add(struct my_dev *dev, enum mb_buf kind, int nid, int cpu)
+{
+	struct nb_set *s = &nb_sets[nb_nr];
+	int ret;
+
+	ret = mem_bench_alloc(dev, kind, nb_size, nid, &s->b);
+	if (ret)
+		return ret;
+	s->nid = nid;
+	s->cpu = cpu;
+	nb_nr++;
+	return 0;
+}
+
+static int nb_alloc_sets(struct my_dev *dev, enum mb_buf kind, bool per_cpu)
+{
+	unsigned int n = per_cpu ? nr_cpu_ids : nr_node_ids;
+	int nid, cpu, ret = 0;
+
+	nb_free_sets();
+	nb_sets = kcalloc(n, sizeof(*nb_sets), GFP_KERNEL);
+	nb_cells = kcalloc(n * nr_node_ids, sizeof(*nb_cells), GFP_KERNEL);
+	if (!nb_sets || !nb_cells) {
+		nb_free_sets();
+		return -ENOMEM;
+	}
+
+	if (per_cpu) {
+		cpus_read_lock();
+		for_each_online_cpu(cpu) {
+			ret = nb_add(dev, kind, cpu_to_mem(cpu), cpu);
+			if (ret)
+				break;
+		}
+		cpus_read_unlock();
+	} else {
+		for_each_node_state(nid, N_MEMORY) {
+			ret = nb_add(dev, kind, nid, -1);
+			if (ret)
+				break;
+		}
+	}
+
+	if (ret)
+		nb_free_sets();
+	return ret;
+}
+
+static ssize_t nb_alloc_write(struct file *f, const char __user *ubuf,
+			      size_t len, loff_t *off)
+{
+	struct my_dev *dev = file_inode(f)->i_private;
+	char buf[32], name[16], mode[8];
+	int i, ret = -EINVAL;
+
+	if (len >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, len))
+		return -EFAULT;
+	buf[len] = '\0';
+
+	mutex_lock(&nb_lock);
+	if (sysfs_streq(buf, "free")) {
+		nb_free_sets();
+		ret = 0;
+	} else if (sscanf(buf, "%15s %7s", name, mode) == 2 &&
+		   (!strcmp(mode, "node") || !strcmp(mode, "cpu"))) {
+		for (i = 0; i < MB__MAX; i++) {
+			if (!strcmp(name, mb_buf_names[i])) {
+				ret = nb_alloc_sets(dev, i, !strcmp(mode, "cpu"));
+				break;
+			}
+		}
+	}
+	mutex_unlock(&nb_lock);
+
+	return ret ? ret : len;
+}
+
+static const struct file_operations nb_alloc_fops = {
+	.owner = THIS_MODULE,
+	.open  = simple_open,
+	.write = nb_alloc_write,
+};
+
+static void nb_show_nodes(struct seq_file *m, const char *what, int want,
+			  const void *p, size_t size)
+{
+	unsigned int *counts;
+	int nid;
+
+	counts = kcalloc(nr_node_ids, sizeof(*counts), GFP_KERNEL);
+	if (!counts)
+		return;
+	mem_bench_nodes(p, size, counts);
+
+	seq_printf(m, "%-14s %-5d", what, want);
+	for_each_node_state(nid, N_MEMORY)
+		seq_printf(m, " n%d:%u", nid, counts[nid]);
+	seq_putc(m, '\n');
+	kfree(counts);
+}
+
+static int nb_buffers_show(struct seq_file *m, void *v)
+{
+	struct my_dev *dev = m->private;
+	char what[24];
+	unsigned int i;
+
+	seq_puts(m, "buffer         want  pages per node\n");
+	nb_show_nodes(m, "dma_buf", NUMA_NO_NODE, dev->dma_buf, 4096);
+	nb_show_nodes(m, "big_array", NUMA_NO_NODE, dev->big_array,
+		      2 * 1024 * 1024);
+
+	mutex_lock(&nb_lock);
+	for (i = 0; i < nb_nr; i++) {
+		struct nb_set *s = &nb_sets[i];
+
+		if (s->cpu >= 0)
+			snprintf(what, sizeof(what), "%s/cpu%d",
+				 mb_buf_names[s->b.kind], s->cpu);
+		else
+			snprintf(what, sizeof(what), "%s/node%d",
+				 mb_buf_names[s->b.kind], s->nid);
+		nb_show_nodes(m, what, s->nid, s->b.p, s->b.size);
+	}
+	mutex_unlock(&nb_lock);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(nb_buffers);
+
+static ssize_t nb_run_write(struct file *f, const char __user *ubuf,
+			    size_t len, loff_t *off)
+{
+	struct mb_sample out[MB_PAT__MAX];
+	unsigned int i;
+	int nid, cpu, ret = 0;
+
+	mutex_lock(&nb_lock);
+	if (!nb_nr) {
+		ret = -ENODATA;
+		goto out;
+	}
+
+	for (i = 0; i < nb_nr && !ret; i++) {
+		struct nb_set *s = &nb_sets[i];
+
+		for_each_node_state(nid, N_CPU) {
+			struct nb_cell *c = &nb_cells[i * nr_node_ids + nid];
+
+			cpu = cpumask_first(cpumask_of_node(nid));
+			if (cpu >= nr_cpu_ids)
+				continue;
+			ret = mem_bench_on_cpu(cpu, s->b.p, s->b.size,
+					       nb_passes, out);
+			if (ret)
+				break;
+			c->mbps = div64_u64(out[MB_SEQ_READ].bytes * 1000,
+					    max_t(u64, out[MB_SEQ_READ].ns, 1));
+			c->chase_cns = div64_u64(out[MB_CHASE].ns * 100,
+						 max_t(u64, out[MB_CHASE].accesses, 1));
+			c->valid = true;
+		}
+	}
+out:
+	mutex_unlock(&nb_lock);
+	return ret ? ret : len;
+}
+
+static const struct file_operations nb_run_fops = {
+	.owner = THIS_MODULE,
+	.open  = simple_open,
+	.write = nb_run_write,
+};
+
+static int nb_matrix_show(struct seq_file *m, void *v)
+{
+	unsigned int i;
+	int nid;
+
+	seq_puts(m, "buffer         node ");
+	for_each_node_state(nid, N_CPU)
+		seq_printf(m, " cpu@n%-2d MB/s  ns/acc", nid);
+	seq_putc(m, '\n');
+
+	mutex_lock(&nb_lock);
+	for (i = 0; i < nb_nr; i++) {
+		struct nb_set *s = &nb_sets[i];
+
+		seq_printf(m, "%-14s %-5d", mb_buf_names[s->b.kind], s->nid);
+		for_each_node_state(nid, N_CPU) {
+			struct nb_cell *c = &nb_cells[i * nr_node_ids + nid];
+
+			if (c->valid)
+				seq_printf(m, " %12llu %4llu.%02llu", c->mbps,
+					   c->chase_cns / 100, c->chase_cns % 100);
+			else
+				seq_printf(m, " %12s %7s", "-", "-");
+		}
+		seq_putc(m, '\n');
+	}
+	mutex_unlock(&nb_lock);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(nb_matrix);
+
+void numa_bench_init(struct my_dev *dev)
+{
+	struct dentry *d = debugfs_create_dir("numa", dev->dbg);
+
+	debugfs_create_size_t("size", 0644, d, &nb_size);
+	debugfs_create_u32("passes", 0644, d, &nb_passes);
+	debugfs_create_file("alloc", 0200, d, dev, &nb_alloc_fops);
+	debugfs_create_file("buffers", 0444, d, dev, &nb_buffers_fops);
+	debugfs_create_file("run", 0200, d, NULL, &nb_run_fops);
+	debugfs_create_file("matrix", 0444, d, NULL, &nb_matrix_fops);
+}
+
+/* Tras debugfs_remove_recursive(): nadie más toca los conjuntos */
+void numa_bench_exit(struct my_dev *dev)
+{
+	nb_free_sets();
+}
@@ -0,0 +1,276 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * memacct: bytes vivos, pico y asignaciones por módulo y subsistema.
+ *
+ * Las anotaciones van a percpu_counter para no serializar las rutas
+ * calientes; el pico se actualiza con la lectura aproximada del contador
+ * (error máximo MEMACCT_BATCH por CPU) y se corrige con la suma exacta
+ * cada vez que se lee stats.
+ *
+ * Cada módulo lleva además su propio contador vivo y su pico: el del
+ * total no es la suma de los picos de sus subsistemas, que pueden no
+ * haber coincidido en el tiempo.
+ */
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/atomic.h>
+#include <linux/percpu_counter.h>
+#include <linux/device.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+
+#include "memacct.h"
+
+#define MEMACCT_BATCH	(64 * 1024)	/* bytes acumulados por CPU */
+
+/* Suma de los subsistemas de un módulo; vive mientras tenga alguno */
+struct memacct_mod {
+	struct list_head node;
+	const char *module;
+	unsigned int users;		/* struct memacct registrados */
+	struct percpu_counter live;
+	atomic64_t peak;
+};
+
+struct memacct {
+	struct list_head node;
+	struct memacct_mod *mod;
+	const char *module;
+	const char *subsys;
+	struct percpu_counter live;	/* bytes */
+	struct percpu_counter allocs;
+	struct percpu_counter frees;
+	atomic64_t peak;
+};
+
+static LIST_HEAD(memacct_list);
+static LIST_HEAD(memacct_mods);
+static DEFINE_MUTEX(memacct_lock);	/* las dos listas y users */
+static struct dentry *memacct_dir;
+
+static void memacct_peak(atomic64_t *peak, s64 live)
+{
+	s64 old = atomic64_read(peak);
+
+	while (live > old && !atomic64_try_cmpxchg(peak, &old, live))
+		;
+}
+
+void memacct_add(struct memacct *ma, size_t bytes)
+{
+	if (!ma)
+		return;
+	percpu_counter_add_batch(&ma->live, bytes, MEMACCT_BATCH);
+	percpu_counter_add_batch(&ma->mod->live, bytes, MEMACCT_BATCH);
+	percpu_counter_inc(&ma->allocs);
+	memacct_peak(&ma->peak, percpu_counter_read_positive(&ma->live));
+	memacct_peak(&ma->mod->peak, percpu_counter_read_positive(&ma->mod->live));
+}
+EXPORT_SYMBOL_GPL(memacct_add);
+
+void memacct_sub(struct memacct *ma, size_t bytes)
+{
+	if (!ma)
+		return;
+	percpu_counter_add_batch(&ma->live, -(s64)bytes, MEMACCT_BATCH);
+	percpu_counter_add_batch(&ma->mod->live, -(s64)bytes, MEMACCT_BATCH);
+	percpu_counter_inc(&ma->frees);
+}
+EXPORT_SYMBOL_GPL(memacct_sub);
+
+/* ---------- devm ---------- */
+struct memacct_devm {
+	struct memacct *ma;
+	size_t size;
+};
+
+static void memacct_devm_release(void *data)
+{
+	struct memacct_devm *rec = data;
+
+	memacct_sub(rec->ma, rec->size);
+}
+
+/*
+ * El registro va al final del mismo bloque devres; la acción se añade
+ * después de la asignación, así que devres la ejecuta antes de liberarlo.
+ */
+void *memacct_devm_kzalloc(struct memacct *ma, struct device *dev,
+			   size_t size, gfp_t gfp)
+{
+	size_t off = ALIGN(size, sizeof(long));
+	struct memacct_devm *rec;
+	void *p;
+
+	if (!ma)
+		return devm_kzalloc(dev, size, gfp);
+
+	p = devm_kzalloc(dev, off + sizeof(*rec), gfp);
+	if (!p)
+		return NULL;
+
+	rec = p + off;
+	rec->ma = ma;
+	rec->size = size;
+	memacct_add(ma, size);
+	if (devm_add_action_or_reset(dev, memacct_devm_release, rec))
+		return NULL;	/* ya descontado; devres libera p */
+	return p;
+}
+EXPORT_SYMBOL_GPL(memacct_devm_kzalloc);
+
+/* ---------- registro ---------- */
+
+/* Con memacct_lock: el del módulo, creado con el primer subsistema */
+static struct memacct_mod *memacct_mod_get(const char *module)
+{
+	struct memacct_mod *mod;
+
+	list_for_each_entry(mod, &memacct_mods, node) {
+		if (!strcmp(mod->module, module)) {
+			mod->users++;
+			return mod;
+		}
+	}
+
+	mod = kzalloc(sizeof(*mod), GFP_KERNEL);
+	if (!mod)
+		return NULL;
+	if (percpu_counter_init(&mod->live, 0, GFP_KERNEL)) {
+		kfree(mod);
+		return NULL;
+	}
+	mod->module = module;
+	mod->users = 1;
+	atomic64_set(&mod->peak, 0);
+	list_add_tail(&mod->node, &memacct_mods);
+	return mod;
+}
+
+static void memacct_mod_put(struct memacct_mod *mod)
+{
+	if (--mod->users)
+		return;
+	list_del(&mod->node);
+	percpu_counter_destroy(&mod->live);
+	kfree(mod);
+}
+
+struct memacct *memacct_register(const char *module, const char *subsys)
+{
+	struct memacct *ma;
+
+	ma = kzalloc(sizeof(*ma), GFP_KERNEL);
+	if (!ma)
+		return NULL;
+
+	ma->module = module;
+	ma->subsys = subsys;
+	atomic64_set(&ma->peak, 0);
+	if (percpu_counter_init(&ma->live, 0, GFP_KERNEL))
+		goto err_free;
+	if (percpu_counter_init(&ma->allocs, 0, GFP_KERNEL))
+		goto err_live;
+	if (percpu_counter_init(&ma->frees, 0, GFP_KERNEL))
+		goto err_allocs;
+
+	mutex_lock(&memacct_lock);
+	ma->mod = memacct_mod_get(module);
+	if (!ma->mod) {
+		mutex_unlock(&memacct_lock);
+		goto err_frees;
+	}
+	list_add_tail(&ma->node, &memacct_list);
+	mutex_unlock(&memacct_lock);
+	return ma;
+
+err_frees:
+	percpu_counter_destroy(&ma->frees);
+err_allocs:
+	percpu_counter_destroy(&ma->allocs);
+err_live:
+	percpu_counter_destroy(&ma->live);
+err_free:
+	kfree(ma);
+	return NULL;
+}
+EXPORT_SYMBOL_GPL(memacct_register);
+
+void memacct_unregister(struct memacct *ma)
+{
+	s64 live;
+
+	if (!ma)
+		return;
+
+	/* Lo que quede vivo al descargar es una fuga; sale del total del módulo */
+	live = percpu_counter_sum(&ma->live);
+	if (live)
+		pr_warn("memacct: %s/%s deja %lld bytes sin liberar\n",
+			ma->module, ma->subsys, live);
+	percpu_counter_add(&ma->mod->live, -live);
+
+	mutex_lock(&memacct_lock);
+	list_del(&ma->node);
+	memacct_mod_put(ma->mod);
+	mutex_unlock(&memacct_lock);
+
+	percpu_counter_destroy(&ma->frees);
+	percpu_counter_destroy(&ma->allocs);
+	percpu_counter_destroy(&ma->live);
+	kfree(ma);
+}
+EXPORT_SYMBOL_GPL(memacct_unregister);
+
+/* ---------- debugfs ---------- */
+static int memacct_stats_show(struct seq_file *m, void *v)
+{
+	struct memacct_mod *mod;
+	struct memacct *ma;
+	s64 live;
+
+	seq_printf(m, "%-24s %-12s %12s %12s %10s %10s\n",
+		   "module", "subsys", "live", "peak", "allocs", "frees");
+
+	mutex_lock(&memacct_lock);
+	list_for_each_entry(ma, &memacct_list, node) {
+		live = percpu_counter_sum(&ma->live);
+		memacct_peak(&ma->peak, live);
+		seq_printf(m, "%-24s %-12s %12lld %12lld %10lld %10lld\n",
+			   ma->module, ma->subsys, live, atomic64_read(&ma->peak),
+			   percpu_counter_sum(&ma->allocs),
+			   percpu_counter_sum(&ma->frees));
+	}
+
+	/* Totales por módulo, con su propio pico */
+	seq_putc(m, '\n');
+	list_for_each_entry(mod, &memacct_mods, node) {
+		live = percpu_counter_sum(&mod->live);
+		memacct_peak(&mod->peak, live);
+		seq_printf(m, "%-24s %-12s %12lld %12lld\n", mod->module, "total",
+			   live, atomic64_read(&mod->peak));
+	}
+	mutex_unlock(&memacct_lock);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(memacct_stats);
+
+static int __init memacct_init(void)
+{
+	memacct_dir = debugfs_create_dir("memacct", NULL);
+	debugfs_create_file("stats", 0444, memacct_dir, NULL, &memacct_stats_fops);
+	return 0;
+}
+
+static void __exit memacct_exit(void)
+{
+	debugfs_remove_recursive(memacct_dir);
+}
+
+module_init(memacct_init);
+module_exit(memacct_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Contabilidad de memoria por módulo y subsistema");
@@ -0,0 +1,65 @@
+#ifndef MEMACCT_H
+#define MEMACCT_H
+
+/*
+ * Contabilidad de memoria compartida por los módulos del repo.
+ *
+ * Cada módulo registra un contador por subsistema (p. ej. "ctx", "lookup")
+ * y anota lo que asigna y libera. memacct.ko lleva bytes vivos, pico y
+ * número de asignaciones/liberaciones con contadores por CPU, y lo muestra
+ * en /sys/kernel/debug/memacct/stats.
+ *
+ * Todas las funciones aceptan ma == NULL (registro fallido) y no hacen nada.
+ */
+#include <linux/types.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+
+struct device;
+struct memacct;
+
+struct memacct *memacct_register(const char *module, const char *subsys);
+void memacct_unregister(struct memacct *ma);
+
+void memacct_add(struct memacct *ma, size_t bytes);
+void memacct_sub(struct memacct *ma, size_t bytes);
+
+/* devm_kzalloc() que se descuenta solo cuando devres libera el bloque */
+void *memacct_devm_kzalloc(struct memacct *ma, struct device *dev,
+			   size_t size, gfp_t gfp);
+
+static inline void *memacct_devm_kcalloc(struct memacct *ma, struct device *dev,
+					 size_t n, size_t size, gfp_t gfp)
+{
+	size_t bytes = size_mul(n, size);
+
+	return bytes == SIZE_MAX ? NULL : memacct_devm_kzalloc(ma, dev, bytes, gfp);
+}
+
+static inline void *memacct_kzalloc(struct memacct *ma, size_t size, gfp_t gfp)
+{
+	void *p = kzalloc(size, gfp);
+
+	if (p)
+		memacct_add(ma, size);
+	return p;
+}
+
+static inline void memacct_kfree(struct memacct *ma, const void *p, size_t size)
+{
+	if (p)
+		memacct_sub(ma, size);
+	kfree(p);
+}
+
+static inline void *memacct_memdup_user(struct memacct *ma,
+					const void __user *src, size_t len)
+{
+	void *p = memdup_user(src, len);
+
+	if (!IS_ERR(p))
+		memacct_add(ma, len);
+	return p;
+}
+
+#endif /* MEMACCT_H */
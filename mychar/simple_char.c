@@ -27,16 +27,28 @@ static int sc_release(struct inode *inode, struct file *filp)
 	return 0;
 }
 
+/* Bytes que entrega un read() de len bytes en offset (0 = EOF) */
+static size_t sc_read_span(loff_t offset, size_t len)
+{
+	if (offset < 0 || offset >= sc_len)
+		return 0;
+	return min(len, sc_len - (size_t)offset);
+}
+
+/* Bytes que acepta un write(): lo que cabe en el buffer */
+static size_t sc_write_span(size_t len)
+{
+	return min(len, (size_t)BUF_SIZE);
+}
+
 static ssize_t sc_read(struct file *filp, char __user *ubuf,
                        size_t len, loff_t *offset)
 {
-	size_t to_copy;
+	size_t to_copy = sc_read_span(*offset, len);
 
-	if (*offset >= sc_len)      /* EOF */
+	if (!to_copy)               /* EOF */
 		return 0;
 
-	to_copy = min(len, sc_len - (size_t)*offset);
-
 	if (copy_to_user(ubuf, sc_buffer + *offset, to_copy))
 		return -EFAULT;
 
@@ -47,7 +59,7 @@ static ssize_t sc_read(struct file *filp, char __user *ubuf,
 static ssize_t sc_write(struct file *filp, const char __user *ubuf,
                         size_t len, loff_t *offset)
 {
-	size_t to_copy = min(len, (size_t)BUF_SIZE);
+	size_t to_copy = sc_write_span(len);
 
 	if (copy_from_user(sc_buffer, ubuf, to_copy))
 		return -EFAULT;
@@ -124,5 +136,9 @@ static void __exit sc_exit(void)
 
 module_init(sc_init);
 module_exit(sc_exit);
+#ifdef MY_KUNIT
+#include "simple_char_kunit.c"
+#endif
+
 MODULE_AUTHOR("Ejemplo");
 MODULE_LICENSE("GPL");
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * KUnit: offsets de lectura/escritura de simple_char.
+ * Se incluye al final de simple_char.c con "make KUNIT=1".
+ */
+#include "kbench.h"
+
+/* Guarda y restaura el buffer global por si el dispositivo está en uso */
+struct sc_test_ctx {
+	char buf[BUF_SIZE];
+	size_t len;
+};
+
+static int sc_test_init(struct kunit *test)
+{
+	struct sc_test_ctx *c = kunit_kzalloc(test, sizeof(*c), GFP_KERNEL);
+
+	if (!c)
+		return -ENOMEM;
+	memcpy(c->buf, sc_buffer, BUF_SIZE);
+	c->len = sc_len;
+	test->priv = c;
+	return 0;
+}
+
+static void sc_test_exit(struct kunit *test)
+{
+	struct sc_test_ctx *c = test->priv;
+
+	memcpy(sc_buffer, c->buf, BUF_SIZE);
+	sc_len = c->len;
+}
+
+static void sc_test_write_span(struct kunit *test)
+{
+	KUNIT_EXPECT_EQ(test, sc_write_span(0), (size_t)0);
+	KUNIT_EXPECT_EQ(test, sc_write_span(10), (size_t)10);
+	KUNIT_EXPECT_EQ(test, sc_write_span(BUF_SIZE), (size_t)BUF_SIZE);
+	KUNIT_EXPECT_EQ(test, sc_write_span(BUF_SIZE + 1), (size_t)BUF_SIZE);
+	KUNIT_EXPECT_EQ(test, sc_write_span(SIZE_MAX), (size_t)BUF_SIZE);
+}
+
+static void sc_test_read_chunks(struct kunit *test)
+{
+	loff_t off = 0;
+	size_t n;
+
+	sc_len = BUF_SIZE;
+
+	/* Lecturas de 100 en 100 hasta EOF, como haría cat */
+	n = sc_read_span(off, 100);
+	KUNIT_EXPECT_EQ(test, n, (size_t)100);
+	off += n;
+	n = sc_read_span(off, 100);
+	KUNIT_EXPECT_EQ(test, n, (size_t)100);
+	off += n;
+	n = sc_read_span(off, 100);
+	KUNIT_EXPECT_EQ(test, n, (size_t)(BUF_SIZE - 200));
+	off += n;
+	KUNIT_EXPECT_EQ(test, sc_read_span(off, 100), (size_t)0);
+}
+
+static void sc_test_read_bounds(struct kunit *test)
+{
+	sc_len = 10;
+	KUNIT_EXPECT_EQ(test, sc_read_span(0, 0), (size_t)0);
+	KUNIT_EXPECT_EQ(test, sc_read_span(9, 100), (size_t)1);
+	KUNIT_EXPECT_EQ(test, sc_read_span(10, 100), (size_t)0);
+	KUNIT_EXPECT_EQ(test, sc_read_span(-1, 100), (size_t)0);
+	KUNIT_EXPECT_EQ(test, sc_read_span(LLONG_MAX, 100), (size_t)0);
+
+	sc_len = 0;
+	KUNIT_EXPECT_EQ(test, sc_read_span(0, 100), (size_t)0);
+}
+
+static void sc_bench_read(struct kunit *test)
+{
+	char *dst = kunit_kzalloc(test, BUF_SIZE, GFP_KERNEL);
+	size_t n;
+
+	KUNIT_ASSERT_NOT_NULL(test, dst);
+	sc_len = BUF_SIZE;
+
+	/* Ruta de read() sin la copia a user space: span + copia del buffer */
+	KBENCH(test, "read span+copy 256B", 100000, 60, {
+		n = sc_read_span(0, BUF_SIZE);
+		memcpy(dst, sc_buffer, n);
+		OPTIMIZER_HIDE_VAR(dst);
+	});
+}
+
+static struct kunit_case sc_test_cases[] = {
+	KUNIT_CASE(sc_test_write_span),
+	KUNIT_CASE(sc_test_read_chunks),
+	KUNIT_CASE(sc_test_read_bounds),
+	KUNIT_CASE(sc_bench_read),
+	{}
+};
+
+static struct kunit_suite sc_test_suite = {
+	.name = "simple_char",
+	.init = sc_test_init,
+	.exit = sc_test_exit,
+	.test_cases = sc_test_cases,
+};
+kunit_test_suite(sc_test_suite);
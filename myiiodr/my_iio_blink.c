@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Puente IIO -> blinkers: los eventos de umbral de my_iio_dummy cambian el
+ * periodo de un blinker por blink_api.h, sin pasar por userspace.
+ *
+ * Los símbolos se resuelven con symbol_get() en cada evento: my_iio_dummy
+ * carga sin los módulos de blink, y mientras no haya evento en curso no
+ * retiene referencias que impidan descargarlos.
+ *
+ * El setter no corre en el camino de muestreo (bajo st->lock): el evento
+ * anota la dirección y la hora y despierta un kthread_worker propio en
+ * SCHED_FIFO, que no espera turno tras otros works del sistema. Si llegan
+ * varios antes de que corra, gana el último. lat_us_last/lat_us_max dan
+ * lo que tarda del evento a la vuelta del setter.
+ */
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/kthread.h>
+#include <linux/sched.h>
+#include <linux/ktime.h>
+
+#include "blink_api.h"
+#include "blink_ioctl.h"
+#include "my_iio_blink.h"
+
+static int alarm_blink_id = -1;
+module_param(alarm_blink_id, int, 0644);
+MODULE_PARM_DESC(alarm_blink_id, "BLINK_ID_* que reacciona a los eventos (-1: puente apagado).");
+
+static int alarm_channel = -1;
+module_param(alarm_channel, int, 0644);
+MODULE_PARM_DESC(alarm_channel, "Canal que dispara el puente (-1: cualquiera).");
+
+static unsigned int alarm_ms = 100;
+module_param(alarm_ms, uint, 0644);
+MODULE_PARM_DESC(alarm_ms, "Periodo al cruzar el umbral de subida.");
+
+static unsigned int normal_ms = 500;
+module_param(normal_ms, uint, 0644);
+MODULE_PARM_DESC(normal_ms, "Periodo al cruzar el umbral de bajada.");
+
+static int my_iio_blink_set(int id, unsigned int ms)
+{
+	int (*set)(unsigned int ms);
+	int ret;
+
+	switch (id) {
+	case BLINK_ID_KTHREAD:
+		set = symbol_get(kthread_blink_nodt_set_period);
+		if (!set)
+			return -ENODEV;
+		ret = set(ms);
+		symbol_put(kthread_blink_nodt_set_period);
+		return ret;
+	case BLINK_ID_TIMER:
+		set = symbol_get(timer_blink_nodt_set_period);
+		if (!set)
+			return -ENODEV;
+		ret = set(ms);
+		symbol_put(timer_blink_nodt_set_period);
+		return ret;
+	case BLINK_ID_HRTIMER:
+		set = symbol_get(hrtimer_blink_nodt_set_period);
+		if (!set)
+			return -ENODEV;
+		ret = set(ms);
+		symbol_put(hrtimer_blink_nodt_set_period);
+		return ret;
+	default:
+		return -EINVAL;
+	}
+}
+
+static unsigned long lat_us_last;
+module_param(lat_us_last, ulong, 0444);
+MODULE_PARM_DESC(lat_us_last, "Evento de umbral -> setter del blinker, último (us).");
+
+static unsigned long lat_us_max;
+module_param(lat_us_max, ulong, 0444);
+MODULE_PARM_DESC(lat_us_max, "Evento de umbral -> setter del blinker, máximo (us).");
+
+static enum iio_event_direction my_iio_blink_dir;
+static ktime_t my_iio_blink_t0;
+static struct kthread_worker *my_iio_blink_worker;
+
+static void my_iio_blink_fn(struct kthread_work *w)
+{
+	int id = READ_ONCE(alarm_blink_id);
+	bool rising = READ_ONCE(my_iio_blink_dir) == IIO_EV_DIR_RISING;
+	unsigned long us;
+	int ret;
+
+	if (id < 0)
+		return;
+	ret = my_iio_blink_set(id, rising ? READ_ONCE(alarm_ms) : READ_ONCE(normal_ms));
+	if (ret)
+		pr_warn_ratelimited("my_iio_dummy: blink id=%d: %d\n", id, ret);
+
+	us = ktime_us_delta(ktime_get(), READ_ONCE(my_iio_blink_t0));
+	WRITE_ONCE(lat_us_last, us);
+	if (us > lat_us_max)
+		WRITE_ONCE(lat_us_max, us);
+}
+
+static DEFINE_KTHREAD_WORK(my_iio_blink_work, my_iio_blink_fn);
+
+/* Se llama desde el camino de muestreo, con st->lock */
+void my_iio_blink_event(unsigned int channel, enum iio_event_direction dir)
+{
+	int id = READ_ONCE(alarm_blink_id);
+	int ch = READ_ONCE(alarm_channel);
+
+	if (id < 0 || (ch >= 0 && channel != ch))
+		return;
+	if (dir != IIO_EV_DIR_RISING && dir != IIO_EV_DIR_FALLING)
+		return;
+
+	WRITE_ONCE(my_iio_blink_dir, dir);
+	WRITE_ONCE(my_iio_blink_t0, ktime_get());
+	kthread_queue_work(my_iio_blink_worker, &my_iio_blink_work);
+}
+
+/* Antes de registrar el dispositivo: el primer evento ya tiene worker */
+int my_iio_blink_init(void)
+{
+	my_iio_blink_worker = kthread_create_worker(0, "my_iio_blink");
+	if (IS_ERR(my_iio_blink_worker))
+		return PTR_ERR(my_iio_blink_worker);
+	sched_set_fifo_low(my_iio_blink_worker->task);
+	return 0;
+}
+
+/* Sin dispositivo ya no hay eventos: descarta el pendiente y espera al que corre */
+void my_iio_blink_exit(void)
+{
+	kthread_cancel_work_sync(&my_iio_blink_work);
+	kthread_destroy_worker(my_iio_blink_worker);
+}
@@ -0,0 +1,10 @@
+#ifndef MY_IIO_BLINK_H
+#define MY_IIO_BLINK_H
+
+#include <linux/iio/types.h>
+
+void my_iio_blink_event(unsigned int channel, enum iio_event_direction dir);
+int my_iio_blink_init(void);
+void my_iio_blink_exit(void);
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef MY_IIO_DUMMY_H
+#define MY_IIO_DUMMY_H
+
+#include <linux/types.h>   /* __u32, __s64 ... en kernel y en user space */
+#ifdef __KERNEL__
+# include <linux/ioctl.h>
+#else
+# include <sys/ioctl.h>
+#endif
+
+/*
+ * Inyección binaria por /dev/my_iio_dummy_inject.
+ *
+ * Cada write() lleva uno o más bloques completos. Un bloque es esta
+ * cabecera seguida de num_scans * num_channels valores __s32, scan por
+ * scan (canal 0 primero). El scan k lleva el timestamp t0_ns + k * period_ns.
+ * Los bloques deben llegar en orden de timestamp dentro de un mismo open().
+ * Un bloque entra entero o no entra: un write() corto (señal, O_NONBLOCK)
+ * acaba siempre en un límite de bloque, y un bucle de reintento normal
+ * reenvía el resto tal cual. num_scans no puede pasar del tamaño del
+ * anillo (parámetro inject_ring_scans, redondeado a potencia de dos).
+ */
+#define MY_IIO_INJECT_MAGIC  0x494a4e31   /* "IJN1" */
+
+struct my_iio_inject_block {
+    __u32 magic;         /* MY_IIO_INJECT_MAGIC */
+    __u16 num_channels;  /* canales por scan (1..canales del dispositivo) */
+    __u16 num_scans;     /* scans en el bloque (>=1) */
+    __s64 t0_ns;         /* timestamp del primer scan, base libre */
+    __u32 period_ns;     /* separación entre scans del bloque */
+    __u32 reserved;      /* 0 */
+    /* __s32 data[num_scans][num_channels]; */
+};
+
+/*
+ * Buffer de bloques por /dev/my_iio_dummy_blocks (sin copias).
+ *
+ * ALLOC reserva count bloques de size bytes en una sola área que se mapea
+ * con mmap() usando block.offset. Los bloques se encolan vacíos con ENQUEUE;
+ * mientras el buffer IIO está habilitado el driver escribe los scans directo
+ * en ellos (todos los canales + timestamp, con el layout de scan_elements) y
+ * los devuelve llenos por DEQUEUE. poll() da EPOLLIN cuando hay bloques
+ * llenos. Un bloque nunca parte un scan: bytes_used es múltiplo del scan.
+ */
+#define MY_IIO_BLOCK_MAX_COUNT  32
+
+struct my_iio_block_alloc_req {
+    __u32 type;          /* 0 */
+    __u32 size;          /* bytes por bloque */
+    __u32 count;         /* bloques; el driver puede devolver menos */
+    __u32 id;            /* reservado */
+};
+
+#define MY_IIO_BLOCK_FLAG_OVERRUN  (1 << 0)   /* se perdieron scans antes */
+
+struct my_iio_block {
+    __u32 id;
+    __u32 size;          /* capacidad en bytes */
+    __u32 bytes_used;    /* bytes válidos (DEQUEUE) */
+    __u32 flags;         /* MY_IIO_BLOCK_FLAG_* */
+    __u64 offset;        /* para mmap() */
+    __s64 timestamp;     /* timestamp del primer scan */
+};
+
+#define MY_IIO_BLOCK_MAGIC  'i'
+
+#define MY_IIO_BLOCK_ALLOC    _IOWR(MY_IIO_BLOCK_MAGIC, 0xa0, struct my_iio_block_alloc_req)
+#define MY_IIO_BLOCK_FREE     _IO  (MY_IIO_BLOCK_MAGIC, 0xa1)
+#define MY_IIO_BLOCK_QUERY    _IOWR(MY_IIO_BLOCK_MAGIC, 0xa2, struct my_iio_block)
+#define MY_IIO_BLOCK_ENQUEUE  _IOWR(MY_IIO_BLOCK_MAGIC, 0xa3, struct my_iio_block)
+#define MY_IIO_BLOCK_DEQUEUE  _IOWR(MY_IIO_BLOCK_MAGIC, 0xa4, struct my_iio_block)
+
+#endif /* MY_IIO_DUMMY_H */
@@ -0,0 +1,658 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Contador de pulsos / frecuencímetro IIO sobre líneas GPIO de entrada.
+ *
+ * Cada línea pide una IRQ por ambos flancos. El handler sella el flanco
+ * con ktime_get_ns() y lo acumula en una ventana; cada scan (trigger propio
+ * a sampling_frequency) o lectura directa cierra la ventana y da, por línea:
+ *   in_countN_pulses_raw   flancos de subida acumulados
+ *   in_countN_freq_raw     frecuencia media de la ventana, mHz
+ *   in_countN_period_raw   periodo medio, ns
+ *   in_countN_duty_raw     ciclo útil, ppm
+ * La ventana dura hasta tener dos subidas, así una señal más lenta que los
+ * scans conserva la última medida en vez de caer a 0.
+ *
+ * Con buffer/watermark el lector despierta por lotes de scans.
+ *
+ * Lazo cerrado con un blinker: cablear su salida a una de estas entradas y
+ *   insmod my_iio_pulse.ko chip=<gpiochip> lines=24,25 check_blink_id=2
+ *   cat /sys/bus/iio/devices/iio:deviceN/blink_check
+ * En gpio-sim las entradas se mueven con sim_gpioN/pull.
+ */
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/platform_device.h>
+#include <linux/gpio/consumer.h>
+#include <linux/gpio/machine.h>
+#include <linux/interrupt.h>
+#include <linux/iio/iio.h>
+#include <linux/iio/buffer.h>
+#include <linux/iio/sysfs.h>
+#include <linux/iio/trigger.h>
+#include <linux/iio/trigger_consumer.h>
+#include <linux/iio/triggered_buffer.h>
+#include <linux/hrtimer.h>
+#include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/math64.h>
+
+#include "blink_api.h"
+#include "blink_ioctl.h"
+#include "memacct.h"
+
+#define DRIVER_NAME "my_iio_pulse"
+
+#define MY_PULSE_MAX_LINES	4
+#define MY_PULSE_MAX_FREQ	1000		/* Hz de scan */
+
+enum my_pulse_val {
+	MY_PULSE_COUNT,
+	MY_PULSE_FREQ,
+	MY_PULSE_PERIOD,
+	MY_PULSE_DUTY,
+	MY_PULSE_VALS
+};
+
+static const char * const my_pulse_val_names[MY_PULSE_VALS] = {
+	[MY_PULSE_COUNT]  = "pulses",
+	[MY_PULSE_FREQ]   = "freq",
+	[MY_PULSE_PERIOD] = "period",
+	[MY_PULSE_DUTY]   = "duty",
+};
+
+static char *chip = (char *)"pinctrl-bcm2711";
+module_param(chip, charp, 0444);
+MODULE_PARM_DESC(chip, "Etiqueta del gpiochip de las entradas.");
+
+static int lines[MY_PULSE_MAX_LINES] = { 24, 25 };
+static int nr_lines = 2;
+module_param_array(lines, int, &nr_lines, 0444);
+MODULE_PARM_DESC(lines, "Líneas de entrada, hasta 4 (p. ej. lines=24,25).");
+
+static int check_blink_id = -1;
+module_param(check_blink_id, int, 0644);
+MODULE_PARM_DESC(check_blink_id, "BLINK_ID_* a comparar en blink_check (-1: apagado).");
+
+static unsigned int check_line;
+module_param(check_line, uint, 0644);
+MODULE_PARM_DESC(check_line, "Entrada cableada a la salida del blinker.");
+
+static struct memacct *acct_ctx, *acct_lookup;
+static struct gpiod_lookup_table *lt;
+static size_t lt_size;
+
+struct my_pulse_line {
+	struct gpio_desc *gpio;
+	bool can_sleep;			/* IRQ en hilo, nivel con _cansleep */
+	raw_spinlock_t lock;		/* handler de IRQ frente a scans */
+	int level;
+	u64 rise;			/* última subida, ns */
+	u32 pulses;
+	u64 edges;
+	u64 missed;			/* dos flancos seguidos del mismo nivel */
+
+	/* ventana en curso */
+	u64 w_first, w_last;		/* primera y última subida */
+	u32 w_rises;
+	u64 w_high;			/* tiempo en alto de pulsos completos */
+	u32 w_highs;
+
+	/* último cierre de ventana */
+	u32 freq_mhz;
+	u32 period_ns;
+	u32 duty_ppm;
+};
+
+struct my_pulse_state {
+	struct iio_dev *indio_dev;
+	struct mutex lock;		/* samp_freq */
+	unsigned int nlines;
+	struct my_pulse_line line[MY_PULSE_MAX_LINES];
+	unsigned int samp_freq;
+	ktime_t tick;
+	struct hrtimer timer;
+	struct iio_trigger *trig;
+	unsigned long scan_masks[2];
+	struct {
+		u32 v[MY_PULSE_MAX_LINES * MY_PULSE_VALS];
+		s64 ts __aligned(8);
+	} scan;
+};
+
+/*
+ * Un flanco, con l->lock. level es el nivel tras el flanco. Si llegan dos
+ * del mismo nivel se perdió uno entre medias: la subida cuenta igual, pero
+ * ese pulso no entra en el ciclo útil.
+ */
+static void my_pulse_edge(struct my_pulse_line *l, int level, u64 ts)
+{
+	int prev = l->level;
+
+	l->edges++;
+	if (level == prev)
+		l->missed++;
+	l->level = level;
+
+	if (level) {
+		l->pulses++;
+		if (!l->w_rises)
+			l->w_first = ts;
+		l->w_last = ts;
+		l->w_rises++;
+		l->rise = ts;
+	} else if (prev && l->rise && ts > l->rise) {
+		l->w_high += ts - l->rise;
+		l->w_highs++;
+	}
+}
+
+/*
+ * Cierra la ventana, con l->lock. La siguiente arranca en la última
+ * subida: ningún periodo se queda sin contar. Sin subidas en dos periodos
+ * la entrada se da por parada.
+ */
+static void my_pulse_window(struct my_pulse_line *l, u64 now)
+{
+	u64 span, high;
+	u32 n;
+
+	if (l->w_rises >= 2) {
+		span = l->w_last - l->w_first;
+		n = l->w_rises - 1;
+		l->period_ns = min_t(u64, div_u64(span, n), U32_MAX);
+		/* n * 1e12 desborda u64 con ~1.8e7 subidas: producto de 128 bits */
+		l->freq_mhz = span ? min_t(u64, mul_u64_u64_div_u64(n, NSEC_PER_SEC * 1000ULL, span),
+					   U32_MAX) : 0;
+		if (l->w_highs && l->period_ns) {
+			high = div_u64(l->w_high, l->w_highs);
+			l->duty_ppm = min_t(u64, div_u64(high * 1000000, l->period_ns),
+					    1000000);
+		}
+		l->w_first = l->w_last;
+		l->w_rises = 1;
+		l->w_high = 0;
+		l->w_highs = 0;
+		return;
+	}
+
+	if (!l->period_ns || now - l->rise > 2ULL * l->period_ns) {
+		l->freq_mhz = 0;
+		l->period_ns = 0;
+		l->duty_ppm = l->level ? 1000000 : 0;
+	}
+}
+
+static u32 my_pulse_get(struct my_pulse_line *l, unsigned int v)
+{
+	switch (v) {
+	case MY_PULSE_COUNT:	return l->pulses;
+	case MY_PULSE_FREQ:	return l->freq_mhz;
+	case MY_PULSE_PERIOD:	return l->period_ns;
+	default:		return l->duty_ppm;
+	}
+}
+
+/* Gpiochip MMIO: contexto duro o el que dé el chip */
+static irqreturn_t my_pulse_irq(int irq, void *data)
+{
+	struct my_pulse_line *l = data;
+	u64 ts = ktime_get_ns();
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&l->lock, flags);
+	my_pulse_edge(l, gpiod_get_value(l->gpio), ts);
+	raw_spin_unlock_irqrestore(&l->lock, flags);
+	return IRQ_HANDLED;
+}
+
+/*
+ * Gpiochip que duerme (expansor I2C, gpio-sim): hilo, anidado o propio.
+ * El nivel se lee siempre; si ya cambió otra vez, el flanco repetido
+ * cuenta en missed y el siguiente vuelve a sincronizar alto y bajo.
+ */
+static irqreturn_t my_pulse_irq_thread(int irq, void *data)
+{
+	struct my_pulse_line *l = data;
+	u64 ts = ktime_get_ns();
+	int level = gpiod_get_value_cansleep(l->gpio);
+
+	if (level < 0)
+		return IRQ_HANDLED;
+
+	raw_spin_lock_irq(&l->lock);
+	my_pulse_edge(l, level, ts);
+	raw_spin_unlock_irq(&l->lock);
+	return IRQ_HANDLED;
+}
+
+static void my_pulse_close_all(struct my_pulse_state *st, u64 now)
+{
+	unsigned int i, v;
+
+	for (i = 0; i < st->nlines; i++) {
+		struct my_pulse_line *l = &st->line[i];
+
+		raw_spin_lock_irq(&l->lock);
+		my_pulse_window(l, now);
+		for (v = 0; v < MY_PULSE_VALS; v++)
+			st->scan.v[i * MY_PULSE_VALS + v] = my_pulse_get(l, v);
+		raw_spin_unlock_irq(&l->lock);
+	}
+}
+
+static int my_pulse_read_raw(struct iio_dev *indio_dev,
+			     struct iio_chan_spec const *chan,
+			     int *val, int *val2, long mask)
+{
+	struct my_pulse_state *st = iio_priv(indio_dev);
+	struct my_pulse_line *l;
+
+	switch (mask) {
+	case IIO_CHAN_INFO_RAW:
+		l = &st->line[chan->channel];
+		raw_spin_lock_irq(&l->lock);
+		/* Sin buffer la lectura cierra la ventana; con él, el scan */
+		if (!iio_buffer_enabled(indio_dev))
+			my_pulse_window(l, ktime_get_ns());
+		*val = my_pulse_get(l, chan->address);
+		raw_spin_unlock_irq(&l->lock);
+		return IIO_VAL_INT;
+	case IIO_CHAN_INFO_SCALE:
+		*val = 0;
+		switch (chan->address) {
+		case MY_PULSE_FREQ:	/* mHz -> Hz */
+			*val2 = 1000;
+			return IIO_VAL_INT_PLUS_MICRO;
+		case MY_PULSE_PERIOD:	/* ns -> s */
+			*val2 = 1;
+			return IIO_VAL_INT_PLUS_NANO;
+		case MY_PULSE_DUTY:	/* ppm -> fracción */
+			*val2 = 1;
+			return IIO_VAL_INT_PLUS_MICRO;
+		}
+		return -EINVAL;
+	case IIO_CHAN_INFO_SAMP_FREQ:
+		*val = READ_ONCE(st->samp_freq);
+		return IIO_VAL_INT;
+	default:
+		return -EINVAL;
+	}
+}
+
+static int my_pulse_write_raw(struct iio_dev *indio_dev,
+			      struct iio_chan_spec const *chan,
+			      int val, int val2, long mask)
+{
+	struct my_pulse_state *st = iio_priv(indio_dev);
+
+	if (mask != IIO_CHAN_INFO_SAMP_FREQ)
+		return -EINVAL;
+	if (val < 1 || val > MY_PULSE_MAX_FREQ || val2)
+		return -EINVAL;
+
+	mutex_lock(&st->lock);
+	st->samp_freq = val;
+	WRITE_ONCE(st->tick, ns_to_ktime(div_u64(NSEC_PER_SEC, val)));
+	mutex_unlock(&st->lock);
+	return 0;
+}
+
+/* Bottom half del trigger: un scan con todas las líneas */
+static irqreturn_t my_pulse_trigger_handler(int irq, void *p)
+{
+	struct iio_poll_func *pf = p;
+	struct iio_dev *indio_dev = pf->indio_dev;
+	struct my_pulse_state *st = iio_priv(indio_dev);
+
+	my_pulse_close_all(st, ktime_get_ns());
+	iio_push_to_buffers_with_timestamp(indio_dev, &st->scan, pf->timestamp);
+	iio_trigger_notify_done(indio_dev->trig);
+	return IRQ_HANDLED;
+}
+
+static enum hrtimer_restart my_pulse_hrtimer(struct hrtimer *t)
+{
+	struct my_pulse_state *st = container_of(t, struct my_pulse_state, timer);
+
+	iio_trigger_poll(st->trig);
+	hrtimer_forward_now(t, READ_ONCE(st->tick));
+	return HRTIMER_RESTART;
+}
+
+static int my_pulse_set_trigger_state(struct iio_trigger *trig, bool state)
+{
+	struct my_pulse_state *st = iio_priv(iio_trigger_get_drvdata(trig));
+
+	if (state)
+		hrtimer_start(&st->timer, READ_ONCE(st->tick), HRTIMER_MODE_REL_HARD);
+	else
+		hrtimer_cancel(&st->timer);
+	return 0;
+}
+
+static const struct iio_trigger_ops my_pulse_trigger_ops = {
+	.set_trigger_state = my_pulse_set_trigger_state,
+};
+
+/* Lo que vale el periodo del blinker, por la API exportada sin retenerla */
+static int my_pulse_blink_ms(int id, unsigned int *ms)
+{
+	int (*get)(unsigned int *ms);
+	int ret;
+
+	switch (id) {
+	case BLINK_ID_KTHREAD:
+		get = symbol_get(kthread_blink_nodt_get_period);
+		if (!get)
+			return -ENODEV;
+		ret = get(ms);
+		symbol_put(kthread_blink_nodt_get_period);
+		return ret;
+	case BLINK_ID_TIMER:
+		get = symbol_get(timer_blink_nodt_get_period);
+		if (!get)
+			return -ENODEV;
+		ret = get(ms);
+		symbol_put(timer_blink_nodt_get_period);
+		return ret;
+	case BLINK_ID_HRTIMER:
+		get = symbol_get(hrtimer_blink_nodt_get_period);
+		if (!get)
+			return -ENODEV;
+		ret = get(ms);
+		symbol_put(hrtimer_blink_nodt_get_period);
+		return ret;
+	default:
+		return -EINVAL;
+	}
+}
+
+/* Frecuencia pedida al blinker frente a la medida, error en ppm */
+static ssize_t blink_check_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct my_pulse_state *st = iio_priv(dev_to_iio_dev(dev));
+	unsigned int line = READ_ONCE(check_line), ms;
+	struct my_pulse_line *l;
+	u64 want, got;
+	int ret;
+
+	if (line >= st->nlines)
+		return -EINVAL;
+	ret = my_pulse_blink_ms(READ_ONCE(check_blink_id), &ms);
+	if (ret)
+		return ret;
+	/* En uHz: periodos de más de 1000 s siguen dando algo distinto de 0 */
+	want = div_u64(1000000000ULL, max(ms, 1U));
+	if (!want)
+		return -ERANGE;
+
+	l = &st->line[line];
+	raw_spin_lock_irq(&l->lock);
+	if (!iio_buffer_enabled(st->indio_dev))
+		my_pulse_window(l, ktime_get_ns());
+	got = (u64)l->freq_mhz * 1000;
+	raw_spin_unlock_irq(&l->lock);
+
+	return sysfs_emit(buf, "expected_mhz %llu measured_mhz %llu error_ppm %lld\n",
+			  div_u64(want, 1000), div_u64(got, 1000),
+			  div64_s64(((s64)got - (s64)want) * 1000000, want));
+}
+
+static DEVICE_ATTR_RO(blink_check);
+
+/* Flancos que llegaron sin su contrario: IRQ perdidas o rebotes */
+static ssize_t missed_edges_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct my_pulse_state *st = iio_priv(dev_to_iio_dev(dev));
+	unsigned int i;
+	int len = 0;
+
+	for (i = 0; i < st->nlines; i++)
+		len += sysfs_emit_at(buf, len, "%s%llu", i ? " " : "",
+				     READ_ONCE(st->line[i].missed));
+	len += sysfs_emit_at(buf, len, "\n");
+	return len;
+}
+
+static DEVICE_ATTR_RO(missed_edges);
+
+static struct attribute *my_pulse_attributes[] = {
+	&dev_attr_blink_check.attr,
+	&dev_attr_missed_edges.attr,
+	NULL,
+};
+
+static const struct attribute_group my_pulse_attr_group = {
+	.attrs = my_pulse_attributes,
+};
+
+static const struct iio_info my_pulse_info = {
+	.read_raw = my_pulse_read_raw,
+	.write_raw = my_pulse_write_raw,
+	.attrs = &my_pulse_attr_group,
+};
+
+/* Cuatro canales u32 por línea + timestamp */
+static int my_pulse_init_channels(struct device *dev, struct iio_dev *indio_dev,
+				  struct my_pulse_state *st)
+{
+	unsigned int i, v, n = st->nlines * MY_PULSE_VALS;
+	struct iio_chan_spec *chans;
+
+	chans = memacct_devm_kcalloc(acct_ctx, dev, n + 1, sizeof(*chans),
+				     GFP_KERNEL);
+	if (!chans)
+		return -ENOMEM;
+
+	for (i = 0; i < st->nlines; i++)
+		for (v = 0; v < MY_PULSE_VALS; v++) {
+			chans[i * MY_PULSE_VALS + v] = (struct iio_chan_spec){
+				.type = IIO_COUNT,
+				.indexed = 1,
+				.channel = i,
+				.address = v,
+				.extend_name = my_pulse_val_names[v],
+				.info_mask_separate = BIT(IIO_CHAN_INFO_RAW) |
+					(v != MY_PULSE_COUNT ? BIT(IIO_CHAN_INFO_SCALE) : 0),
+				.info_mask_shared_by_all = BIT(IIO_CHAN_INFO_SAMP_FREQ),
+				.scan_index = i * MY_PULSE_VALS + v,
+				.scan_type = {
+					.sign = 'u',
+					.realbits = 32,
+					.storagebits = 32,
+					.endianness = IIO_CPU,
+				},
+			};
+		}
+	chans[n] = (struct iio_chan_spec)IIO_CHAN_SOFT_TIMESTAMP(n);
+
+	/* Siempre se llenan todos; el core demultiplexa el resto */
+	st->scan_masks[0] = GENMASK(n - 1, 0);
+	st->scan_masks[1] = 0;
+
+	indio_dev->channels = chans;
+	indio_dev->num_channels = n + 1;
+	indio_dev->available_scan_masks = st->scan_masks;
+	return 0;
+}
+
+static int my_pulse_init_line(struct device *dev, struct my_pulse_line *l,
+			      unsigned int i)
+{
+	int irq, ret;
+
+	raw_spin_lock_init(&l->lock);
+	l->gpio = devm_gpiod_get_index(dev, "pulse", i, GPIOD_IN);
+	if (IS_ERR(l->gpio))
+		return dev_err_probe(dev, PTR_ERR(l->gpio), "gpiod_get %u\n", i);
+	l->can_sleep = gpiod_cansleep(l->gpio);
+	l->level = gpiod_get_value_cansleep(l->gpio);
+
+	irq = gpiod_to_irq(l->gpio);
+	if (irq < 0)
+		return dev_err_probe(dev, irq, "gpiod_to_irq %u\n", i);
+
+	if (l->can_sleep)
+		ret = devm_request_threaded_irq(dev, irq, NULL, my_pulse_irq_thread,
+						IRQF_TRIGGER_RISING | IRQF_TRIGGER_FALLING |
+						IRQF_ONESHOT, DRIVER_NAME, l);
+	else
+		ret = devm_request_any_context_irq(dev, irq, my_pulse_irq,
+						   IRQF_TRIGGER_RISING | IRQF_TRIGGER_FALLING,
+						   DRIVER_NAME, l);
+	return ret < 0 ? dev_err_probe(dev, ret, "irq %d\n", irq) : 0;
+}
+
+static int my_pulse_probe(struct platform_device *pdev)
+{
+	struct iio_dev *indio_dev;
+	struct my_pulse_state *st;
+	unsigned int i;
+	int ret;
+
+	indio_dev = devm_iio_device_alloc(&pdev->dev, sizeof(*st));
+	if (!indio_dev)
+		return -ENOMEM;
+
+	st = iio_priv(indio_dev);
+	st->indio_dev = indio_dev;
+	mutex_init(&st->lock);
+	st->nlines = nr_lines;
+	st->samp_freq = 10;
+	st->tick = ns_to_ktime(NSEC_PER_SEC / st->samp_freq);
+
+	for (i = 0; i < st->nlines; i++) {
+		ret = my_pulse_init_line(&pdev->dev, &st->line[i], i);
+		if (ret)
+			return ret;
+	}
+
+	hrtimer_init(&st->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL_HARD);
+	st->timer.function = my_pulse_hrtimer;
+
+	indio_dev->name = DRIVER_NAME;
+	indio_dev->modes = INDIO_DIRECT_MODE;
+	indio_dev->info = &my_pulse_info;
+	ret = my_pulse_init_channels(&pdev->dev, indio_dev, st);
+	if (ret)
+		return ret;
+
+	st->trig = devm_iio_trigger_alloc(&pdev->dev, "%s-dev%d",
+					  indio_dev->name,
+					  iio_device_id(indio_dev));
+	if (!st->trig)
+		return -ENOMEM;
+	st->trig->ops = &my_pulse_trigger_ops;
+	iio_trigger_set_drvdata(st->trig, indio_dev);
+	ret = devm_iio_trigger_register(&pdev->dev, st->trig);
+	if (ret)
+		return dev_err_probe(&pdev->dev, ret, "trigger register\n");
+	indio_dev->trig = iio_trigger_get(st->trig);
+
+	ret = devm_iio_triggered_buffer_setup(&pdev->dev, indio_dev,
+					      iio_pollfunc_store_time,
+					      my_pulse_trigger_handler, NULL);
+	if (ret)
+		return dev_err_probe(&pdev->dev, ret, "triggered buffer\n");
+
+	platform_set_drvdata(pdev, indio_dev);
+	ret = iio_device_register(indio_dev);
+	if (ret)
+		return ret;
+
+	dev_info(&pdev->dev, "%u entradas en %s\n", st->nlines, chip);
+	return 0;
+}
+
+static int my_pulse_remove(struct platform_device *pdev)
+{
+	struct iio_dev *indio_dev = platform_get_drvdata(pdev);
+	struct my_pulse_state *st = iio_priv(indio_dev);
+
+	iio_device_unregister(indio_dev);
+	hrtimer_cancel(&st->timer);
+	return 0;
+}
+
+static struct platform_driver my_pulse_driver = {
+	.probe  = my_pulse_probe,
+	.remove = my_pulse_remove,
+	.driver = {
+		.name = DRIVER_NAME,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
+	},
+};
+
+static struct platform_device *my_pulse_device;
+
+static void my_pulse_acct_unregister(void)
+{
+	memacct_unregister(acct_lookup);
+	memacct_unregister(acct_ctx);
+}
+
+static int __init my_pulse_init(void)
+{
+	int i, ret;
+
+	if (nr_lines < 1 || nr_lines > MY_PULSE_MAX_LINES)
+		return -EINVAL;
+
+	acct_ctx = memacct_register(KBUILD_MODNAME, "ctx");
+	acct_lookup = memacct_register(KBUILD_MODNAME, "lookup");
+
+	/* Entrada final vacía: termina la tabla */
+	lt_size = struct_size(lt, table, nr_lines + 1);
+	lt = memacct_kzalloc(acct_lookup, lt_size, GFP_KERNEL);
+	if (!lt) {
+		ret = -ENOMEM;
+		goto err_acct;
+	}
+	lt->dev_id = DRIVER_NAME;
+	for (i = 0; i < nr_lines; i++)
+		lt->table[i] = (struct gpiod_lookup)GPIO_LOOKUP_IDX(chip, lines[i],
+								   "pulse", i,
+								   GPIO_ACTIVE_HIGH);
+	gpiod_add_lookup_table(lt);
+
+	ret = platform_driver_register(&my_pulse_driver);
+	if (ret)
+		goto err_lt;
+
+	my_pulse_device = platform_device_register_simple(DRIVER_NAME, -1, NULL, 0);
+	if (IS_ERR(my_pulse_device)) {
+		ret = PTR_ERR(my_pulse_device);
+		platform_driver_unregister(&my_pulse_driver);
+		goto err_lt;
+	}
+	return 0;
+
+err_lt:
+	gpiod_remove_lookup_table(lt);
+	memacct_kfree(acct_lookup, lt, lt_size);
+err_acct:
+	my_pulse_acct_unregister();
+	return ret;
+}
+
+static void __exit my_pulse_exit(void)
+{
+	platform_device_unregister(my_pulse_device);
+	platform_driver_unregister(&my_pulse_driver);
+	gpiod_remove_lookup_table(lt);
+	memacct_kfree(acct_lookup, lt, lt_size);
+	my_pulse_acct_unregister();
+}
+
+module_init(my_pulse_init);
+module_exit(my_pulse_exit);
+
+#ifdef MY_KUNIT
+#include "my_iio_pulse_kunit.c"
+#endif
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Tu Nombre");
+MODULE_DESCRIPTION("Contador de pulsos y frecuencímetro IIO sobre entradas GPIO");
@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * KUnit: cuentas de flancos y cierre de ventana de my_iio_pulse, con
+ * timestamps sintéticos. Se incluye al final de my_iio_pulse.c con
+ * "make KUNIT=1".
+ */
+#include "kbench.h"
+
+#define MS(x)	((u64)(x) * NSEC_PER_MSEC)
+
+static struct my_pulse_line *my_pulse_test_line(struct kunit *test)
+{
+	struct my_pulse_line *l = kunit_kzalloc(test, sizeof(*l), GFP_KERNEL);
+
+	KUNIT_ASSERT_NOT_NULL(test, l);
+	raw_spin_lock_init(&l->lock);
+	return l;
+}
+
+/* 100 Hz al 25 %: subida cada 10 ms, bajada 2.5 ms después */
+static void my_pulse_test_square(struct kunit *test)
+{
+	struct my_pulse_line *l = my_pulse_test_line(test);
+	u64 t = MS(1000);
+	int i;
+
+	for (i = 0; i < 11; i++, t += MS(10)) {
+		my_pulse_edge(l, 1, t);
+		my_pulse_edge(l, 0, t + MS(10) / 4);
+	}
+	my_pulse_window(l, t);
+
+	KUNIT_EXPECT_EQ(test, l->pulses, 11U);
+	KUNIT_EXPECT_EQ(test, l->period_ns, 10000000U);
+	KUNIT_EXPECT_EQ(test, l->freq_mhz, 100000U);
+	KUNIT_EXPECT_EQ(test, l->duty_ppm, 250000U);
+	KUNIT_EXPECT_EQ(test, l->missed, 0ULL);
+
+	/* La ventana siguiente arranca en la última subida */
+	KUNIT_EXPECT_EQ(test, l->w_rises, 1U);
+	KUNIT_EXPECT_EQ(test, l->w_first, t - MS(10));
+}
+
+/* Más lenta que los scans: se conserva la medida hasta la parada */
+static void my_pulse_test_slow_and_stop(struct kunit *test)
+{
+	struct my_pulse_line *l = my_pulse_test_line(test);
+
+	my_pulse_edge(l, 1, MS(100));
+	my_pulse_edge(l, 0, MS(600));
+	my_pulse_edge(l, 1, MS(1100));
+	my_pulse_window(l, MS(1100));
+	KUNIT_EXPECT_EQ(test, l->freq_mhz, 1000U);
+
+	/* Un scan a mitad de periodo no la toca */
+	my_pulse_window(l, MS(1600));
+	KUNIT_EXPECT_EQ(test, l->freq_mhz, 1000U);
+	KUNIT_EXPECT_EQ(test, l->duty_ppm, 500000U);
+
+	/* Dos periodos sin subida: parada, en alto */
+	my_pulse_window(l, MS(3200));
+	KUNIT_EXPECT_EQ(test, l->freq_mhz, 0U);
+	KUNIT_EXPECT_EQ(test, l->period_ns, 0U);
+	KUNIT_EXPECT_EQ(test, l->duty_ppm, 1000000U);
+}
+
+/* Bajada perdida: el pulso cuenta, su ciclo útil no */
+static void my_pulse_test_missed(struct kunit *test)
+{
+	struct my_pulse_line *l = my_pulse_test_line(test);
+
+	my_pulse_edge(l, 1, MS(0));
+	my_pulse_edge(l, 1, MS(10));
+	my_pulse_edge(l, 0, MS(15));
+	KUNIT_EXPECT_EQ(test, l->pulses, 2U);
+	KUNIT_EXPECT_EQ(test, l->missed, 1ULL);
+	KUNIT_EXPECT_EQ(test, l->w_highs, 1U);
+	KUNIT_EXPECT_EQ(test, l->w_high, MS(5));
+}
+
+/* 1 kHz unas 5.5 h sin lector: n * 1e12 ya no cabe en u64 */
+static void my_pulse_test_long_window(struct kunit *test)
+{
+	struct my_pulse_line *l = my_pulse_test_line(test);
+
+	l->w_rises = 20000001;
+	l->w_first = 0;
+	l->w_last = MS(20000000);
+	my_pulse_window(l, l->w_last);
+	KUNIT_EXPECT_EQ(test, l->period_ns, 1000000U);
+	KUNIT_EXPECT_EQ(test, l->freq_mhz, 1000000U);
+}
+
+static void my_pulse_bench_edge(struct kunit *test)
+{
+	struct my_pulse_line *l = my_pulse_test_line(test);
+	u64 t = 0;
+
+	/* Coste del handler sin la IRQ: lo que se paga por flanco a kHz */
+	KBENCH(test, "my_pulse_edge", 100000, 30, {
+		my_pulse_edge(l, !l->level, t);
+		t += 1000;
+	});
+}
+
+static struct kunit_case my_pulse_test_cases[] = {
+	KUNIT_CASE(my_pulse_test_square),
+	KUNIT_CASE(my_pulse_test_slow_and_stop),
+	KUNIT_CASE(my_pulse_test_missed),
+	KUNIT_CASE(my_pulse_test_long_window),
+	KUNIT_CASE(my_pulse_bench_edge),
+	{}
+};
+
+static struct kunit_suite my_pulse_test_suite = {
+	.name = "my_iio_pulse",
+	.test_cases = my_pulse_test_cases,
+};
+kunit_test_suite(my_pulse_test_suite);
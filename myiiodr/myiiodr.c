@@ -3,35 +3,1095 @@
 #include <linux/kernel.h>
 #include <linux/platform_device.h>
 #include <linux/iio/iio.h>
+#include <linux/iio/buffer.h>
+#include <linux/iio/sysfs.h>
+#include <linux/iio/events.h>
+#include <linux/iio/trigger.h>
+#include <linux/iio/trigger_consumer.h>
+#include <linux/iio/triggered_buffer.h>
+#include <linux/hrtimer.h>
+#include <linux/mutex.h>
+#include <linux/fixp-arith.h>
+#include <linux/log2.h>
+#include <linux/miscdevice.h>
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/sizes.h>
+#include <linux/list.h>
+#include <linux/spinlock.h>
+#include <linux/poll.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+#include <linux/wait.h>
 #include <linux/slab.h>
+#include <linux/workqueue.h>
+
+#include "my_iio_dummy.h"
+#include "my_iio_blink.h"
+#include "memacct.h"
 
 #define DRIVER_NAME "my_iio_dummy"
 
-static int injected_value;
+#define MY_MAX_CHANNELS		16
+#define MY_LUT_BITS		10
+#define MY_LUT_SIZE		(1 << MY_LUT_BITS)
+#define MY_MAX_SAMP_FREQ	2000000		/* Hz, tasa de salida */
+#define MY_MAX_RAW_FREQ		64000000	/* Hz, tasa interna = salida * OSR */
+#define MY_MAX_OSR_SHIFT	8		/* oversampling hasta 256 */
+#define MY_MIN_TICK_NS		100000		/* el hrtimer no baja de 100 us */
+#define MY_MAX_BATCH		4096		/* scans por disparo del trigger */
+#define MY_FIFO_MAX		512		/* scans del hwfifo emulado */
+
+static unsigned int gen_amplitude = 2047;	/* fondo de escala tipo ADC 12 bit */
+module_param(gen_amplitude, uint, 0444);
+MODULE_PARM_DESC(gen_amplitude, "Amplitud de pico del generador (cuentas).");
+
+static unsigned int num_channels = 4;
+module_param(num_channels, uint, 0444);
+MODULE_PARM_DESC(num_channels, "Canales de voltaje (1..16).");
+
+static unsigned int scan_bits = 32;
+module_param(scan_bits, uint, 0444);
+MODULE_PARM_DESC(scan_bits, "Bits de almacenamiento por muestra en el buffer (16 o 32).");
+
+static unsigned int inject_ring_scans = 65536;
+module_param(inject_ring_scans, uint, 0444);
+MODULE_PARM_DESC(inject_ring_scans, "Scans en el anillo de inyección (potencia de 2).");
+
+enum my_waveform {
+	MY_WAVE_INJECT,
+	MY_WAVE_SINE,
+	MY_WAVE_RAMP,
+	MY_WAVE_SQUARE,
+	MY_WAVE_NOISE,
+};
+
+static const char * const my_waveform_names[] = {
+	[MY_WAVE_INJECT] = "inject",
+	[MY_WAVE_SINE]   = "sine",
+	[MY_WAVE_RAMP]   = "ramp",
+	[MY_WAVE_SQUARE] = "square",
+	[MY_WAVE_NOISE]  = "noise",
+};
+
+enum my_os_mode {
+	MY_OS_AVERAGE,
+	MY_OS_DECIMATE,
+};
+
+static const char * const my_os_mode_names[] = {
+	[MY_OS_AVERAGE]  = "average",
+	[MY_OS_DECIMATE] = "decimate",
+};
+
+static const int my_osr_avail[] = { 1, 2, 4, 8, 16, 32, 64, 128, 256 };
+
+/* Seno Q15 de un periodo completo, se llena en my_init() */
+static s16 my_sine_lut[MY_LUT_SIZE];
+
+/* memacct: contexto devm, anillo de inyección y área de bloques */
+static struct memacct *acct_ctx, *acct_ring, *acct_blocks;
+
+/*
+ * Umbrales con histéresis. Un evento se dispara al cruzar el umbral y no
+ * se vuelve a armar hasta que la señal regresa más allá de la histéresis.
+ */
+struct my_iio_thresh {
+	s32 rise, rise_hyst;
+	s32 fall, fall_hyst;
+	bool rise_en, rise_armed;
+	bool fall_en, fall_armed;
+};
+
+/* Oscilador DDS por canal: la fase de 32 bit recorre la forma de onda */
+struct my_iio_gen {
+	enum my_waveform wave;
+	s32 inject;			/* último valor inyectado */
+	unsigned int freq_hz;
+	u32 phase;
+	u32 phase_inc;
+	struct my_iio_thresh ev;
+};
+
+/* Un scan en el anillo de inyección, con timestamp de la grabación */
+struct my_iio_inject_scan {
+	s64 ts;
+	s32 data[MY_MAX_CHANNELS];
+};
+
+/* Bloque del buffer mmap y en qué cola está */
+enum my_blk_state {
+	MY_BLK_DEQUEUED,		/* en manos de userspace */
+	MY_BLK_QUEUED,			/* vacío, esperando al productor */
+	MY_BLK_ACTIVE,			/* el productor escribe en él */
+	MY_BLK_DONE,			/* lleno, esperando DEQUEUE */
+};
+
+struct my_iio_blk {
+	struct my_iio_block desc;
+	enum my_blk_state state;
+	struct list_head head;
+};
+
+struct my_iio_state {
+	struct iio_dev *indio_dev;
+	struct mutex lock;		/* protege la configuración */
+	unsigned int num_channels;
+	struct my_iio_gen gen[MY_MAX_CHANNELS];
+	u32 noise;			/* estado xorshift32 */
+	s32 amplitude;
+
+	/* Oversampling: 2^osr_shift muestras crudas por scan entregado */
+	unsigned int osr_shift;
+	enum my_os_mode os_mode;
+	s32 *os_buf;			/* bloque de muestras crudas de un canal */
+
+	unsigned int samp_freq;		/* Hz */
+	u64 samp_period_ns;
+	s64 next_ts;			/* timestamp del próximo scan generado */
+
+	struct iio_trigger *trig;
+	struct hrtimer timer;
+	ktime_t tick;
+
+	/*
+	 * Anillo SPSC: write() produce (head), el trigger handler consume
+	 * (tail). Los índices corren libres y se enmascaran con ring_size - 1.
+	 */
+	struct my_iio_inject_scan *ring;
+	unsigned int ring_size;
+	unsigned int ring_head;
+	unsigned int ring_tail;
+	wait_queue_head_t inject_wq;
+	struct miscdevice inject_misc;
+	atomic_t inject_busy;		/* un solo escritor a la vez */
+	struct mutex inject_mutex;	/* write() frente a remove */
+	bool inject_gone;		/* unbind: el anillo ya no es nuestro */
+	s64 inject_last_ts;		/* para exigir orden de timestamp */
+	bool inject_open;
+	bool inject_paced;		/* true: respeta timestamps; false: a tope */
+	bool replaying;
+	s64 replay_base;		/* reloj IIO - timestamp grabado */
+
+	/*
+	 * Scan que se empuja al kfifo: num_channels muestras de scan_bits
+	 * empaquetadas y el timestamp alineado a 8 al final (scan_bytes).
+	 */
+	void *scan;
+	unsigned int scan_size;		/* muestras + timestamp */
+	unsigned int storage_bytes;
+	unsigned long scan_masks[2];
+
+	/*
+	 * Buffer de bloques: userspace encola bloques vacíos de blk_mem y el
+	 * productor escribe los scans directo en ellos. blk_cur es solo del
+	 * productor (bajo st->lock); las colas van bajo blk_lock.
+	 */
+	struct miscdevice blk_misc;
+	atomic_t blk_busy;
+	atomic_t blk_mapped;
+	bool blk_gone;			/* unbind, bajo st->lock */
+	void *blk_mem;
+	struct my_iio_blk *blks;
+	unsigned int blk_count;
+	bool blk_streaming;
+	spinlock_t blk_lock;
+	struct list_head blk_incoming;
+	struct list_head blk_outgoing;
+	struct my_iio_blk *blk_cur;
+	bool blk_overrun;
+	u64 blk_dropped;
+	wait_queue_head_t blk_wq;
+
+	/*
+	 * hwfifo emulado (bajo st->lock): con watermark > 1 los scans se
+	 * generan en fifo y pasan al kfifo de fifo_wm en fifo_wm, o todos a
+	 * la vez si el más antiguo lleva fifo_timeout_ms esperando. Así el
+	 * lector despierta una vez por lote y no por scan.
+	 */
+	void *fifo;
+	unsigned int fifo_n;
+	unsigned int fifo_wm;
+	unsigned int fifo_timeout_ms;
+	struct delayed_work fifo_work;
+	u64 fifo_wakeups;		/* entregas al kfifo */
+	u64 fifo_scans;			/* scans entregados */
+	u64 fifo_timeouts;		/* entregas por timeout */
+};
+
+/*
+ * Genera n muestras crudas del canal en x[] y avanza su fase. El switch
+ * queda fuera de los bucles: cada forma de onda es un bucle plano.
+ */
+static void my_gen_block(struct my_iio_state *st, struct my_iio_gen *g,
+			 s32 *x, unsigned int n)
+{
+	u32 phase = g->phase, inc = g->phase_inc;
+	s32 amp = st->amplitude;
+	unsigned int i;
+
+	switch (g->wave) {
+	case MY_WAVE_SINE:
+		for (i = 0; i < n; i++, phase += inc)
+			x[i] = (my_sine_lut[phase >> (32 - MY_LUT_BITS)] * amp) >> 15;
+		break;
+	case MY_WAVE_RAMP:
+		for (i = 0; i < n; i++, phase += inc)
+			x[i] = (((s32)phase >> 16) * amp) >> 15;
+		break;
+	case MY_WAVE_SQUARE:
+		for (i = 0; i < n; i++, phase += inc)
+			x[i] = (s32)phase >= 0 ? amp : -amp;
+		break;
+	case MY_WAVE_NOISE: {
+		u32 r = st->noise;
+
+		for (i = 0; i < n; i++) {
+			r ^= r << 13;
+			r ^= r >> 17;
+			r ^= r << 5;
+			x[i] = (((s32)r >> 16) * amp) >> 15;
+		}
+		st->noise = r;
+		phase += inc * n;
+		break;
+	}
+	case MY_WAVE_INJECT:
+	default: {
+		s32 v = READ_ONCE(g->inject);
+
+		for (i = 0; i < n; i++)
+			x[i] = v;
+		phase += inc * n;
+		break;
+	}
+	}
+	g->phase = phase;
+}
+
+/*
+ * Media de un bloque de 2^shift muestras. Reducción plana, sin ramas ni
+ * dependencias entre iteraciones salvo el acumulador.
+ */
+static s32 my_block_mean(const s32 *x, unsigned int shift)
+{
+	unsigned int i, n = 1U << shift;
+	s64 acc = 0;
+
+	for (i = 0; i < n; i++)
+		acc += x[i];
+	return acc >> shift;
+}
+
+static void my_scan_store(struct my_iio_state *st, unsigned int i, s32 v)
+{
+	if (st->storage_bytes == sizeof(s16))
+		((s16 *)st->scan)[i] = clamp_t(s32, v, S16_MIN, S16_MAX);
+	else
+		((s32 *)st->scan)[i] = v;
+}
+
+/* Un scan reducido por canal, tras 2^osr_shift muestras crudas */
+static s32 my_gen_output(struct my_iio_state *st, struct my_iio_gen *g)
+{
+	unsigned int shift = st->osr_shift;
+	s32 v;
+
+	if (!shift) {
+		my_gen_block(st, g, &v, 1);
+		return v;
+	}
+
+	if (st->os_mode == MY_OS_DECIMATE) {
+		/* Se saltan las muestras descartadas sin generarlas */
+		g->phase += g->phase_inc * ((1U << shift) - 1);
+		my_gen_block(st, g, &v, 1);
+		return v;
+	}
+
+	my_gen_block(st, g, st->os_buf, 1U << shift);
+	return my_block_mean(st->os_buf, shift);
+}
+
+static void my_event_push(struct my_iio_state *st, unsigned int ch,
+			  enum iio_event_direction dir, s64 ts)
+{
+	iio_push_event(st->indio_dev,
+		       IIO_UNMOD_EVENT_CODE(IIO_VOLTAGE, ch,
+					    IIO_EV_TYPE_THRESH, dir),
+		       ts);
+	my_iio_blink_event(ch, dir);
+}
+
+static void my_event_check(struct my_iio_state *st, unsigned int ch, s32 v,
+			   s64 ts)
+{
+	struct my_iio_thresh *ev = &st->gen[ch].ev;
+
+	if (ev->rise_en) {
+		if (ev->rise_armed && v > ev->rise) {
+			ev->rise_armed = false;
+			my_event_push(st, ch, IIO_EV_DIR_RISING, ts);
+		} else if (!ev->rise_armed && v < ev->rise - ev->rise_hyst) {
+			ev->rise_armed = true;
+		}
+	}
+
+	if (ev->fall_en) {
+		if (ev->fall_armed && v < ev->fall) {
+			ev->fall_armed = false;
+			my_event_push(st, ch, IIO_EV_DIR_FALLING, ts);
+		} else if (!ev->fall_armed && v > ev->fall + ev->fall_hyst) {
+			ev->fall_armed = true;
+		}
+	}
+}
+
+/* Llena st->scan con un scan, revisa umbrales y avanza un periodo */
+static void my_gen_scan(struct my_iio_state *st, s64 ts)
+{
+	unsigned int i;
+	s32 v;
+
+	for (i = 0; i < st->num_channels; i++) {
+		v = my_gen_output(st, &st->gen[i]);
+		my_scan_store(st, i, v);
+		my_event_check(st, i, v, ts);
+	}
+}
+
+/* El DDS avanza a la tasa interna: sampling_frequency * OSR */
+static void my_gen_update_inc(struct my_iio_state *st, struct my_iio_gen *g)
+{
+	g->phase_inc = div_u64((u64)g->freq_hz << 32,
+			       st->samp_freq << st->osr_shift);
+}
+
+static void my_gen_update_all(struct my_iio_state *st)
+{
+	unsigned int i;
+
+	for (i = 0; i < st->num_channels; i++)
+		my_gen_update_inc(st, &st->gen[i]);
+}
+
+static void my_set_samp_freq(struct my_iio_state *st, unsigned int hz)
+{
+	st->samp_freq = hz;
+	st->samp_period_ns = div_u64(NSEC_PER_SEC, hz);
+	st->tick = ns_to_ktime(max_t(u64, st->samp_period_ns, MY_MIN_TICK_NS));
+	my_gen_update_all(st);
+}
+
+static int my_read_raw(struct iio_dev *indio_dev,
+		       struct iio_chan_spec const *chan,
+		       int *val, int *val2, long mask)
+{
+	struct my_iio_state *st = iio_priv(indio_dev);
+	int ret;
+
+	switch (mask) {
+	case IIO_CHAN_INFO_RAW:
+		/* En modo buffer los datos salen por /dev/iio:deviceN */
+		ret = iio_device_claim_direct_mode(indio_dev);
+		if (ret)
+			return ret;
+		mutex_lock(&st->lock);
+		*val = my_gen_output(st, &st->gen[chan->channel]);
+		my_event_check(st, chan->channel, *val,
+			       iio_get_time_ns(indio_dev));
+		mutex_unlock(&st->lock);
+		iio_device_release_direct_mode(indio_dev);
+		return IIO_VAL_INT;
+	case IIO_CHAN_INFO_SAMP_FREQ:
+		*val = st->samp_freq;
+		return IIO_VAL_INT;
+	case IIO_CHAN_INFO_OVERSAMPLING_RATIO:
+		*val = 1 << st->osr_shift;
+		return IIO_VAL_INT;
+	}
+	return -EINVAL;
+}
+
+static int my_read_avail(struct iio_dev *indio_dev,
+			 struct iio_chan_spec const *chan,
+			 const int **vals, int *type, int *length, long mask)
+{
+	switch (mask) {
+	case IIO_CHAN_INFO_OVERSAMPLING_RATIO:
+		*vals = my_osr_avail;
+		*type = IIO_VAL_INT;
+		*length = ARRAY_SIZE(my_osr_avail);
+		return IIO_AVAIL_LIST;
+	}
+	return -EINVAL;
+}
+
+static int my_write_raw(struct iio_dev *indio_dev,
+			struct iio_chan_spec const *chan,
+			int val, int val2, long mask)
+{
+	struct my_iio_state *st = iio_priv(indio_dev);
+	int ret = 0;
+
+	switch (mask) {
+	case IIO_CHAN_INFO_SAMP_FREQ:
+		if (val < 1 || val > MY_MAX_SAMP_FREQ || val2)
+			return -EINVAL;
+		mutex_lock(&st->lock);
+		if ((u64)val << st->osr_shift > MY_MAX_RAW_FREQ)
+			ret = -EINVAL;
+		else
+			my_set_samp_freq(st, val);
+		mutex_unlock(&st->lock);
+		/* Si el generador corre, el siguiente forward usa el tick nuevo */
+		return ret;
+	case IIO_CHAN_INFO_OVERSAMPLING_RATIO:
+		if (val < 1 || !is_power_of_2(val) || ilog2(val) > MY_MAX_OSR_SHIFT || val2)
+			return -EINVAL;
+		mutex_lock(&st->lock);
+		if ((u64)st->samp_freq << ilog2(val) > MY_MAX_RAW_FREQ) {
+			ret = -EINVAL;
+		} else {
+			st->osr_shift = ilog2(val);
+			my_gen_update_all(st);
+		}
+		mutex_unlock(&st->lock);
+		return ret;
+	}
+	return -EINVAL;
+}
+
+/* --- eventos de umbral --- */
+static int my_read_event_config(struct iio_dev *indio_dev,
+				const struct iio_chan_spec *chan,
+				enum iio_event_type type,
+				enum iio_event_direction dir)
+{
+	struct my_iio_state *st = iio_priv(indio_dev);
+	struct my_iio_thresh *ev = &st->gen[chan->channel].ev;
+
+	return dir == IIO_EV_DIR_RISING ? ev->rise_en : ev->fall_en;
+}
+
+static int my_write_event_config(struct iio_dev *indio_dev,
+				 const struct iio_chan_spec *chan,
+				 enum iio_event_type type,
+				 enum iio_event_direction dir, int state)
+{
+	struct my_iio_state *st = iio_priv(indio_dev);
+	struct my_iio_thresh *ev = &st->gen[chan->channel].ev;
+
+	mutex_lock(&st->lock);
+	if (dir == IIO_EV_DIR_RISING) {
+		ev->rise_en = state;
+		ev->rise_armed = true;
+	} else {
+		ev->fall_en = state;
+		ev->fall_armed = true;
+	}
+	mutex_unlock(&st->lock);
+	return 0;
+}
+
+static int my_read_event_value(struct iio_dev *indio_dev,
+			       const struct iio_chan_spec *chan,
+			       enum iio_event_type type,
+			       enum iio_event_direction dir,
+			       enum iio_event_info info, int *val, int *val2)
+{
+	struct my_iio_state *st = iio_priv(indio_dev);
+	struct my_iio_thresh *ev = &st->gen[chan->channel].ev;
+	bool rise = dir == IIO_EV_DIR_RISING;
+
+	switch (info) {
+	case IIO_EV_INFO_VALUE:
+		*val = rise ? ev->rise : ev->fall;
+		return IIO_VAL_INT;
+	case IIO_EV_INFO_HYSTERESIS:
+		*val = rise ? ev->rise_hyst : ev->fall_hyst;
+		return IIO_VAL_INT;
+	default:
+		return -EINVAL;
+	}
+}
+
+static int my_write_event_value(struct iio_dev *indio_dev,
+				const struct iio_chan_spec *chan,
+				enum iio_event_type type,
+				enum iio_event_direction dir,
+				enum iio_event_info info, int val, int val2)
+{
+	struct my_iio_state *st = iio_priv(indio_dev);
+	struct my_iio_thresh *ev = &st->gen[chan->channel].ev;
+	bool rise = dir == IIO_EV_DIR_RISING;
+
+	switch (info) {
+	case IIO_EV_INFO_VALUE:
+		mutex_lock(&st->lock);
+		if (rise)
+			ev->rise = val;
+		else
+			ev->fall = val;
+		mutex_unlock(&st->lock);
+		return 0;
+	case IIO_EV_INFO_HYSTERESIS:
+		if (val < 0)
+			return -EINVAL;
+		mutex_lock(&st->lock);
+		if (rise)
+			ev->rise_hyst = val;
+		else
+			ev->fall_hyst = val;
+		mutex_unlock(&st->lock);
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+static unsigned int my_inject_count(struct my_iio_state *st)
+{
+	return smp_load_acquire(&st->ring_head) - st->ring_tail;
+}
+
+/* Scan del anillo: los canales en modo inject toman el valor grabado */
+static void my_inject_scan(struct my_iio_state *st,
+			   const struct my_iio_inject_scan *in, s64 ts)
+{
+	int i;
+
+	for (i = 0; i < st->num_channels; i++)
+		if (st->gen[i].wave == MY_WAVE_INJECT)
+			WRITE_ONCE(st->gen[i].inject, in->data[i]);
+	my_gen_scan(st, ts);
+}
+
+/* --- productor hacia el buffer de bloques --- */
+static void my_block_done(struct my_iio_state *st)
+{
+	struct my_iio_blk *b = st->blk_cur;
+
+	spin_lock(&st->blk_lock);
+	b->state = MY_BLK_DONE;
+	list_add_tail(&b->head, &st->blk_outgoing);
+	spin_unlock(&st->blk_lock);
+	st->blk_cur = NULL;
+	wake_up_interruptible(&st->blk_wq);
+}
+
+/* Hueco para el siguiente scan dentro del bloque activo, o NULL si no hay */
+static void *my_block_slot(struct my_iio_state *st)
+{
+	struct my_iio_blk *b = st->blk_cur;
+
+	if (!b) {
+		spin_lock(&st->blk_lock);
+		b = list_first_entry_or_null(&st->blk_incoming,
+					     struct my_iio_blk, head);
+		if (b) {
+			list_del(&b->head);
+			b->state = MY_BLK_ACTIVE;
+		}
+		spin_unlock(&st->blk_lock);
+		if (!b)
+			return NULL;
+
+		b->desc.bytes_used = 0;
+		b->desc.flags = st->blk_overrun ? MY_IIO_BLOCK_FLAG_OVERRUN : 0;
+		st->blk_overrun = false;
+		st->blk_cur = b;
+	}
+	return st->blk_mem + b->desc.offset + b->desc.bytes_used;
+}
+
+static void my_block_commit(struct my_iio_state *st, void *slot, s64 ts)
+{
+	struct my_iio_blk *b = st->blk_cur;
+
+	((s64 *)slot)[(st->scan_size - 1) / sizeof(s64)] = ts;
+	if (!b->desc.bytes_used)
+		b->desc.timestamp = ts;
+	b->desc.bytes_used += st->scan_size;
+	if (b->desc.bytes_used + st->scan_size > b->desc.size)
+		my_block_done(st);
+}
+
+/* Al parar el buffer se entrega el bloque a medias */
+static void my_block_flush(struct my_iio_state *st)
+{
+	if (st->blk_cur && st->blk_cur->desc.bytes_used)
+		my_block_done(st);
+}
+
+/* --- hwfifo emulado hacia el kfifo --- */
+
+/* Pasa los n scans más antiguos del hwfifo al buffer IIO */
+static unsigned int my_fifo_flush(struct my_iio_state *st, unsigned int n)
+{
+	unsigned int i;
+
+	n = min(n, st->fifo_n);
+	if (!n)
+		return 0;
+
+	for (i = 0; i < n; i++)
+		iio_push_to_buffers(st->indio_dev, st->fifo + i * st->scan_size);
+	st->fifo_n -= n;
+	if (st->fifo_n)
+		memmove(st->fifo, st->fifo + n * st->scan_size,
+			st->fifo_n * st->scan_size);
+
+	st->fifo_wakeups++;
+	st->fifo_scans += n;
+	return n;
+}
+
+static void *my_fifo_slot(struct my_iio_state *st)
+{
+	return st->fifo + st->fifo_n * st->scan_size;
+}
+
+static void my_fifo_commit(struct my_iio_state *st, void *slot, s64 ts)
+{
+	((s64 *)slot)[(st->scan_size - 1) / sizeof(s64)] = ts;
+
+	/* El timeout cuenta desde el scan más antiguo del lote */
+	if (!st->fifo_n++)
+		mod_delayed_work(system_wq, &st->fifo_work,
+				 msecs_to_jiffies(st->fifo_timeout_ms));
+	if (st->fifo_n >= st->fifo_wm)
+		my_fifo_flush(st, st->fifo_n);
+}
+
+static void my_fifo_timeout(struct work_struct *w)
+{
+	struct my_iio_state *st = container_of(to_delayed_work(w),
+					       struct my_iio_state, fifo_work);
+
+	mutex_lock(&st->lock);
+	if (st->fifo_n) {
+		st->fifo_timeouts++;
+		my_fifo_flush(st, st->fifo_n);
+	}
+	mutex_unlock(&st->lock);
+}
+
+/* El core la llama al habilitar el buffer, con su watermark */
+static int my_hwfifo_set_watermark(struct iio_dev *indio_dev, unsigned int val)
+{
+	struct my_iio_state *st = iio_priv(indio_dev);
+
+	mutex_lock(&st->lock);
+	st->fifo_wm = clamp_t(unsigned int, val, 1, MY_FIFO_MAX);
+	mutex_unlock(&st->lock);
+	return 0;
+}
+
+/* read() no bloqueante con menos datos de los pedidos: entrega lo que haya */
+static int my_hwfifo_flush_to_buffer(struct iio_dev *indio_dev,
+				     unsigned int count)
+{
+	struct my_iio_state *st = iio_priv(indio_dev);
+	int n;
+
+	mutex_lock(&st->lock);
+	n = my_fifo_flush(st, count);
+	mutex_unlock(&st->lock);
+	return n;
+}
+
+/*
+ * Produce un scan (del anillo de inyección si in != NULL, si no del
+ * generador) y lo entrega. Con el buffer de bloques activo el scan se
+ * genera directamente dentro del bloque mapeado por userspace; sin bloque
+ * libre se pierde y el próximo bloque lleva la marca de overrun. Con
+ * watermark > 1 se genera dentro del hwfifo emulado.
+ */
+static void my_produce(struct iio_dev *indio_dev, struct my_iio_state *st,
+		       const struct my_iio_inject_scan *in, s64 ts)
+{
+	void *scan = st->scan;
+	void *slot = NULL;
+
+	if (st->blk_streaming) {
+		slot = my_block_slot(st);
+		if (!slot) {
+			st->blk_overrun = true;
+			st->blk_dropped++;
+		}
+	} else if (st->fifo_wm > 1) {
+		slot = my_fifo_slot(st);
+	}
+	if (slot)
+		st->scan = slot;
+
+	if (in)
+		my_inject_scan(st, in, ts);
+	else
+		my_gen_scan(st, ts);
+
+	if (!slot) {
+		if (!st->blk_streaming) {
+			iio_push_to_buffers_with_timestamp(indio_dev, st->scan, ts);
+			st->fifo_wakeups++;
+			st->fifo_scans++;
+		}
+		return;
+	}
+
+	st->scan = scan;
+	if (st->blk_streaming)
+		my_block_commit(st, slot, ts);
+	else
+		my_fifo_commit(st, slot, ts);
+}
+
+/*
+ * Entrega scans del anillo en orden. En modo paced solo los que ya vencieron
+ * según su timestamp rebasado al reloj IIO; en modo rápido hasta un lote
+ * completo por disparo.
+ */
+static void my_inject_drain(struct iio_dev *indio_dev, struct my_iio_state *st,
+			    s64 now)
+{
+	unsigned int head = smp_load_acquire(&st->ring_head);
+	unsigned int tail = st->ring_tail;
+	unsigned int n = 0;
+
+	while (tail != head && n < MY_MAX_BATCH) {
+		struct my_iio_inject_scan *in = &st->ring[tail & (st->ring_size - 1)];
+		s64 ts;
+
+		if (!st->replaying) {
+			st->replay_base = now - in->ts;
+			st->replaying = true;
+		}
+		ts = in->ts + st->replay_base;
+		if (st->inject_paced && ts > now)
+			break;
+
+		my_produce(indio_dev, st, in, ts);
+		tail++;
+		n++;
+	}
+
+	if (n) {
+		smp_store_release(&st->ring_tail, tail);
+		wake_up_interruptible(&st->inject_wq);
+	}
+}
+
+/*
+ * Bottom half del trigger. Con un trigger externo genera un scan por
+ * disparo, tomando el siguiente del anillo si hay. Con el trigger propio
+ * del generador pone al día todos los scans vencidos desde el disparo
+ * anterior, así las tasas por encima de 1/tick se entregan en lotes con
+ * timestamps espaciados por el periodo de muestreo. Mientras haya una
+ * reproducción en curso el anillo sustituye al reloj del generador.
+ */
+static irqreturn_t my_trigger_handler(int irq, void *p)
+{
+	struct iio_poll_func *pf = p;
+	struct iio_dev *indio_dev = pf->indio_dev;
+	struct my_iio_state *st = iio_priv(indio_dev);
+	unsigned int n = 0;
+	s64 now;
+
+	mutex_lock(&st->lock);
+	if (indio_dev->trig != st->trig) {
+		if (my_inject_count(st)) {
+			my_produce(indio_dev, st,
+				   &st->ring[st->ring_tail & (st->ring_size - 1)],
+				   pf->timestamp);
+			smp_store_release(&st->ring_tail, st->ring_tail + 1);
+			wake_up_interruptible(&st->inject_wq);
+		} else {
+			my_produce(indio_dev, st, NULL, pf->timestamp);
+		}
+		goto out;
+	}
+
+	now = iio_get_time_ns(indio_dev);
+	if (st->inject_open || my_inject_count(st)) {
+		my_inject_drain(indio_dev, st, now);
+		st->next_ts = now + st->samp_period_ns;
+		goto out;
+	}
+	st->replaying = false;
+
+	while (st->next_ts <= now && n++ < MY_MAX_BATCH) {
+		my_produce(indio_dev, st, NULL, st->next_ts);
+		st->next_ts += st->samp_period_ns;
+	}
+	/* Demasiado atrasados: se descarta el hueco en vez de acumularlo */
+	if (st->next_ts <= now)
+		st->next_ts = now + st->samp_period_ns;
+out:
+	mutex_unlock(&st->lock);
+	iio_trigger_notify_done(indio_dev->trig);
+	return IRQ_HANDLED;
+}
+
+static enum hrtimer_restart my_gen_hrtimer(struct hrtimer *t)
+{
+	struct my_iio_state *st = container_of(t, struct my_iio_state, timer);
+
+	iio_trigger_poll(st->trig);
+	hrtimer_forward_now(t, READ_ONCE(st->tick));
+	return HRTIMER_RESTART;
+}
+
+static int my_gen_set_trigger_state(struct iio_trigger *trig, bool state)
+{
+	struct iio_dev *indio_dev = iio_trigger_get_drvdata(trig);
+	struct my_iio_state *st = iio_priv(indio_dev);
+
+	if (!state) {
+		hrtimer_cancel(&st->timer);
+		return 0;
+	}
+
+	mutex_lock(&st->lock);
+	st->next_ts = iio_get_time_ns(indio_dev);
+	mutex_unlock(&st->lock);
+	hrtimer_start(&st->timer, st->tick, HRTIMER_MODE_REL_HARD);
+	return 0;
+}
+
+static const struct iio_trigger_ops my_trigger_ops = {
+	.set_trigger_state = my_gen_set_trigger_state,
+};
+
+/* --- ext_info: forma de onda y frecuencia por canal --- */
+static int my_get_waveform(struct iio_dev *indio_dev,
+			   const struct iio_chan_spec *chan)
+{
+	struct my_iio_state *st = iio_priv(indio_dev);
+
+	return st->gen[chan->channel].wave;
+}
+
+static int my_set_waveform(struct iio_dev *indio_dev,
+			   const struct iio_chan_spec *chan, unsigned int mode)
+{
+	struct my_iio_state *st = iio_priv(indio_dev);
+
+	mutex_lock(&st->lock);
+	st->gen[chan->channel].wave = mode;
+	mutex_unlock(&st->lock);
+	return 0;
+}
+
+static const struct iio_enum my_waveform_enum = {
+	.items = my_waveform_names,
+	.num_items = ARRAY_SIZE(my_waveform_names),
+	.get = my_get_waveform,
+	.set = my_set_waveform,
+};
+
+static ssize_t my_read_wave_freq(struct iio_dev *indio_dev, uintptr_t priv,
+				 const struct iio_chan_spec *chan, char *buf)
+{
+	struct my_iio_state *st = iio_priv(indio_dev);
+
+	return sysfs_emit(buf, "%u\n", st->gen[chan->channel].freq_hz);
+}
+
+static ssize_t my_write_wave_freq(struct iio_dev *indio_dev, uintptr_t priv,
+				  const struct iio_chan_spec *chan,
+				  const char *buf, size_t len)
+{
+	struct my_iio_state *st = iio_priv(indio_dev);
+	struct my_iio_gen *g = &st->gen[chan->channel];
+	unsigned int hz;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &hz);
+	if (ret)
+		return ret;
+
+	mutex_lock(&st->lock);
+	g->freq_hz = hz;
+	my_gen_update_inc(st, g);
+	mutex_unlock(&st->lock);
+	return len;
+}
+
+static int my_get_os_mode(struct iio_dev *indio_dev,
+			  const struct iio_chan_spec *chan)
+{
+	struct my_iio_state *st = iio_priv(indio_dev);
+
+	return st->os_mode;
+}
+
+static int my_set_os_mode(struct iio_dev *indio_dev,
+			  const struct iio_chan_spec *chan, unsigned int mode)
+{
+	struct my_iio_state *st = iio_priv(indio_dev);
+
+	mutex_lock(&st->lock);
+	st->os_mode = mode;
+	mutex_unlock(&st->lock);
+	return 0;
+}
+
+static const struct iio_enum my_os_mode_enum = {
+	.items = my_os_mode_names,
+	.num_items = ARRAY_SIZE(my_os_mode_names),
+	.get = my_get_os_mode,
+	.set = my_set_os_mode,
+};
+
+static const struct iio_chan_spec_ext_info my_ext_info[] = {
+	IIO_ENUM("waveform", IIO_SEPARATE, &my_waveform_enum),
+	IIO_ENUM_AVAILABLE("waveform", IIO_SHARED_BY_TYPE, &my_waveform_enum),
+	IIO_ENUM("oversampling_mode", IIO_SHARED_BY_ALL, &my_os_mode_enum),
+	IIO_ENUM_AVAILABLE("oversampling_mode", IIO_SHARED_BY_ALL, &my_os_mode_enum),
+	{
+		.name = "waveform_frequency",
+		.shared = IIO_SEPARATE,
+		.read = my_read_wave_freq,
+		.write = my_write_wave_freq,
+	},
+	{ }
+};
+
+static ssize_t inject_store(struct device *dev,
+			    struct device_attribute *attr,
+			    const char *buf, size_t len)
+{
+	struct my_iio_state *st = iio_priv(dev_to_iio_dev(dev));
+	s64 ts = iio_get_time_ns(dev_to_iio_dev(dev));
+	int val, i, ret;
+
+	ret = kstrtoint(buf, 0, &val);
+	if (ret)
+		return ret;
+
+	mutex_lock(&st->lock);
+	for (i = 0; i < st->num_channels; i++) {
+		WRITE_ONCE(st->gen[i].inject, val);
+		if (st->gen[i].wave == MY_WAVE_INJECT)
+			my_event_check(st, i, val, ts);
+	}
+	mutex_unlock(&st->lock);
+	return len;
+}
+
+static DEVICE_ATTR_WO(inject);
+
+static ssize_t inject_pacing_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	struct my_iio_state *st = iio_priv(dev_to_iio_dev(dev));
+
+	return sysfs_emit(buf, "%s\n", st->inject_paced ? "paced" : "fast");
+}
+
+static ssize_t inject_pacing_store(struct device *dev,
+				   struct device_attribute *attr,
+				   const char *buf, size_t len)
+{
+	struct my_iio_state *st = iio_priv(dev_to_iio_dev(dev));
+	bool paced;
+
+	if (sysfs_streq(buf, "paced"))
+		paced = true;
+	else if (sysfs_streq(buf, "fast"))
+		paced = false;
+	else
+		return -EINVAL;
+
+	mutex_lock(&st->lock);
+	st->inject_paced = paced;
+	st->replaying = false;		/* rebasar con el próximo scan */
+	mutex_unlock(&st->lock);
+	return len;
+}
+
+static DEVICE_ATTR_RW(inject_pacing);
+
+static ssize_t inject_queued_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	struct my_iio_state *st = iio_priv(dev_to_iio_dev(dev));
 
-static int my_read_raw(struct iio_dev *indio_dev,
-		       struct iio_chan_spec const *chan,
-		       int *val, int *val2, long mask)
+	return sysfs_emit(buf, "%u\n",
+			  READ_ONCE(st->ring_head) - READ_ONCE(st->ring_tail));
+}
+
+static DEVICE_ATTR_RO(inject_queued);
+
+static ssize_t blocks_dropped_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
 {
-	if (mask == IIO_CHAN_INFO_RAW) {
-		*val = injected_value;
-		return IIO_VAL_INT;
-	}
-	return -EINVAL;
+	struct my_iio_state *st = iio_priv(dev_to_iio_dev(dev));
+
+	return sysfs_emit(buf, "%llu\n", READ_ONCE(st->blk_dropped));
 }
 
-static ssize_t inject_store(struct device *dev,
-			    struct device_attribute *attr,
-			    const char *buf, size_t len)
+static DEVICE_ATTR_RO(blocks_dropped);
+
+/* Despertares del lector: entregas al kfifo y scans por entrega */
+static ssize_t fifo_wakeups_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
 {
-	sscanf(buf, "%d", &injected_value);
-	return len;
+	struct my_iio_state *st = iio_priv(dev_to_iio_dev(dev));
+
+	return sysfs_emit(buf, "%llu\n", READ_ONCE(st->fifo_wakeups));
 }
 
-static DEVICE_ATTR_WO(inject);
+static DEVICE_ATTR_RO(fifo_wakeups);
+
+static ssize_t fifo_scans_show(struct device *dev,
+			       struct device_attribute *attr, char *buf)
+{
+	struct my_iio_state *st = iio_priv(dev_to_iio_dev(dev));
+
+	return sysfs_emit(buf, "%llu\n", READ_ONCE(st->fifo_scans));
+}
+
+static DEVICE_ATTR_RO(fifo_scans);
+
+static ssize_t fifo_timeouts_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	struct my_iio_state *st = iio_priv(dev_to_iio_dev(dev));
+
+	return sysfs_emit(buf, "%llu\n", READ_ONCE(st->fifo_timeouts));
+}
+
+static DEVICE_ATTR_RO(fifo_timeouts);
+
+static ssize_t fifo_scans_per_wakeup_show(struct device *dev,
+					  struct device_attribute *attr,
+					  char *buf)
+{
+	struct my_iio_state *st = iio_priv(dev_to_iio_dev(dev));
+	u64 w, n;
+
+	mutex_lock(&st->lock);
+	w = st->fifo_wakeups;
+	n = st->fifo_scans * 100;
+	mutex_unlock(&st->lock);
+	n = w ? div64_u64(n, w) : 0;
+
+	return sysfs_emit(buf, "%llu.%02llu\n", n / 100, n % 100);
+}
+
+static DEVICE_ATTR_RO(fifo_scans_per_wakeup);
 
 static struct attribute *my_attributes[] = {
 	&dev_attr_inject.attr,
+	&dev_attr_inject_pacing.attr,
+	&dev_attr_inject_queued.attr,
+	&dev_attr_blocks_dropped.attr,
+	&dev_attr_fifo_wakeups.attr,
+	&dev_attr_fifo_scans.attr,
+	&dev_attr_fifo_timeouts.attr,
+	&dev_attr_fifo_scans_per_wakeup.attr,
 	NULL,
 };
 
@@ -39,45 +1099,814 @@ static const struct attribute_group my_attr_group = {
 	.attrs = my_attributes,
 };
 
-static const struct iio_chan_spec my_channels[] = {
+/* --- char dev de inyección binaria --- */
+static struct my_iio_state *my_inject_state(struct file *f)
+{
+	return container_of(f->private_data, struct my_iio_state, inject_misc);
+}
+
+static unsigned int my_inject_space(struct my_iio_state *st)
+{
+	return st->ring_size - (st->ring_head - smp_load_acquire(&st->ring_tail));
+}
+
+static int my_inject_open(struct inode *i, struct file *f)
+{
+	struct my_iio_state *st = my_inject_state(f);
+
+	if (atomic_cmpxchg(&st->inject_busy, 0, 1))
+		return -EBUSY;
+
+	/* misc_open() con misc_mtx: el dispositivo sigue registrado */
+	iio_device_get(st->indio_dev);
+
+	mutex_lock(&st->lock);
+	st->inject_last_ts = S64_MIN;
+	st->inject_open = true;
+	st->replaying = false;
+	mutex_unlock(&st->lock);
+	return 0;
+}
+
+static int my_inject_release(struct inode *i, struct file *f)
+{
+	struct my_iio_state *st = my_inject_state(f);
+
+	mutex_lock(&st->lock);
+	st->inject_open = false;
+	mutex_unlock(&st->lock);
+	atomic_set(&st->inject_busy, 0);
+	/* Puede ser la última referencia si hubo unbind con el fd abierto */
+	iio_device_put(st->indio_dev);
+	return 0;
+}
+
+/*
+ * Copia un bloque entero al anillo, o nada. Sin bounce buffer: cada fila
+ * se copia directo de user space al slot y ring_head solo se publica al
+ * final. Espera a que quepa el bloque completo, salvo O_NONBLOCK.
+ */
+static int my_inject_block(struct my_iio_state *st, struct file *f,
+			   const struct my_iio_inject_block *hdr,
+			   const s32 __user *udata)
+{
+	size_t row = hdr->num_channels * sizeof(s32);
+	unsigned int head = st->ring_head;
+	unsigned int k;
+	int ret;
+
+	while (my_inject_space(st) < hdr->num_scans) {
+		if (READ_ONCE(st->inject_gone))
+			return -ENODEV;
+		if (f->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+		ret = wait_event_interruptible(st->inject_wq,
+					       my_inject_space(st) >= hdr->num_scans ||
+					       READ_ONCE(st->inject_gone));
+		if (ret)
+			return ret;
+	}
+	if (READ_ONCE(st->inject_gone))
+		return -ENODEV;
+
+	for (k = 0; k < hdr->num_scans; k++, head++) {
+		struct my_iio_inject_scan *s = &st->ring[head & (st->ring_size - 1)];
+
+		/* Sin publicar: el consumidor no ha visto nada del bloque */
+		if (copy_from_user(s->data, udata + k * hdr->num_channels, row))
+			return -EFAULT;
+		memset(&s->data[hdr->num_channels], 0, sizeof(s->data) - row);
+		s->ts = hdr->t0_ns + (s64)k * hdr->period_ns;
+	}
+	smp_store_release(&st->ring_head, head);
+	return 0;
+}
+
+static ssize_t my_inject_write_locked(struct my_iio_state *st, struct file *f,
+				      const char __user *buf, size_t len)
+{
+	struct my_iio_inject_block hdr;
+	size_t done = 0;
+	int ret;
+
+	while (len - done >= sizeof(hdr)) {
+		size_t payload;
+
+		if (copy_from_user(&hdr, buf + done, sizeof(hdr)))
+			return done ? done : -EFAULT;
+
+		/* Un bloque que no cabe en el anillo no podría entrar nunca */
+		if (hdr.magic != MY_IIO_INJECT_MAGIC || hdr.reserved ||
+		    !hdr.num_channels || hdr.num_channels > st->num_channels ||
+		    !hdr.num_scans || hdr.num_scans > st->ring_size)
+			return done ? done : -EINVAL;
+
+		payload = (size_t)hdr.num_scans * hdr.num_channels * sizeof(s32);
+		if (len - done - sizeof(hdr) < payload)
+			return done ? done : -EINVAL;
+
+		/* Los bloques deben llegar en orden de timestamp */
+		if (hdr.t0_ns < st->inject_last_ts)
+			return done ? done : -EINVAL;
+
+		/* Todo o nada: un reintento normal reenvía desde una cabecera */
+		ret = my_inject_block(st, f, &hdr,
+				      (const s32 __user *)(buf + done + sizeof(hdr)));
+		if (ret)
+			return done ? done : ret;
+
+		st->inject_last_ts = hdr.t0_ns + (s64)(hdr.num_scans - 1) * hdr.period_ns;
+		done += sizeof(hdr) + payload;
+	}
+
+	return done ? done : -EINVAL;
+}
+
+static ssize_t my_inject_write(struct file *f, const char __user *buf,
+			       size_t len, loff_t *off)
+{
+	struct my_iio_state *st = my_inject_state(f);
+	ssize_t ret;
+
+	mutex_lock(&st->inject_mutex);
+	ret = st->inject_gone ? -ENODEV : my_inject_write_locked(st, f, buf, len);
+	mutex_unlock(&st->inject_mutex);
+	return ret;
+}
+
+static __poll_t my_inject_poll(struct file *f, poll_table *wait)
+{
+	struct my_iio_state *st = my_inject_state(f);
+
+	poll_wait(f, &st->inject_wq, wait);
+	return my_inject_space(st) ? EPOLLOUT | EPOLLWRNORM : 0;
+}
+
+static const struct file_operations my_inject_fops = {
+	.owner   = THIS_MODULE,
+	.open    = my_inject_open,
+	.release = my_inject_release,
+	.write   = my_inject_write,
+	.poll    = my_inject_poll,
+	.llseek  = noop_llseek,
+};
+
+static void my_inject_free(void *data)
+{
+	struct my_iio_state *st = data;
+
+	memacct_sub(acct_ring, array_size(st->ring_size, sizeof(*st->ring)));
+	vfree(st->ring);
+}
+
+/* --- char dev del buffer de bloques --- */
+static struct my_iio_state *my_blk_state(struct file *f)
+{
+	return container_of(f->private_data, struct my_iio_state, blk_misc);
+}
+
+/* Área mapeable + descriptores, para la contabilidad */
+static size_t my_blk_bytes(struct my_iio_state *st)
+{
+	if (!st->blks)
+		return 0;
+	return st->blk_count *
+	       (PAGE_ALIGN(st->blks[0].desc.size) + sizeof(*st->blks));
+}
+
+/* Con st->lock tomado: el productor no puede estar dentro de un bloque */
+static void my_blk_free(struct my_iio_state *st)
+{
+	spin_lock(&st->blk_lock);
+	st->blk_streaming = false;
+	st->blk_cur = NULL;
+	INIT_LIST_HEAD(&st->blk_incoming);
+	INIT_LIST_HEAD(&st->blk_outgoing);
+	spin_unlock(&st->blk_lock);
+
+	memacct_sub(acct_blocks, my_blk_bytes(st));
+	kfree(st->blks);
+	st->blks = NULL;
+	st->blk_count = 0;
+	vfree(st->blk_mem);
+	st->blk_mem = NULL;
+	wake_up_interruptible(&st->blk_wq);
+}
+
+static int my_blk_alloc(struct my_iio_state *st,
+			struct my_iio_block_alloc_req *req)
+{
+	unsigned int i, count;
+	size_t stride;
+
+	if (req->type || req->size < st->scan_size || req->size > SZ_16M ||
+	    !req->count)
+		return -EINVAL;
+	if (st->blks)
+		return -EBUSY;
+
+	count = min_t(u32, req->count, MY_IIO_BLOCK_MAX_COUNT);
+	stride = PAGE_ALIGN(req->size);
+
+	/* vmalloc_user: en ceros y apto para remap_vmalloc_range() */
+	st->blk_mem = vmalloc_user(stride * count);
+	if (!st->blk_mem)
+		return -ENOMEM;
+	st->blks = kcalloc(count, sizeof(*st->blks), GFP_KERNEL);
+	if (!st->blks) {
+		vfree(st->blk_mem);
+		st->blk_mem = NULL;
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < count; i++) {
+		struct my_iio_blk *b = &st->blks[i];
+
+		b->desc.id = i;
+		b->desc.size = req->size;
+		b->desc.offset = (u64)i * stride;
+		b->state = MY_BLK_DEQUEUED;
+		INIT_LIST_HEAD(&b->head);
+	}
+	st->blk_count = count;
+	st->blk_overrun = false;
+	st->blk_streaming = true;
+	memacct_add(acct_blocks, my_blk_bytes(st));
+	req->count = count;
+	return 0;
+}
+
+static int my_blk_enqueue(struct my_iio_state *st, struct my_iio_block *desc)
+{
+	struct my_iio_blk *b;
+	int ret = 0;
+
+	if (desc->id >= st->blk_count)
+		return -EINVAL;
+	b = &st->blks[desc->id];
+
+	spin_lock(&st->blk_lock);
+	if (b->state != MY_BLK_DEQUEUED) {
+		ret = -EBUSY;
+	} else {
+		b->state = MY_BLK_QUEUED;
+		b->desc.bytes_used = 0;
+		list_add_tail(&b->head, &st->blk_incoming);
+		*desc = b->desc;
+	}
+	spin_unlock(&st->blk_lock);
+	return ret;
+}
+
+static int my_blk_dequeue(struct my_iio_state *st, struct file *f,
+			  struct my_iio_block *desc)
+{
+	struct my_iio_blk *b;
+	int ret;
+
+	for (;;) {
+		mutex_lock(&st->lock);
+		if (!st->blks) {
+			mutex_unlock(&st->lock);
+			return -EINVAL;
+		}
+		spin_lock(&st->blk_lock);
+		b = list_first_entry_or_null(&st->blk_outgoing,
+					     struct my_iio_blk, head);
+		if (b) {
+			list_del_init(&b->head);
+			b->state = MY_BLK_DEQUEUED;
+			*desc = b->desc;
+		}
+		spin_unlock(&st->blk_lock);
+		mutex_unlock(&st->lock);
+		if (b)
+			return 0;
+
+		if (f->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+		ret = wait_event_interruptible(st->blk_wq,
+					       !list_empty_careful(&st->blk_outgoing) ||
+					       !READ_ONCE(st->blk_streaming));
+		if (ret)
+			return ret;
+	}
+}
+
+static long my_blk_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
+{
+	struct my_iio_state *st = my_blk_state(f);
+	void __user *up = (void __user *)arg;
+	int ret;
+
+	switch (cmd) {
+
+	case MY_IIO_BLOCK_ALLOC: {
+		struct my_iio_block_alloc_req req;
+
+		if (copy_from_user(&req, up, sizeof(req)))
+			return -EFAULT;
+		mutex_lock(&st->lock);
+		ret = st->blk_gone ? -ENODEV : my_blk_alloc(st, &req);
+		mutex_unlock(&st->lock);
+		if (ret)
+			return ret;
+		if (copy_to_user(up, &req, sizeof(req)))
+			return -EFAULT;
+		return 0;
+	}
+
+	case MY_IIO_BLOCK_FREE:
+		/* mmap() cuenta bajo st->lock: nadie mapea entre la comprobación y el free */
+		mutex_lock(&st->lock);
+		ret = atomic_read(&st->blk_mapped) ? -EBUSY : 0;
+		if (!ret)
+			my_blk_free(st);
+		mutex_unlock(&st->lock);
+		return ret;
+
+	case MY_IIO_BLOCK_QUERY: {
+		struct my_iio_block desc;
+
+		if (copy_from_user(&desc, up, sizeof(desc)))
+			return -EFAULT;
+		mutex_lock(&st->lock);
+		ret = desc.id < st->blk_count ? 0 : -EINVAL;
+		if (!ret)
+			desc = st->blks[desc.id].desc;
+		mutex_unlock(&st->lock);
+		if (ret)
+			return ret;
+		if (copy_to_user(up, &desc, sizeof(desc)))
+			return -EFAULT;
+		return 0;
+	}
+
+	case MY_IIO_BLOCK_ENQUEUE: {
+		struct my_iio_block desc;
+
+		if (copy_from_user(&desc, up, sizeof(desc)))
+			return -EFAULT;
+		mutex_lock(&st->lock);
+		ret = my_blk_enqueue(st, &desc);
+		mutex_unlock(&st->lock);
+		if (ret)
+			return ret;
+		if (copy_to_user(up, &desc, sizeof(desc)))
+			return -EFAULT;
+		return 0;
+	}
+
+	case MY_IIO_BLOCK_DEQUEUE: {
+		struct my_iio_block desc;
+
+		ret = my_blk_dequeue(st, f, &desc);
+		if (ret)
+			return ret;
+		if (copy_to_user(up, &desc, sizeof(desc)))
+			return -EFAULT;
+		return 0;
+	}
+
+	default:
+		return -ENOTTY;
+	}
+}
+
+static void my_blk_vma_open(struct vm_area_struct *vma)
+{
+	struct my_iio_state *st = vma->vm_private_data;
+
+	atomic_inc(&st->blk_mapped);
+}
+
+static void my_blk_vma_close(struct vm_area_struct *vma)
+{
+	struct my_iio_state *st = vma->vm_private_data;
+
+	atomic_dec(&st->blk_mapped);
+}
+
+static const struct vm_operations_struct my_blk_vm_ops = {
+	.open  = my_blk_vma_open,
+	.close = my_blk_vma_close,
+};
+
+static int my_blk_mmap(struct file *f, struct vm_area_struct *vma)
+{
+	struct my_iio_state *st = my_blk_state(f);
+	int ret;
+
+	mutex_lock(&st->lock);
+	if (!st->blk_mem || st->blk_gone)
+		ret = -ENODEV;
+	else
+		ret = remap_vmalloc_range(vma, st->blk_mem, vma->vm_pgoff);
+	if (!ret) {
+		vma->vm_ops = &my_blk_vm_ops;
+		vma->vm_private_data = st;
+		my_blk_vma_open(vma);
+	}
+	mutex_unlock(&st->lock);
+	return ret;
+}
+
+static __poll_t my_blk_poll(struct file *f, poll_table *wait)
+{
+	struct my_iio_state *st = my_blk_state(f);
+
+	poll_wait(f, &st->blk_wq, wait);
+	return list_empty_careful(&st->blk_outgoing) ? 0 : EPOLLIN | EPOLLRDNORM;
+}
+
+static int my_blk_open(struct inode *i, struct file *f)
+{
+	struct my_iio_state *st = my_blk_state(f);
+
+	if (atomic_cmpxchg(&st->blk_busy, 0, 1))
+		return -EBUSY;
+	/* Como en la inyección: st vive hasta el release de este fd */
+	iio_device_get(st->indio_dev);
+	return 0;
+}
+
+/* Los mmap retienen el file: aquí ya no queda ningún mapeo */
+static int my_blk_release(struct inode *i, struct file *f)
+{
+	struct my_iio_state *st = my_blk_state(f);
+
+	mutex_lock(&st->lock);
+	my_blk_free(st);
+	mutex_unlock(&st->lock);
+	atomic_set(&st->blk_busy, 0);
+	iio_device_put(st->indio_dev);
+	return 0;
+}
+
+static const struct file_operations my_blk_fops = {
+	.owner          = THIS_MODULE,
+	.open           = my_blk_open,
+	.release        = my_blk_release,
+	.unlocked_ioctl = my_blk_ioctl,
+	.mmap           = my_blk_mmap,
+	.poll           = my_blk_poll,
+	.llseek         = noop_llseek,
+};
+
+/* Antes de desconectar el kfifo: el lote a medias llega al lector */
+static int my_buffer_predisable(struct iio_dev *indio_dev)
+{
+	struct my_iio_state *st = iio_priv(indio_dev);
+
+	mutex_lock(&st->lock);
+	my_fifo_flush(st, st->fifo_n);
+	mutex_unlock(&st->lock);
+	return 0;
+}
+
+static int my_buffer_postdisable(struct iio_dev *indio_dev)
+{
+	struct my_iio_state *st = iio_priv(indio_dev);
+
+	cancel_delayed_work_sync(&st->fifo_work);
+	mutex_lock(&st->lock);
+	st->fifo_n = 0;
+	my_block_flush(st);
+	mutex_unlock(&st->lock);
+	return 0;
+}
+
+static const struct iio_buffer_setup_ops my_buffer_ops = {
+	.predisable = my_buffer_predisable,
+	.postdisable = my_buffer_postdisable,
+};
+
+/*
+ * buffer0/hwfifo_*: el watermark lo fija el core al habilitar el buffer
+ * (buffer0/watermark); hwfifo_timeout_ms acota la espera del lote.
+ */
+static ssize_t hwfifo_enabled_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct iio_dev *indio_dev = dev_to_iio_dev(dev);
+	struct my_iio_state *st = iio_priv(indio_dev);
+
+	return sysfs_emit(buf, "%d\n", iio_buffer_enabled(indio_dev) &&
+			  READ_ONCE(st->fifo_wm) > 1);
+}
+
+static ssize_t hwfifo_watermark_show(struct device *dev,
+				     struct device_attribute *attr, char *buf)
+{
+	struct my_iio_state *st = iio_priv(dev_to_iio_dev(dev));
+
+	return sysfs_emit(buf, "%u\n", READ_ONCE(st->fifo_wm));
+}
+
+static ssize_t hwfifo_timeout_ms_show(struct device *dev,
+				      struct device_attribute *attr, char *buf)
+{
+	struct my_iio_state *st = iio_priv(dev_to_iio_dev(dev));
+
+	return sysfs_emit(buf, "%u\n", READ_ONCE(st->fifo_timeout_ms));
+}
+
+static ssize_t hwfifo_timeout_ms_store(struct device *dev,
+				       struct device_attribute *attr,
+				       const char *buf, size_t len)
+{
+	struct my_iio_state *st = iio_priv(dev_to_iio_dev(dev));
+	unsigned int ms;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &ms);
+	if (ret)
+		return ret;
+	if (!ms || ms > MSEC_PER_SEC * 60)
+		return -EINVAL;
+
+	mutex_lock(&st->lock);
+	st->fifo_timeout_ms = ms;
+	mutex_unlock(&st->lock);
+	return len;
+}
+
+static IIO_STATIC_CONST_DEVICE_ATTR(hwfifo_watermark_min, "1");
+static IIO_STATIC_CONST_DEVICE_ATTR(hwfifo_watermark_max, __stringify(MY_FIFO_MAX));
+static IIO_DEVICE_ATTR_RO(hwfifo_enabled, 0);
+static IIO_DEVICE_ATTR_RO(hwfifo_watermark, 0);
+static IIO_DEVICE_ATTR_RW(hwfifo_timeout_ms, 0);
+
+static const struct iio_dev_attr *my_fifo_attributes[] = {
+	&iio_dev_attr_hwfifo_watermark_min,
+	&iio_dev_attr_hwfifo_watermark_max,
+	&iio_dev_attr_hwfifo_enabled,
+	&iio_dev_attr_hwfifo_watermark,
+	&iio_dev_attr_hwfifo_timeout_ms,
+	NULL,
+};
+
+static const struct iio_event_spec my_events[] = {
+	{
+		.type = IIO_EV_TYPE_THRESH,
+		.dir = IIO_EV_DIR_RISING,
+		.mask_separate = BIT(IIO_EV_INFO_VALUE) |
+				 BIT(IIO_EV_INFO_HYSTERESIS) |
+				 BIT(IIO_EV_INFO_ENABLE),
+	},
 	{
-		.type = IIO_VOLTAGE,
-		.indexed = 1,
-		.channel = 0,
-		.info_mask_separate = BIT(IIO_CHAN_INFO_RAW),
+		.type = IIO_EV_TYPE_THRESH,
+		.dir = IIO_EV_DIR_FALLING,
+		.mask_separate = BIT(IIO_EV_INFO_VALUE) |
+				 BIT(IIO_EV_INFO_HYSTERESIS) |
+				 BIT(IIO_EV_INFO_ENABLE),
 	},
 };
 
+/* Formas de onda por defecto; se repiten cada 4 canales */
+static const struct my_iio_gen my_gen_defaults[] = {
+	{ .wave = MY_WAVE_INJECT },
+	{ .wave = MY_WAVE_SINE,   .freq_hz = 50 },
+	{ .wave = MY_WAVE_SQUARE, .freq_hz = 10 },
+	{ .wave = MY_WAVE_NOISE },
+};
+
+/*
+ * Canales de voltaje + timestamp. Las muestras van empaquetadas a
+ * scan_bits y el timestamp queda alineado a 8 tras ellas.
+ */
+static int my_init_channels(struct device *dev, struct iio_dev *indio_dev,
+			    struct my_iio_state *st)
+{
+	unsigned int i, n = st->num_channels;
+	struct iio_chan_spec *chans;
+
+	chans = memacct_devm_kcalloc(acct_ctx, dev, n + 1, sizeof(*chans),
+				     GFP_KERNEL);
+	if (!chans)
+		return -ENOMEM;
+
+	for (i = 0; i < n; i++) {
+		chans[i] = (struct iio_chan_spec){
+			.type = IIO_VOLTAGE,
+			.indexed = 1,
+			.channel = i,
+			.info_mask_separate = BIT(IIO_CHAN_INFO_RAW),
+			.info_mask_shared_by_all =
+				BIT(IIO_CHAN_INFO_SAMP_FREQ) |
+				BIT(IIO_CHAN_INFO_OVERSAMPLING_RATIO),
+			.info_mask_shared_by_all_available =
+				BIT(IIO_CHAN_INFO_OVERSAMPLING_RATIO),
+			.ext_info = my_ext_info,
+			.event_spec = my_events,
+			.num_event_specs = ARRAY_SIZE(my_events),
+			.scan_index = i,
+			.scan_type = {
+				.sign = 's',
+				.realbits = st->storage_bytes * 8,
+				.storagebits = st->storage_bytes * 8,
+				.endianness = IIO_CPU,
+			},
+		};
+	}
+	chans[n] = (struct iio_chan_spec)IIO_CHAN_SOFT_TIMESTAMP(n);
+
+	/* Siempre se generan todos los canales; el core demultiplexa el resto */
+	st->scan_masks[0] = GENMASK(n - 1, 0);
+	st->scan_masks[1] = 0;
+
+	st->scan_size = ALIGN(n * st->storage_bytes, sizeof(s64)) + sizeof(s64);
+	st->scan = memacct_devm_kzalloc(acct_ctx, dev, st->scan_size, GFP_KERNEL);
+	if (!st->scan)
+		return -ENOMEM;
+
+	indio_dev->channels = chans;
+	indio_dev->num_channels = n + 1;
+	indio_dev->available_scan_masks = st->scan_masks;
+	return 0;
+}
+
 static const struct iio_info my_iio_info = {
 	.read_raw = my_read_raw,
+	.read_avail = my_read_avail,
+	.write_raw = my_write_raw,
+	.read_event_config = my_read_event_config,
+	.write_event_config = my_write_event_config,
+	.read_event_value = my_read_event_value,
+	.write_event_value = my_write_event_value,
+	.hwfifo_set_watermark = my_hwfifo_set_watermark,
+	.hwfifo_flush_to_buffer = my_hwfifo_flush_to_buffer,
 };
 
 static int my_probe(struct platform_device *pdev)
 {
 	struct iio_dev *indio_dev;
+	struct my_iio_state *st;
+	unsigned int i;
+	int ret;
 
-	indio_dev = devm_iio_device_alloc(&pdev->dev, 0);
+	if (!num_channels || num_channels > MY_MAX_CHANNELS ||
+	    (scan_bits != 16 && scan_bits != 32))
+		return -EINVAL;
+
+	indio_dev = devm_iio_device_alloc(&pdev->dev, sizeof(struct my_iio_state));
 	if (!indio_dev)
 		return -ENOMEM;
 
+	st = iio_priv(indio_dev);
+	st->indio_dev = indio_dev;
+	mutex_init(&st->lock);
+	st->num_channels = num_channels;
+	st->storage_bytes = scan_bits / 8;
+	st->amplitude = min_t(unsigned int, gen_amplitude, S16_MAX);
+	st->noise = 0x2545f491;
+	for (i = 0; i < st->num_channels; i++)
+		st->gen[i] = my_gen_defaults[i % ARRAY_SIZE(my_gen_defaults)];
+	my_set_samp_freq(st, 1000);
+
+	st->os_buf = memacct_devm_kcalloc(acct_ctx, &pdev->dev,
+					  1U << MY_MAX_OSR_SHIFT,
+					  sizeof(*st->os_buf), GFP_KERNEL);
+	if (!st->os_buf)
+		return -ENOMEM;
+
+	st->ring_size = roundup_pow_of_two(clamp(inject_ring_scans, 16U, 1U << 24));
+	st->ring = vzalloc(array_size(st->ring_size, sizeof(*st->ring)));
+	if (!st->ring)
+		return -ENOMEM;
+	memacct_add(acct_ring, array_size(st->ring_size, sizeof(*st->ring)));
+	ret = devm_add_action_or_reset(&pdev->dev, my_inject_free, st);
+	if (ret)
+		return ret;
+	init_waitqueue_head(&st->inject_wq);
+	mutex_init(&st->inject_mutex);
+	atomic_set(&st->inject_busy, 0);
+	st->inject_paced = true;
+
+	spin_lock_init(&st->blk_lock);
+	INIT_LIST_HEAD(&st->blk_incoming);
+	INIT_LIST_HEAD(&st->blk_outgoing);
+	init_waitqueue_head(&st->blk_wq);
+	atomic_set(&st->blk_busy, 0);
+	atomic_set(&st->blk_mapped, 0);
+
+	st->fifo_wm = 1;
+	st->fifo_timeout_ms = 100;
+	INIT_DELAYED_WORK(&st->fifo_work, my_fifo_timeout);
+
+	hrtimer_init(&st->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL_HARD);
+	st->timer.function = my_gen_hrtimer;
+
 	indio_dev->name = DRIVER_NAME;
 	indio_dev->modes = INDIO_DIRECT_MODE;
 	indio_dev->info = &my_iio_info;
-	indio_dev->channels = my_channels;
-	indio_dev->num_channels = ARRAY_SIZE(my_channels);
+	ret = my_init_channels(&pdev->dev, indio_dev, st);
+	if (ret)
+		return ret;
+
+	st->fifo = memacct_devm_kcalloc(acct_ctx, &pdev->dev, MY_FIFO_MAX,
+					st->scan_size, GFP_KERNEL);
+	if (!st->fifo)
+		return -ENOMEM;
+
+	/* Trigger propio: el hrtimer del generador a sampling_frequency */
+	st->trig = devm_iio_trigger_alloc(&pdev->dev, "%s-dev%d",
+					  indio_dev->name,
+					  iio_device_id(indio_dev));
+	if (!st->trig)
+		return -ENOMEM;
+	st->trig->ops = &my_trigger_ops;
+	iio_trigger_set_drvdata(st->trig, indio_dev);
+	ret = devm_iio_trigger_register(&pdev->dev, st->trig);
+	if (ret)
+		return dev_err_probe(&pdev->dev, ret, "trigger register\n");
+	indio_dev->trig = iio_trigger_get(st->trig);
+
+	/*
+	 * kfifo + pollfunc: añade INDIO_BUFFER_TRIGGERED a modes. Por defecto
+	 * usa el trigger del generador; se puede cambiar a cualquier otro
+	 * (iio-trig-hrtimer, iio-trig-sysfs, ...) desde userspace.
+	 */
+	ret = devm_iio_triggered_buffer_setup_ext(&pdev->dev, indio_dev,
+						  iio_pollfunc_store_time,
+						  my_trigger_handler,
+						  IIO_BUFFER_DIRECTION_IN,
+						  &my_buffer_ops,
+						  my_fifo_attributes);
+	if (ret)
+		return dev_err_probe(&pdev->dev, ret, "triggered buffer\n");
 
 	platform_set_drvdata(pdev, indio_dev);
-	iio_device_register(indio_dev);
+	ret = iio_device_register(indio_dev);
+	if (ret)
+		return ret;
 	sysfs_create_group(&indio_dev->dev.kobj, &my_attr_group);
 
+	st->inject_misc.minor = MISC_DYNAMIC_MINOR;
+	st->inject_misc.name = DRIVER_NAME "_inject";
+	st->inject_misc.fops = &my_inject_fops;
+	st->inject_misc.parent = &pdev->dev;
+	ret = misc_register(&st->inject_misc);
+	if (ret)
+		goto err_unregister;
+
+	st->blk_misc.minor = MISC_DYNAMIC_MINOR;
+	st->blk_misc.name = DRIVER_NAME "_blocks";
+	st->blk_misc.fops = &my_blk_fops;
+	st->blk_misc.parent = &pdev->dev;
+	ret = misc_register(&st->blk_misc);
+	if (ret)
+		goto err_inject;
+
 	return 0;
+
+err_inject:
+	misc_deregister(&st->inject_misc);
+err_unregister:
+	sysfs_remove_group(&indio_dev->dev.kobj, &my_attr_group);
+	iio_device_unregister(indio_dev);
+	return ret;
 }
 
 static int my_remove(struct platform_device *pdev)
 {
 	struct iio_dev *indio_dev = platform_get_drvdata(pdev);
+	struct my_iio_state *st = iio_priv(indio_dev);
+
+	misc_deregister(&st->blk_misc);
+	misc_deregister(&st->inject_misc);
+
+	/*
+	 * Un fd de inyección abierto sobrevive al unbind (retiene st con
+	 * iio_device_get()), pero el anillo lo libera devres: se echa al
+	 * escritor y se espera a que salga.
+	 */
+	WRITE_ONCE(st->inject_gone, true);
+	wake_up_interruptible(&st->inject_wq);
+	mutex_lock(&st->inject_mutex);
+	mutex_unlock(&st->inject_mutex);
+
 	sysfs_remove_group(&indio_dev->dev.kobj, &my_attr_group);
 	iio_device_unregister(indio_dev);
+	hrtimer_cancel(&st->timer);
+	cancel_delayed_work_sync(&st->fifo_work);
+
+	/*
+	 * Los bloques se paran aquí; con mapeos vivos la memoria espera al
+	 * release del fd, que llega cuando ya no queda ninguno.
+	 */
+	mutex_lock(&st->lock);
+	st->blk_gone = true;
+	if (atomic_read(&st->blk_mapped)) {
+		spin_lock(&st->blk_lock);
+		st->blk_streaming = false;
+		st->blk_cur = NULL;
+		spin_unlock(&st->blk_lock);
+		wake_up_interruptible(&st->blk_wq);
+	} else {
+		my_blk_free(st);
+	}
+	mutex_unlock(&st->lock);
 	return 0;
 }
 
@@ -86,26 +1915,60 @@ static struct platform_driver my_platform_driver = {
 	.remove = my_remove,
 	.driver = {
 		.name = DRIVER_NAME,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 
 static struct platform_device *my_device;
 
+static void my_acct_unregister(void)
+{
+	memacct_unregister(acct_blocks);
+	memacct_unregister(acct_ring);
+	memacct_unregister(acct_ctx);
+}
+
 static int __init my_init(void)
 {
+	int i, ret;
+
+	for (i = 0; i < MY_LUT_SIZE; i++)
+		my_sine_lut[i] = fixp_sin32_rad(i, MY_LUT_SIZE) >> 16;
+
+	acct_ctx = memacct_register(KBUILD_MODNAME, "ctx");
+	acct_ring = memacct_register(KBUILD_MODNAME, "inject_ring");
+	acct_blocks = memacct_register(KBUILD_MODNAME, "blocks");
+
+	ret = my_iio_blink_init();
+	if (ret) {
+		my_acct_unregister();
+		return ret;
+	}
+
 	my_device = platform_device_register_simple(DRIVER_NAME, -1, NULL, 0);
-	return platform_driver_register(&my_platform_driver);
+	ret = platform_driver_register(&my_platform_driver);
+	if (ret) {
+		my_iio_blink_exit();
+		my_acct_unregister();
+	}
+	return ret;
 }
 
 static void __exit my_exit(void)
 {
 	platform_driver_unregister(&my_platform_driver);
 	platform_device_unregister(my_device);
+	my_iio_blink_exit();
+	my_acct_unregister();
 }
 
 module_init(my_init);
 module_exit(my_exit);
 
+#ifdef MY_KUNIT
+#include "myiiodr_kunit.c"
+#endif
+
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("Tu Nombre");
-MODULE_DESCRIPTION("Dummy IIO driver con entrada por sysfs");
+MODULE_DESCRIPTION("Dummy IIO driver con generador, inyección binaria y buffer disparado");
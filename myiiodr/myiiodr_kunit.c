@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * KUnit: ruta de my_read_raw() sobre un iio_dev sin registrar.
+ * Se incluye al final de myiiodr.c con "make KUNIT=1".
+ */
+#include "kbench.h"
+
+static int my_test_init(struct kunit *test)
+{
+	struct iio_dev *indio_dev;
+	struct my_iio_state *st;
+
+	indio_dev = iio_device_alloc(NULL, sizeof(*st));
+	if (!indio_dev)
+		return -ENOMEM;
+
+	st = iio_priv(indio_dev);
+	st->indio_dev = indio_dev;
+	mutex_init(&st->lock);
+	st->num_channels = 1;
+	st->amplitude = 1000;
+	st->noise = 0x2545f491;
+	st->gen[0] = my_gen_defaults[0];
+	st->os_buf = kunit_kcalloc(test, 1U << MY_MAX_OSR_SHIFT,
+				   sizeof(*st->os_buf), GFP_KERNEL);
+	st->storage_bytes = sizeof(s32);
+	st->scan_size = ALIGN(st->storage_bytes, sizeof(s64)) + sizeof(s64);
+	st->scan = kunit_kzalloc(test, st->scan_size, GFP_KERNEL);
+	st->fifo = kunit_kcalloc(test, MY_FIFO_MAX, st->scan_size, GFP_KERNEL);
+	if (!st->os_buf || !st->scan || !st->fifo) {
+		iio_device_free(indio_dev);
+		return -ENOMEM;
+	}
+	st->fifo_wm = 1;
+	st->fifo_timeout_ms = 60000;	/* que no salte durante el caso */
+	INIT_DELAYED_WORK(&st->fifo_work, my_fifo_timeout);
+	my_set_samp_freq(st, 1000);
+
+	test->priv = indio_dev;
+	return 0;
+}
+
+static void my_test_exit(struct kunit *test)
+{
+	struct my_iio_state *st = iio_priv(test->priv);
+
+	cancel_delayed_work_sync(&st->fifo_work);
+	iio_device_free(test->priv);
+}
+
+static const struct iio_chan_spec my_test_chan = {
+	.type = IIO_VOLTAGE,
+	.indexed = 1,
+	.channel = 0,
+};
+
+static void my_test_read_square(struct kunit *test)
+{
+	struct iio_dev *indio_dev = test->priv;
+	struct my_iio_state *st = iio_priv(indio_dev);
+	int val = 0, val2 = 0;
+
+	st->gen[0].wave = MY_WAVE_SQUARE;
+	st->gen[0].phase = 0;
+
+	KUNIT_EXPECT_EQ(test, my_read_raw(indio_dev, &my_test_chan, &val, &val2,
+					  IIO_CHAN_INFO_RAW), IIO_VAL_INT);
+	KUNIT_EXPECT_EQ(test, val, 1000);
+
+	/* Medio ciclo después la cuadrada está abajo */
+	st->gen[0].phase = 0x80000000;
+	my_read_raw(indio_dev, &my_test_chan, &val, &val2, IIO_CHAN_INFO_RAW);
+	KUNIT_EXPECT_EQ(test, val, -1000);
+}
+
+static void my_test_read_sine(struct kunit *test)
+{
+	struct iio_dev *indio_dev = test->priv;
+	struct my_iio_state *st = iio_priv(indio_dev);
+	int val, val2;
+
+	st->gen[0].wave = MY_WAVE_SINE;
+
+	st->gen[0].phase = 0;
+	my_read_raw(indio_dev, &my_test_chan, &val, &val2, IIO_CHAN_INFO_RAW);
+	KUNIT_EXPECT_EQ(test, val, 0);
+
+	/* Pico en un cuarto de ciclo, con el error de la tabla Q15 */
+	st->gen[0].phase = 0x40000000;
+	my_read_raw(indio_dev, &my_test_chan, &val, &val2, IIO_CHAN_INFO_RAW);
+	KUNIT_EXPECT_GE(test, val, 999);
+	KUNIT_EXPECT_LE(test, val, 1000);
+}
+
+static void my_test_read_oversampled(struct kunit *test)
+{
+	struct iio_dev *indio_dev = test->priv;
+	struct my_iio_state *st = iio_priv(indio_dev);
+	int val, val2;
+
+	st->gen[0].wave = MY_WAVE_SQUARE;
+	st->gen[0].phase = 0;
+	KUNIT_ASSERT_EQ(test, my_write_raw(indio_dev, &my_test_chan, 4, 0,
+					   IIO_CHAN_INFO_OVERSAMPLING_RATIO), 0);
+	my_read_raw(indio_dev, &my_test_chan, &val, &val2,
+		    IIO_CHAN_INFO_OVERSAMPLING_RATIO);
+	KUNIT_EXPECT_EQ(test, val, 4);
+
+	/* 4 muestras en la mitad alta: la media es la amplitud */
+	my_read_raw(indio_dev, &my_test_chan, &val, &val2, IIO_CHAN_INFO_RAW);
+	KUNIT_EXPECT_EQ(test, val, 1000);
+}
+
+static void my_test_read_attrs(struct kunit *test)
+{
+	struct iio_dev *indio_dev = test->priv;
+	int val, val2;
+
+	KUNIT_EXPECT_EQ(test, my_read_raw(indio_dev, &my_test_chan, &val, &val2,
+					  IIO_CHAN_INFO_SAMP_FREQ), IIO_VAL_INT);
+	KUNIT_EXPECT_EQ(test, val, 1000);
+	KUNIT_EXPECT_EQ(test, my_read_raw(indio_dev, &my_test_chan, &val, &val2,
+					  IIO_CHAN_INFO_SCALE), -EINVAL);
+}
+
+/* Sin buffers adjuntos iio_push_to_buffers() no hace nada: solo se cuentan */
+static void my_test_fifo_watermark(struct kunit *test)
+{
+	struct iio_dev *indio_dev = test->priv;
+	struct my_iio_state *st = iio_priv(indio_dev);
+	s64 *ts;
+	int i;
+
+	/* watermark 1: una entrega por scan, como antes */
+	my_produce(indio_dev, st, NULL, 1);
+	KUNIT_EXPECT_EQ(test, st->fifo_wakeups, 1ULL);
+	KUNIT_EXPECT_EQ(test, st->fifo_n, 0U);
+
+	my_hwfifo_set_watermark(indio_dev, 4);
+	for (i = 0; i < 3; i++)
+		my_produce(indio_dev, st, NULL, 10 + i);
+	KUNIT_EXPECT_EQ(test, st->fifo_n, 3U);
+	KUNIT_EXPECT_EQ(test, st->fifo_wakeups, 1ULL);
+
+	my_produce(indio_dev, st, NULL, 13);
+	KUNIT_EXPECT_EQ(test, st->fifo_n, 0U);
+	KUNIT_EXPECT_EQ(test, st->fifo_wakeups, 2ULL);
+	KUNIT_EXPECT_EQ(test, st->fifo_scans, 5ULL);
+
+	/* Entrega parcial: quedan los más recientes, en orden */
+	my_produce(indio_dev, st, NULL, 20);
+	my_produce(indio_dev, st, NULL, 21);
+	KUNIT_EXPECT_EQ(test, my_hwfifo_flush_to_buffer(indio_dev, 1), 1);
+	KUNIT_EXPECT_EQ(test, st->fifo_n, 1U);
+	ts = st->fifo + st->scan_size - sizeof(s64);
+	KUNIT_EXPECT_EQ(test, *ts, 21LL);
+
+	/* Timeout: entrega lo que haya */
+	my_fifo_timeout(&st->fifo_work.work);
+	KUNIT_EXPECT_EQ(test, st->fifo_n, 0U);
+	KUNIT_EXPECT_EQ(test, st->fifo_timeouts, 1ULL);
+	KUNIT_EXPECT_EQ(test, st->fifo_wakeups, 4ULL);
+	KUNIT_EXPECT_EQ(test, st->fifo_scans, 7ULL);
+
+	KUNIT_EXPECT_EQ(test, my_hwfifo_set_watermark(indio_dev, 100000), 0);
+	KUNIT_EXPECT_EQ(test, st->fifo_wm, (unsigned int)MY_FIFO_MAX);
+}
+
+static void my_bench_read_raw(struct kunit *test)
+{
+	struct iio_dev *indio_dev = test->priv;
+	struct my_iio_state *st = iio_priv(indio_dev);
+	int val, val2;
+
+	st->gen[0].wave = MY_WAVE_SINE;
+
+	KBENCH(test, "read_raw sine", 100000, 150, {
+		my_read_raw(indio_dev, &my_test_chan, &val, &val2,
+			    IIO_CHAN_INFO_RAW);
+		OPTIMIZER_HIDE_VAR(val);
+	});
+
+	/* 256 muestras por lectura: el coste del bloque de sobremuestreo */
+	st->osr_shift = MY_MAX_OSR_SHIFT;
+	my_gen_update_all(st);
+	KBENCH(test, "read_raw sine osr256", 20000, 1500, {
+		my_read_raw(indio_dev, &my_test_chan, &val, &val2,
+			    IIO_CHAN_INFO_RAW);
+		OPTIMIZER_HIDE_VAR(val);
+	});
+}
+
+static struct kunit_case my_test_cases[] = {
+	KUNIT_CASE(my_test_read_square),
+	KUNIT_CASE(my_test_read_sine),
+	KUNIT_CASE(my_test_read_oversampled),
+	KUNIT_CASE(my_test_read_attrs),
+	KUNIT_CASE(my_test_fifo_watermark),
+	KUNIT_CASE(my_bench_read_raw),
+	{}
+};
+
+static struct kunit_suite my_test_suite = {
+	.name = "my_iio_dummy",
+	.init = my_test_init,
+	.exit = my_test_exit,
+	.test_cases = my_test_cases,
+};
+kunit_test_suite(my_test_suite);
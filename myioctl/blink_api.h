@@ -1,13 +1,51 @@
 #ifndef BLINK_API_H
 #define BLINK_API_H
 
+#include <linux/notifier.h>
+
+#include "blink_genl.h"
+#include "blink_journal.h"
+
+/*
+ * Cada motor tiene una cadena de notificación (contexto de proceso) que
+ * recibe la acción BLINK_EV_* y una struct blink_event.
+ */
+struct blink_event {
+	u32 id;				/* BLINK_ID_* */
+	u32 val;			/* ms en PERIOD, BLINK_MODE_* en MODE */
+	u64 late, skipped, replayed;	/* OVERRUN, acumulados */
+};
+
+static inline void blink_notify(struct blocking_notifier_head *chain, u32 id,
+				unsigned long ev, u32 val)
+{
+	struct blink_event e = { .id = id, .val = val };
+
+	blocking_notifier_call_chain(chain, ev, &e);
+}
+
+/* blink_journal.ko: un registro por operación de control (BLINK_JOP_*) */
+void blink_journal_log(u16 op, u16 id, u32 val, s32 ret);
+
 int kthread_blink_nodt_set_period(unsigned int ms);
 int kthread_blink_nodt_get_period(unsigned int *ms);
+int kthread_blink_nodt_set_mode(unsigned int mode);
+int kthread_blink_nodt_get_mode(unsigned int *mode);
+int kthread_blink_nodt_register_notifier(struct notifier_block *nb);
+int kthread_blink_nodt_unregister_notifier(struct notifier_block *nb);
 
 int timer_blink_nodt_set_period(unsigned int ms);
 int timer_blink_nodt_get_period(unsigned int *ms);
+int timer_blink_nodt_set_mode(unsigned int mode);
+int timer_blink_nodt_get_mode(unsigned int *mode);
+int timer_blink_nodt_register_notifier(struct notifier_block *nb);
+int timer_blink_nodt_unregister_notifier(struct notifier_block *nb);
 
 int hrtimer_blink_nodt_set_period(unsigned int ms);
 int hrtimer_blink_nodt_get_period(unsigned int *ms);
+int hrtimer_blink_nodt_set_mode(unsigned int mode);
+int hrtimer_blink_nodt_get_mode(unsigned int *mode);
+int hrtimer_blink_nodt_register_notifier(struct notifier_block *nb);
+int hrtimer_blink_nodt_unregister_notifier(struct notifier_block *nb);
 
 #endif
@@ -0,0 +1,54 @@
+#ifndef BLINK_CMD_H
+#define BLINK_CMD_H
+
+#include <linux/types.h>   /* __u8, __u16, __u32 en kernel y user space */
+
+/*
+ * Flujo binario de comandos para /dev/blink0.
+ *
+ * Un write() lleva 1..BLINK_CMD_MAX struct blink_cmd seguidas. El lote se
+ * valida entero y se aplica de una vez en el siguiente flanco del LED; si
+ * un comando falla no se aplica ninguno y write() devuelve -EINVAL.
+ * Un read() posterior en el mismo fd devuelve una struct blink_cmd_status
+ * por comando del último lote.
+ *
+ * El primer byte (magic) distingue el flujo binario del modo ASCII
+ * clásico ("250" = periodo en ms), que sigue funcionando igual.
+ */
+#define BLINK_CMD_MAGIC    0xb1   /* nunca es un dígito ASCII */
+#define BLINK_CMD_MAX      64     /* comandos por write() */
+#define BLINK_PATTERN_MAX  16     /* pasos de un patrón */
+
+enum {
+    BLINK_CMD_PERIOD = 1,      /* arg: periodo en ms (>=1) */
+    BLINK_CMD_DUTY,            /* arg: % del periodo encendido, 0..100 */
+    BLINK_CMD_PHASE,           /* arg: us de retardo antes del primer flanco nuevo */
+    BLINK_CMD_PATTERN_STEP,    /* arg: BLINK_PAT_ON | ms; añade un paso al patrón */
+    BLINK_CMD_PATTERN_CLEAR,   /* borra el patrón: vuelve a periodo/duty */
+};
+
+#define BLINK_PAT_ON       (1u << 31)  /* nivel del paso; el resto son ms */
+
+struct blink_cmd {
+    __u8  magic;     /* BLINK_CMD_MAGIC */
+    __u8  op;        /* BLINK_CMD_* */
+    __u16 seq;       /* libre; se devuelve en el estado */
+    __u32 arg;
+};
+
+enum {
+    BLINK_ST_PENDING = 0,      /* aceptado, esperando el flanco */
+    BLINK_ST_APPLIED,          /* en vigor */
+    BLINK_ST_ERROR,            /* este comando rechazó el lote (err) */
+    BLINK_ST_SKIPPED,          /* lote rechazado por otro comando */
+    BLINK_ST_CANCELLED,        /* descartado antes del flanco: otro lote o write() de ms */
+};
+
+struct blink_cmd_status {
+    __u16 seq;
+    __u8  op;
+    __u8  state;     /* BLINK_ST_* */
+    __s32 err;       /* 0 o -errno */
+};
+
+#endif /* BLINK_CMD_H */
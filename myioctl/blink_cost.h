@@ -0,0 +1,173 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef BLINK_COST_H
+#define BLINK_COST_H
+
+/*
+ * Coste de CPU por flanco, común a los motores sin DT: tiempo dentro del
+ * callback (o de cada vuelta del hilo), del work y de la escritura al GPIO,
+ * atómica y que duerme por separado. Sumas y máximos por CPU, sin locks:
+ * cada CPU escribe la suya con las IRQ cortadas.
+ *
+ * debugfs <motor>/cost da ns por flanco y % de una CPU desde el último
+ * reset (escribir cualquier cosa). Un expansor I2C lento se ve aquí antes
+ * que en la latencia.
+ */
+#include <linux/device.h>
+#include <linux/percpu.h>
+#include <linux/sched/clock.h>
+#include <linux/timekeeping.h>
+#include <linux/gpio/consumer.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/math64.h>
+
+enum {
+	BLINK_COST_CB,			/* callback del timer / vuelta del hilo */
+	BLINK_COST_WORK,		/* work diferido */
+	BLINK_COST_GPIO,		/* gpiod_set_value() */
+	BLINK_COST_GPIO_SLEEP,		/* gpiod_set_value_cansleep() */
+	BLINK_COST__MAX
+};
+
+static const char * const blink_cost_names[BLINK_COST__MAX] = {
+	[BLINK_COST_CB]         = "callback",
+	[BLINK_COST_WORK]       = "work",
+	[BLINK_COST_GPIO]       = "gpio",
+	[BLINK_COST_GPIO_SLEEP] = "gpio_cansleep",
+};
+
+struct blink_cost_cpu {
+	u64 n[BLINK_COST__MAX];
+	u64 ns[BLINK_COST__MAX];
+	u64 max[BLINK_COST__MAX];
+};
+
+struct blink_cost {
+	struct blink_cost_cpu __percpu *pc;	/* NULL: sin contabilidad */
+	u64 since;				/* ktime_get_ns() del reset */
+};
+
+static inline int blink_cost_init(struct device *dev, struct blink_cost *c)
+{
+	c->pc = devm_alloc_percpu(dev, struct blink_cost_cpu);
+	if (!c->pc)
+		return -ENOMEM;
+	c->since = ktime_get_ns();
+	return 0;
+}
+
+/* local_clock(): barato y monótono por CPU, basta para duraciones cortas */
+static inline u64 blink_cost_start(void)
+{
+	return local_clock();
+}
+
+static inline void blink_cost_end(struct blink_cost *c, unsigned int k, u64 t0)
+{
+	s64 d = local_clock() - t0;
+	struct blink_cost_cpu *p;
+	unsigned long flags;
+
+	if (!c->pc)
+		return;
+	if (d < 0)			/* migró entre CPUs con relojes desfasados */
+		d = 0;
+
+	local_irq_save(flags);
+	p = this_cpu_ptr(c->pc);
+	p->n[k]++;
+	p->ns[k] += d;
+	if (d > p->max[k])
+		p->max[k] = d;
+	local_irq_restore(flags);
+}
+
+static inline void blink_cost_gpio(struct blink_cost *c, struct gpio_desc *d,
+				   int val)
+{
+	u64 t0 = blink_cost_start();
+
+	gpiod_set_value(d, val);
+	blink_cost_end(c, BLINK_COST_GPIO, t0);
+}
+
+static inline void blink_cost_gpio_cansleep(struct blink_cost *c,
+					    struct gpio_desc *d, int val)
+{
+	u64 t0 = blink_cost_start();
+
+	gpiod_set_value_cansleep(d, val);
+	blink_cost_end(c, BLINK_COST_GPIO_SLEEP, t0);
+}
+
+static int blink_cost_show(struct seq_file *m, void *v)
+{
+	struct blink_cost *c = m->private;
+	u64 n[BLINK_COST__MAX] = {}, ns[BLINK_COST__MAX] = {};
+	u64 max[BLINK_COST__MAX] = {};
+	u64 el = ktime_get_ns() - READ_ONCE(c->since), edges, busy;
+	int cpu, k;
+
+	seq_puts(m, "# cpu kind count avg_ns max_ns\n");
+	for_each_possible_cpu(cpu) {
+		const struct blink_cost_cpu *p = per_cpu_ptr(c->pc, cpu);
+
+		for (k = 0; k < BLINK_COST__MAX; k++) {
+			if (!p->n[k])
+				continue;
+			seq_printf(m, "%d %s %llu %llu %llu\n", cpu, blink_cost_names[k],
+				   p->n[k], div64_u64(p->ns[k], p->n[k]), p->max[k]);
+			n[k] += p->n[k];
+			ns[k] += p->ns[k];
+			max[k] = max(max[k], p->max[k]);
+		}
+	}
+
+	/* El GPIO va dentro del callback o del work: no se suma aparte */
+	edges = n[BLINK_COST_CB];
+	busy = ns[BLINK_COST_CB] + ns[BLINK_COST_WORK];
+	seq_printf(m, "# edges %llu ns/edge %llu\n", edges,
+		   edges ? div64_u64(busy, edges) : 0);
+	for (k = 0; k < BLINK_COST__MAX; k++)
+		seq_printf(m, "# %s ns/edge %llu max %llu\n", blink_cost_names[k],
+			   edges ? div64_u64(ns[k], edges) : 0, max[k]);
+	/* milésimas de % de una CPU */
+	busy = el ? div64_u64(busy * 100000, el) : 0;
+	seq_printf(m, "# share %llu.%03llu%% of one cpu over %llu ms\n",
+		   busy / 1000, busy % 1000, div_u64(el, NSEC_PER_MSEC));
+	return 0;
+}
+
+static int blink_cost_open(struct inode *i, struct file *f)
+{
+	return single_open(f, blink_cost_show, i->i_private);
+}
+
+/* Reset sin parar el motor: un flanco en vuelo puede quedar a medias */
+static ssize_t blink_cost_write(struct file *f, const char __user *ubuf,
+				size_t len, loff_t *off)
+{
+	struct blink_cost *c = file_inode(f)->i_private;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(c->pc, cpu), 0, sizeof(struct blink_cost_cpu));
+	WRITE_ONCE(c->since, ktime_get_ns());
+	return len;
+}
+
+static const struct file_operations blink_cost_fops = {
+	.owner   = THIS_MODULE,
+	.open    = blink_cost_open,
+	.read    = seq_read,
+	.write   = blink_cost_write,
+	.llseek  = seq_lseek,
+	.release = single_release,
+};
+
+static inline void blink_cost_debugfs(struct dentry *dir, struct blink_cost *c)
+{
+	debugfs_create_file("cost", 0644, dir, c, &blink_cost_fops);
+}
+
+#endif
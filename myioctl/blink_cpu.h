@@ -0,0 +1,116 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef BLINK_CPU_H
+#define BLINK_CPU_H
+
+/*
+ * Colocación de timers e hilos de los motores sin DT.
+ *
+ * El conjunto candidato es "cpus" (vacío = todas) recortado siempre a la
+ * máscara housekeeping del kernel (isolcpus=, nohz_full=) y a las CPUs en
+ * línea: una CPU aislada nunca recibe la interrupción de un blink.
+ *   pin    - primera CPU del conjunto
+ *   spread - round-robin por instancia (BLINK_ID_*), reparte la carga
+ * Los llamadores eligen y arman con cpus_read_lock() tomado.
+ */
+#include <linux/cpu.h>
+#include <linux/cpumask.h>
+#include <linux/sched/isolation.h>
+#include <linux/sysfs.h>
+
+enum {
+	BLINK_CPU_PIN,
+	BLINK_CPU_SPREAD,
+	BLINK_CPU__MAX
+};
+
+static const char * const blink_cpu_names[BLINK_CPU__MAX] = {
+	[BLINK_CPU_PIN]    = "pin",
+	[BLINK_CPU_SPREAD] = "spread",
+};
+
+struct blink_cpu {
+	unsigned int policy;		/* BLINK_CPU_* */
+	unsigned int index;		/* instancia, para spread */
+	enum hk_type hk;		/* HK_TYPE_TIMER o HK_TYPE_KTHREAD */
+	struct cpumask want;		/* pedidas por sysfs; vacía = todas */
+	int cpu;			/* última elegida */
+};
+
+static inline void blink_cpu_init(struct blink_cpu *bc, unsigned int index,
+				  enum hk_type hk)
+{
+	bc->policy = BLINK_CPU_SPREAD;
+	bc->index = index;
+	bc->hk = hk;
+	cpumask_clear(&bc->want);
+	bc->cpu = -1;
+}
+
+static inline bool blink_cpu_wanted(const struct blink_cpu *bc, int cpu)
+{
+	return cpumask_empty(&bc->want) || cpumask_test_cpu(cpu, &bc->want);
+}
+
+/* Con cpus_read_lock() */
+static inline int blink_cpu_pick(struct blink_cpu *bc)
+{
+	const struct cpumask *hk = housekeeping_cpumask(bc->hk);
+	unsigned int n = 0, nth;
+	int cpu;
+
+	for_each_cpu_and(cpu, hk, cpu_online_mask)
+		if (blink_cpu_wanted(bc, cpu))
+			n++;
+
+	if (!n) {
+		/* Las pedidas se fueron de línea: cualquier housekeeping */
+		cpu = cpumask_first_and(hk, cpu_online_mask);
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first(cpu_online_mask);
+		goto out;
+	}
+
+	nth = bc->policy == BLINK_CPU_SPREAD ? bc->index % n : 0;
+	for_each_cpu_and(cpu, hk, cpu_online_mask)
+		if (blink_cpu_wanted(bc, cpu) && !nth--)
+			break;
+out:
+	WRITE_ONCE(bc->cpu, cpu);
+	return cpu;
+}
+
+/*
+ * Escritura en sysfs: "<pin|spread> [lista]", p. ej. "spread 0-3". Sin
+ * lista, todas las housekeeping. Una lista sin ninguna se rechaza.
+ */
+static inline int blink_cpu_parse(const struct blink_cpu *bc, const char *buf,
+				  unsigned int *policy, struct cpumask *m)
+{
+	char name[8];
+	int n = 0, ret;
+
+	if (sscanf(buf, "%7s %n", name, &n) != 1)
+		return -EINVAL;
+	ret = match_string(blink_cpu_names, BLINK_CPU__MAX, name);
+	if (ret < 0)
+		return ret;
+	*policy = ret;
+
+	cpumask_clear(m);
+	if (buf[n] && buf[n] != '\n') {
+		ret = cpulist_parse(buf + n, m);
+		if (ret)
+			return ret;
+		if (!cpumask_intersects(m, housekeeping_cpumask(bc->hk)))
+			return -EINVAL;
+	}
+	return 0;
+}
+
+static inline ssize_t blink_cpu_show(const struct blink_cpu *bc, char *buf)
+{
+	return sysfs_emit(buf, "%s cpus %*pbl cpu %d\n", blink_cpu_names[bc->policy],
+			  cpumask_pr_args(&bc->want), READ_ONCE(bc->cpu));
+}
+
+#endif
@@ -5,13 +5,16 @@
 #include <linux/device.h>
 #include <linux/uaccess.h>   // copy_from_user, copy_to_user, access_ok
 #include <linux/slab.h>
+#include <linux/io_uring.h>
 
 #include "blink_api.h"
 #include "blink_ioctl.h"
+#include "memacct.h"
 
 static dev_t devt;
 static struct cdev cdev_ctrl;
 static struct class *cls;
+static struct memacct *acct_echo;
 
 static int set_ms_by_id(__u32 id, __u32 ms)
 {
@@ -37,6 +40,37 @@ static int get_ms_by_id(__u32 id, __u32 *ms)
     }
 }
 
+static int set_mode_by_id(__u32 id, __u32 mode)
+{
+    if (mode >= BLINK_MODE__MAX) return -EINVAL;
+
+    switch (id) {
+    case BLINK_ID_KTHREAD: return kthread_blink_nodt_set_mode(mode);
+    case BLINK_ID_TIMER:   return timer_blink_nodt_set_mode(mode);
+    case BLINK_ID_HRTIMER: return hrtimer_blink_nodt_set_mode(mode);
+    default: return -EINVAL;
+    }
+}
+
+static int get_mode_by_id(__u32 id, __u32 *mode)
+{
+    if (!mode) return -EINVAL;
+
+    switch (id) {
+    case BLINK_ID_KTHREAD: return kthread_blink_nodt_get_mode(mode);
+    case BLINK_ID_TIMER:   return timer_blink_nodt_get_mode(mode);
+    case BLINK_ID_HRTIMER: return hrtimer_blink_nodt_get_mode(mode);
+    default: return -EINVAL;
+    }
+}
+
+/* Al diario con el resultado; las copias fallidas no llegan aquí */
+static long blinkctl_log(__u16 op, __u32 id, __u32 val, long ret)
+{
+    blink_journal_log(op, id, val, ret);
+    return ret;
+}
+
 static long blinkctl_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
 {
     void __user *up = (void __user *)arg;
@@ -47,7 +81,7 @@ static long blinkctl_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
         struct blink_ioc_ms a;
         if (copy_from_user(&a, up, sizeof(a)))
             return -EFAULT;
-        return set_ms_by_id(a.id, a.ms);
+        return blinkctl_log(BLINK_JOP_IOC_SET_MS, a.id, a.ms, set_ms_by_id(a.id, a.ms));
     }
 
     case BLINK_IOC_GET_MS: {
@@ -57,6 +91,7 @@ static long blinkctl_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
         if (copy_from_user(&a, up, sizeof(a)))
             return -EFAULT;
         ret = get_ms_by_id(a.id, &a.ms);
+        blinkctl_log(BLINK_JOP_IOC_GET_MS, a.id, ret ? 0 : a.ms, ret);
         if (ret) return ret;
         if (copy_to_user(up, &a, sizeof(a)))
             return -EFAULT;
@@ -85,7 +120,7 @@ static long blinkctl_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
         pr_info("blinkctl: user_ptr=0x%llx (leido ms=%u) id=%u\n",
                 p.user_ptr, ms, p.id);
 
-        return set_ms_by_id(p.id, ms);
+        return blinkctl_log(BLINK_JOP_IOC_SET_MS, p.id, ms, set_ms_by_id(p.id, ms));
     }
 
     case BLINK_IOC_ECHO: {
@@ -97,12 +132,12 @@ static long blinkctl_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
             return -EFAULT;
 
         if (e.len == 0 || e.len > 256)  /* limitamos por demo */
-            return -EINVAL;
+            return blinkctl_log(BLINK_JOP_IOC_ECHO, 0, e.len, -EINVAL);
 
         if (!access_ok((void __user *)(uintptr_t)e.user_ptr, e.len))
             return -EFAULT;
 
-        kbuf = memdup_user((void __user *)(uintptr_t)e.user_ptr, e.len);
+        kbuf = memacct_memdup_user(acct_echo, (void __user *)(uintptr_t)e.user_ptr, e.len);
         if (IS_ERR(kbuf))
             return PTR_ERR(kbuf);
 
@@ -112,10 +147,32 @@ static long blinkctl_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
                 kbuf[i] -= 32;
 
         if (copy_to_user((void __user *)(uintptr_t)e.user_ptr, kbuf, e.len)) {
-            kfree(kbuf);
+            memacct_kfree(acct_echo, kbuf, e.len);
             return -EFAULT;
         }
-        kfree(kbuf);
+        memacct_kfree(acct_echo, kbuf, e.len);
+        return blinkctl_log(BLINK_JOP_IOC_ECHO, 0, e.len, 0);
+    }
+
+    case BLINK_IOC_SET_MODE: {
+        struct blink_ioc_mode m;
+        if (copy_from_user(&m, up, sizeof(m)))
+            return -EFAULT;
+        return blinkctl_log(BLINK_JOP_IOC_SET_MODE, m.id, m.mode,
+                            set_mode_by_id(m.id, m.mode));
+    }
+
+    case BLINK_IOC_GET_MODE: {
+        struct blink_ioc_mode m;
+        int ret;
+
+        if (copy_from_user(&m, up, sizeof(m)))
+            return -EFAULT;
+        ret = get_mode_by_id(m.id, &m.mode);
+        blinkctl_log(BLINK_JOP_IOC_GET_MODE, m.id, ret ? 0 : m.mode, ret);
+        if (ret) return ret;
+        if (copy_to_user(up, &m, sizeof(m)))
+            return -EFAULT;
         return 0;
     }
 
@@ -124,20 +181,63 @@ static long blinkctl_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
     }
 }
 
+#ifdef CONFIG_IO_URING
+/*
+ * io_uring passthrough (IORING_OP_URING_CMD): sqe->cmd_op lleva el código
+ * de ioctl y los bytes de comando del SQE la struct blink_ioc_ms, sin
+ * copy_from_user. El resultado va en cqe->res: 0 en SET, ms en GET.
+ *
+ * SET toma mutex del motor, notificadores y genl con GFP_KERNEL: con
+ * IO_URING_F_NONBLOCK devuelve -EAGAIN y io_uring lo pasa a io-wq, así
+ * un motor lento no frena el resto del lote. GET se completa en línea.
+ */
+static int blinkctl_uring_cmd(struct io_uring_cmd *ioucmd, unsigned int issue_flags)
+{
+    const struct blink_ioc_ms *a = ioucmd->cmd;
+    __u32 id, ms;
+    int ret;
+
+    /* El SQE está en memoria compartida con user space: leer una vez */
+    id = READ_ONCE(a->id);
+    ms = READ_ONCE(a->ms);
+
+    switch (ioucmd->cmd_op) {
+    case BLINK_IOC_SET_MS:
+        if (issue_flags & IO_URING_F_NONBLOCK)
+            return -EAGAIN;
+        return blinkctl_log(BLINK_JOP_IOC_SET_MS, id, ms, set_ms_by_id(id, ms));
+
+    case BLINK_IOC_GET_MS:
+        ret = get_ms_by_id(id, &ms);
+        blinkctl_log(BLINK_JOP_IOC_GET_MS, id, ret ? 0 : ms, ret);
+        if (ret) return ret;
+        return min_t(__u32, ms, INT_MAX);
+
+    default:
+        return -ENOTTY;
+    }
+}
+#endif
+
 static const struct file_operations fops = {
     .owner          = THIS_MODULE,
     .unlocked_ioctl = blinkctl_ioctl,
 #ifdef CONFIG_COMPAT
     .compat_ioctl   = blinkctl_ioctl,
 #endif
+#ifdef CONFIG_IO_URING
+    .uring_cmd      = blinkctl_uring_cmd,
+#endif
 };
 
 static int __init blinkctl_init(void)
 {
     int ret;
 
+    acct_echo = memacct_register(KBUILD_MODNAME, "echo");
+
     ret = alloc_chrdev_region(&devt, 0, 1, "blinkctl");
-    if (ret) return ret;
+    if (ret) goto err_acct;
 
     cdev_init(&cdev_ctrl, &fops);
     ret = cdev_add(&cdev_ctrl, devt, 1);
@@ -160,6 +260,8 @@ err_cdev:
     cdev_del(&cdev_ctrl);
 err_chr:
     unregister_chrdev_region(devt, 1);
+err_acct:
+    memacct_unregister(acct_echo);
     return ret;
 }
 
@@ -169,11 +271,16 @@ static void __exit blinkctl_exit(void)
     class_destroy(cls);
     cdev_del(&cdev_ctrl);
     unregister_chrdev_region(devt, 1);
+    memacct_unregister(acct_echo);
 }
 
 module_init(blinkctl_init);
 module_exit(blinkctl_exit);
 
+#ifdef MY_KUNIT
+#include "blink_ctrl_ioctl_kunit.c"
+#endif
+
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("Jaime Garcia Coronel j.gcoronel@condumex.com.mx");
 MODULE_DESCRIPTION("Control de blinkers por ioctl + demo kernel/user memory");
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * KUnit: despacho de set_ms_by_id()/get_ms_by_id() y de los modos.
+ * Se incluye al final de blink_ctrl_ioctl.c con "make KUNIT=1".
+ *
+ * Los casos con id válido necesitan los motores cargados (gpio-sim, ver
+ * kunit/run_kunit.sh); sin ellos se marcan como omitidos.
+ */
+#include "kbench.h"
+
+static void blinkctl_test_invalid_id(struct kunit *test)
+{
+	__u32 ms = 0;
+
+	KUNIT_EXPECT_EQ(test, set_ms_by_id(BLINK_ID__MAX, 100), -EINVAL);
+	KUNIT_EXPECT_EQ(test, set_ms_by_id(U32_MAX, 100), -EINVAL);
+	KUNIT_EXPECT_EQ(test, get_ms_by_id(BLINK_ID__MAX, &ms), -EINVAL);
+	KUNIT_EXPECT_EQ(test, ms, 0U);
+}
+
+static void blinkctl_test_null_out(struct kunit *test)
+{
+	KUNIT_EXPECT_EQ(test, get_ms_by_id(BLINK_ID_KTHREAD, NULL), -EINVAL);
+}
+
+static void blinkctl_test_roundtrip(struct kunit *test)
+{
+	__u32 id, old, ms;
+
+	for (id = 0; id < BLINK_ID__MAX; id++) {
+		if (get_ms_by_id(id, &old))
+			kunit_skip(test, "motor %u no cargado", id);
+
+		KUNIT_EXPECT_EQ(test, set_ms_by_id(id, 250), 0);
+		KUNIT_EXPECT_EQ(test, get_ms_by_id(id, &ms), 0);
+		KUNIT_EXPECT_EQ(test, ms, 250U);
+
+		/* ms = 0 se sube a 1 ms */
+		KUNIT_EXPECT_EQ(test, set_ms_by_id(id, 0), 0);
+		KUNIT_EXPECT_EQ(test, get_ms_by_id(id, &ms), 0);
+		KUNIT_EXPECT_EQ(test, ms, 1U);
+
+		set_ms_by_id(id, old);
+	}
+}
+
+static void blinkctl_test_mode(struct kunit *test)
+{
+	__u32 id, mode;
+
+	KUNIT_EXPECT_EQ(test, set_mode_by_id(BLINK_ID__MAX, BLINK_MODE_ON), -EINVAL);
+	KUNIT_EXPECT_EQ(test, set_mode_by_id(BLINK_ID_TIMER, BLINK_MODE__MAX), -EINVAL);
+	KUNIT_EXPECT_EQ(test, get_mode_by_id(BLINK_ID_TIMER, NULL), -EINVAL);
+
+	for (id = 0; id < BLINK_ID__MAX; id++) {
+		if (get_mode_by_id(id, &mode))
+			kunit_skip(test, "motor %u no cargado", id);
+
+		for (mode = BLINK_MODE__MAX; mode-- > 0; ) {
+			__u32 got = BLINK_MODE__MAX;
+
+			KUNIT_EXPECT_EQ(test, set_mode_by_id(id, mode), 0);
+			KUNIT_EXPECT_EQ(test, get_mode_by_id(id, &got), 0);
+			KUNIT_EXPECT_EQ(test, got, mode);
+		}
+		/* El bucle acaba en BLINK: el motor queda como estaba */
+	}
+}
+
+static void blinkctl_bench_dispatch(struct kunit *test)
+{
+	__u32 ms;
+	int ret;
+
+	KBENCH(test, "set_ms_by_id(invalid)", 100000, 20, {
+		ret = set_ms_by_id(BLINK_ID__MAX, 100);
+		OPTIMIZER_HIDE_VAR(ret);
+	});
+
+	if (get_ms_by_id(BLINK_ID_TIMER, &ms))
+		kunit_skip(test, "timer_blink_nodt no cargado");
+
+	KBENCH(test, "get_ms_by_id(timer)", 100000, 50, {
+		ret = get_ms_by_id(BLINK_ID_TIMER, &ms);
+		OPTIMIZER_HIDE_VAR(ret);
+	});
+}
+
+static struct kunit_case blinkctl_test_cases[] = {
+	KUNIT_CASE(blinkctl_test_invalid_id),
+	KUNIT_CASE(blinkctl_test_null_out),
+	KUNIT_CASE(blinkctl_test_roundtrip),
+	KUNIT_CASE(blinkctl_test_mode),
+	KUNIT_CASE(blinkctl_bench_dispatch),
+	{}
+};
+
+static struct kunit_suite blinkctl_test_suite = {
+	.name = "blinkctl",
+	.test_cases = blinkctl_test_cases,
+};
+kunit_test_suite(blinkctl_test_suite);
@@ -0,0 +1,351 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Familia generic netlink "blink": set/get por lotes y grupo multicast
+ * "events" con los cambios de los tres motores (ver blink_genl.h).
+ *
+ * Los avisos llegan por las cadenas de notificación de cada motor, en
+ * contexto de proceso, así que aquí se puede reservar con GFP_KERNEL. Sin
+ * suscriptores no se construye ningún mensaje.
+ */
+#include <linux/module.h>
+#include <linux/notifier.h>
+#include <net/genetlink.h>
+
+#include "blink_api.h"
+#include "blink_ioctl.h"
+#include "blink_genl.h"
+
+/* Entrada de respuesta: nido + ID + (MS y MODE) o ERRNO */
+#define BLINK_GENL_ENTRY_SIZE   (nla_total_size(0) + 3 * nla_total_size(sizeof(u32)))
+/* Evento: ID + EVENT + el mayor de los cuerpos (tres u64 de overrun) */
+#define BLINK_GENL_EVENT_SIZE   (2 * nla_total_size(sizeof(u32)) + \
+                                 3 * nla_total_size_64bit(sizeof(u64)))
+
+static struct genl_family blink_genl_family;
+
+static const struct nla_policy blink_genl_entry_policy[BLINK_GENL_A_MAX + 1] = {
+    [BLINK_GENL_A_ID]   = NLA_POLICY_MAX(NLA_U32, BLINK_ID__MAX - 1),
+    [BLINK_GENL_A_MS]   = NLA_POLICY_MIN(NLA_U32, 1),
+    [BLINK_GENL_A_MODE] = NLA_POLICY_MAX(NLA_U32, BLINK_MODE__MAX - 1),
+};
+
+static const struct nla_policy blink_genl_policy[BLINK_GENL_A_MAX + 1] = {
+    [BLINK_GENL_A_ENTRY] = NLA_POLICY_NESTED(blink_genl_entry_policy),
+};
+
+static int blink_genl_set_ms(u32 id, u32 ms)
+{
+    switch (id) {
+    case BLINK_ID_KTHREAD: return kthread_blink_nodt_set_period(ms);
+    case BLINK_ID_TIMER:   return timer_blink_nodt_set_period(ms);
+    case BLINK_ID_HRTIMER: return hrtimer_blink_nodt_set_period(ms);
+    default: return -EINVAL;
+    }
+}
+
+static int blink_genl_set_mode(u32 id, u32 mode)
+{
+    switch (id) {
+    case BLINK_ID_KTHREAD: return kthread_blink_nodt_set_mode(mode);
+    case BLINK_ID_TIMER:   return timer_blink_nodt_set_mode(mode);
+    case BLINK_ID_HRTIMER: return hrtimer_blink_nodt_set_mode(mode);
+    default: return -EINVAL;
+    }
+}
+
+static int blink_genl_get(u32 id, u32 *ms, u32 *mode)
+{
+    int ret;
+
+    switch (id) {
+    case BLINK_ID_KTHREAD:
+        ret = kthread_blink_nodt_get_period(ms);
+        return ret ?: kthread_blink_nodt_get_mode(mode);
+    case BLINK_ID_TIMER:
+        ret = timer_blink_nodt_get_period(ms);
+        return ret ?: timer_blink_nodt_get_mode(mode);
+    case BLINK_ID_HRTIMER:
+        ret = hrtimer_blink_nodt_get_period(ms);
+        return ret ?: hrtimer_blink_nodt_get_mode(mode);
+    default:
+        return -EINVAL;
+    }
+}
+
+/* Periodo primero y luego modo, como harían dos ioctl seguidos */
+static int blink_genl_apply(struct nlattr **tb)
+{
+    u32 id;
+    int ret = 0;
+
+    if (!tb[BLINK_GENL_A_ID] || (!tb[BLINK_GENL_A_MS] && !tb[BLINK_GENL_A_MODE]))
+        return -EINVAL;
+
+    id = nla_get_u32(tb[BLINK_GENL_A_ID]);
+    if (tb[BLINK_GENL_A_MS])
+        ret = blink_genl_set_ms(id, nla_get_u32(tb[BLINK_GENL_A_MS]));
+    if (!ret && tb[BLINK_GENL_A_MODE])
+        ret = blink_genl_set_mode(id, nla_get_u32(tb[BLINK_GENL_A_MODE]));
+    return ret;
+}
+
+/*
+ * {ID, ERRNO}, o {ID, MS, MODE} si se pide el estado y no hubo error.
+ * ID solo si venía en la petición.
+ */
+static int blink_genl_put_entry(struct sk_buff *msg, bool has_id, u32 id, int err,
+                                const u32 *ms, const u32 *mode)
+{
+    struct nlattr *e = nla_nest_start(msg, BLINK_GENL_A_ENTRY);
+
+    if (!e)
+        return -EMSGSIZE;
+    if (has_id && nla_put_u32(msg, BLINK_GENL_A_ID, id))
+        goto cancel;
+    if (err || !ms) {
+        if (nla_put_s32(msg, BLINK_GENL_A_ERRNO, err))
+            goto cancel;
+    } else if (nla_put_u32(msg, BLINK_GENL_A_MS, *ms) ||
+               nla_put_u32(msg, BLINK_GENL_A_MODE, *mode)) {
+        goto cancel;
+    }
+    nla_nest_end(msg, e);
+    return 0;
+
+cancel:
+    nla_nest_cancel(msg, e);
+    return -EMSGSIZE;
+}
+
+/* Las A_ENTRY van repetidas al primer nivel: info->attrs solo guarda la última */
+#define blink_genl_for_each_entry(a, info, rem) \
+    nlmsg_for_each_attr(a, (info)->nlhdr, GENL_HDRLEN, rem) \
+        if (nla_type(a) == BLINK_GENL_A_ENTRY)
+
+static unsigned int blink_genl_count(struct genl_info *info)
+{
+    const struct nlattr *a;
+    unsigned int n = 0;
+    int rem;
+
+    blink_genl_for_each_entry(a, info, rem)
+        n++;
+    return n;
+}
+
+static struct sk_buff *blink_genl_reply_new(struct genl_info *info, unsigned int n,
+                                            u8 cmd, void **hdr)
+{
+    struct sk_buff *msg = genlmsg_new(n * BLINK_GENL_ENTRY_SIZE, GFP_KERNEL);
+
+    if (!msg)
+        return NULL;
+    *hdr = genlmsg_put_reply(msg, info, &blink_genl_family, 0, cmd);
+    if (!*hdr) {
+        nlmsg_free(msg);
+        return NULL;
+    }
+    return msg;
+}
+
+/*
+ * Cada entrada se aplica y responde por separado: un fallo no deshace
+ * las anteriores ni impide las siguientes.
+ */
+static int blink_genl_cmd_set(struct sk_buff *skb, struct genl_info *info)
+{
+    struct nlattr *tb[BLINK_GENL_A_MAX + 1];
+    unsigned int n = blink_genl_count(info);
+    struct sk_buff *msg;
+    struct nlattr *a;
+    void *hdr;
+    int rem, ret;
+    u32 id;
+
+    if (!n) {
+        GENL_SET_ERR_MSG(info, "SET sin entradas");
+        return -EINVAL;
+    }
+
+    msg = blink_genl_reply_new(info, n, BLINK_GENL_CMD_SET, &hdr);
+    if (!msg)
+        return -ENOMEM;
+
+    blink_genl_for_each_entry(a, info, rem) {
+        ret = nla_parse_nested(tb, BLINK_GENL_A_MAX, a, blink_genl_entry_policy,
+                               info->extack);
+        if (!ret)
+            ret = blink_genl_apply(tb);
+        id = tb[BLINK_GENL_A_ID] ? nla_get_u32(tb[BLINK_GENL_A_ID]) : 0;
+        if (blink_genl_put_entry(msg, !!tb[BLINK_GENL_A_ID], id, ret, NULL, NULL))
+            goto nospace;
+    }
+
+    genlmsg_end(msg, hdr);
+    return genlmsg_reply(msg, info);
+
+nospace:
+    nlmsg_free(msg);
+    return -EMSGSIZE;
+}
+
+static int blink_genl_put_state(struct sk_buff *msg, u32 id)
+{
+    u32 ms = 0, mode = 0;
+    int err = blink_genl_get(id, &ms, &mode);
+
+    return blink_genl_put_entry(msg, true, id, err, &ms, &mode);
+}
+
+static int blink_genl_cmd_get(struct sk_buff *skb, struct genl_info *info)
+{
+    struct nlattr *tb[BLINK_GENL_A_MAX + 1];
+    unsigned int n = blink_genl_count(info);
+    struct sk_buff *msg;
+    struct nlattr *a;
+    void *hdr;
+    int rem, ret;
+    u32 id;
+
+    msg = blink_genl_reply_new(info, n ?: BLINK_ID__MAX, BLINK_GENL_CMD_GET, &hdr);
+    if (!msg)
+        return -ENOMEM;
+
+    if (!n) {
+        for (id = 0; id < BLINK_ID__MAX; id++)
+            if (blink_genl_put_state(msg, id))
+                goto nospace;
+    }
+
+    blink_genl_for_each_entry(a, info, rem) {
+        ret = nla_parse_nested(tb, BLINK_GENL_A_MAX, a, blink_genl_entry_policy,
+                               info->extack);
+        if (!ret && !tb[BLINK_GENL_A_ID])
+            ret = -EINVAL;
+        id = tb[BLINK_GENL_A_ID] ? nla_get_u32(tb[BLINK_GENL_A_ID]) : 0;
+        if (ret ? blink_genl_put_entry(msg, !!tb[BLINK_GENL_A_ID], id, ret, NULL, NULL)
+                : blink_genl_put_state(msg, id))
+            goto nospace;
+    }
+
+    genlmsg_end(msg, hdr);
+    return genlmsg_reply(msg, info);
+
+nospace:
+    nlmsg_free(msg);
+    return -EMSGSIZE;
+}
+
+static const struct genl_small_ops blink_genl_ops[] = {
+    {
+        .cmd   = BLINK_GENL_CMD_SET,
+        .doit  = blink_genl_cmd_set,
+        .flags = GENL_ADMIN_PERM,
+    },
+    {
+        .cmd   = BLINK_GENL_CMD_GET,
+        .doit  = blink_genl_cmd_get,
+    },
+};
+
+static const struct genl_multicast_group blink_genl_mcgrps[] = {
+    { .name = BLINK_GENL_MCGRP },
+};
+
+static struct genl_family blink_genl_family __ro_after_init = {
+    .name         = BLINK_GENL_NAME,
+    .version      = BLINK_GENL_VERSION,
+    .maxattr      = BLINK_GENL_A_MAX,
+    .policy       = blink_genl_policy,
+    .module       = THIS_MODULE,
+    .small_ops    = blink_genl_ops,
+    .n_small_ops  = ARRAY_SIZE(blink_genl_ops),
+    .resv_start_op = BLINK_GENL_CMD_EVENT + 1,
+    .mcgrps       = blink_genl_mcgrps,
+    .n_mcgrps     = ARRAY_SIZE(blink_genl_mcgrps),
+};
+
+/* Un mensaje por cambio a todos los suscriptores de "events" */
+static int blink_genl_event(struct notifier_block *nb, unsigned long ev, void *data)
+{
+    const struct blink_event *e = data;
+    struct sk_buff *msg;
+    void *hdr;
+
+    if (!genl_has_listeners(&blink_genl_family, &init_net, 0))
+        return NOTIFY_DONE;
+
+    msg = genlmsg_new(BLINK_GENL_EVENT_SIZE, GFP_KERNEL);
+    if (!msg)
+        return NOTIFY_DONE;
+    hdr = genlmsg_put(msg, 0, 0, &blink_genl_family, 0, BLINK_GENL_CMD_EVENT);
+    if (!hdr)
+        goto err;
+
+    if (nla_put_u32(msg, BLINK_GENL_A_ID, e->id) ||
+        nla_put_u32(msg, BLINK_GENL_A_EVENT, ev))
+        goto err;
+
+    switch (ev) {
+    case BLINK_EV_PERIOD:
+        if (nla_put_u32(msg, BLINK_GENL_A_MS, e->val))
+            goto err;
+        break;
+    case BLINK_EV_MODE:
+        if (nla_put_u32(msg, BLINK_GENL_A_MODE, e->val))
+            goto err;
+        break;
+    case BLINK_EV_OVERRUN:
+        if (nla_put_u64_64bit(msg, BLINK_GENL_A_LATE, e->late, BLINK_GENL_A_PAD) ||
+            nla_put_u64_64bit(msg, BLINK_GENL_A_SKIPPED, e->skipped, BLINK_GENL_A_PAD) ||
+            nla_put_u64_64bit(msg, BLINK_GENL_A_REPLAYED, e->replayed, BLINK_GENL_A_PAD))
+            goto err;
+        break;
+    }
+
+    genlmsg_end(msg, hdr);
+    genlmsg_multicast(&blink_genl_family, msg, 0, 0, GFP_KERNEL);
+    return NOTIFY_OK;
+
+err:
+    nlmsg_free(msg);
+    return NOTIFY_DONE;
+}
+
+static struct notifier_block blink_genl_nb[BLINK_ID__MAX] = {
+    [BLINK_ID_KTHREAD] = { .notifier_call = blink_genl_event },
+    [BLINK_ID_TIMER]   = { .notifier_call = blink_genl_event },
+    [BLINK_ID_HRTIMER] = { .notifier_call = blink_genl_event },
+};
+
+static int __init blink_genl_init(void)
+{
+    int ret;
+
+    ret = genl_register_family(&blink_genl_family);
+    if (ret) return ret;
+
+    /* Los motores son dependencias duras: sus cadenas ya existen */
+    kthread_blink_nodt_register_notifier(&blink_genl_nb[BLINK_ID_KTHREAD]);
+    timer_blink_nodt_register_notifier(&blink_genl_nb[BLINK_ID_TIMER]);
+    hrtimer_blink_nodt_register_notifier(&blink_genl_nb[BLINK_ID_HRTIMER]);
+
+    pr_info("blink_genl listo: familia \"%s\", grupo \"%s\"\n",
+            BLINK_GENL_NAME, BLINK_GENL_MCGRP);
+    return 0;
+}
+
+static void __exit blink_genl_exit(void)
+{
+    hrtimer_blink_nodt_unregister_notifier(&blink_genl_nb[BLINK_ID_HRTIMER]);
+    timer_blink_nodt_unregister_notifier(&blink_genl_nb[BLINK_ID_TIMER]);
+    kthread_blink_nodt_unregister_notifier(&blink_genl_nb[BLINK_ID_KTHREAD]);
+    genl_unregister_family(&blink_genl_family);
+}
+
+module_init(blink_genl_init);
+module_exit(blink_genl_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Jaime Garcia Coronel j.gcoronel@condumex.com.mx");
+MODULE_DESCRIPTION("Control de blinkers por generic netlink + eventos multicast");
@@ -0,0 +1,56 @@
+#ifndef BLINK_GENL_H
+#define BLINK_GENL_H
+
+#include <linux/types.h>   /* __u32, __u64 en kernel y en user space */
+
+/*
+ * Familia generic netlink "blink" (blink_genl.ko): las mismas operaciones
+ * que blink_ioctl.h, por lotes, y un grupo multicast con los cambios de
+ * todos los motores. Los suscriptores reciben un mensaje por cambio en
+ * vez de sondear con BLINK_IOC_GET_MS.
+ *
+ * BLINK_GENL_CMD_SET   (CAP_NET_ADMIN) uno o más A_ENTRY {ID, MS y/o MODE}.
+ *                      La respuesta lleva un A_ENTRY {ID, ERRNO} por cada
+ *                      uno, en el mismo orden.
+ * BLINK_GENL_CMD_GET   A_ENTRY {ID} opcionales; sin ninguno, todos. La
+ *                      respuesta lleva A_ENTRY {ID, MS, MODE} o {ID, ERRNO}.
+ * BLINK_GENL_CMD_EVENT solo en el grupo "events": ID, EVENT y, según EVENT,
+ *                      MS, MODE o LATE/SKIPPED/REPLAYED (acumulados).
+ */
+#define BLINK_GENL_NAME      "blink"
+#define BLINK_GENL_VERSION   1
+#define BLINK_GENL_MCGRP     "events"
+
+enum {
+    BLINK_GENL_CMD_UNSPEC,
+    BLINK_GENL_CMD_SET,
+    BLINK_GENL_CMD_GET,
+    BLINK_GENL_CMD_EVENT,
+    __BLINK_GENL_CMD_MAX
+};
+#define BLINK_GENL_CMD_MAX (__BLINK_GENL_CMD_MAX - 1)
+
+enum {
+    BLINK_GENL_A_UNSPEC,
+    BLINK_GENL_A_ENTRY,      /* anidado: atributos de un motor */
+    BLINK_GENL_A_ID,         /* u32, BLINK_ID_* */
+    BLINK_GENL_A_MS,         /* u32 */
+    BLINK_GENL_A_MODE,       /* u32, BLINK_MODE_* */
+    BLINK_GENL_A_ERRNO,      /* s32, 0 o -errno */
+    BLINK_GENL_A_EVENT,      /* u32, BLINK_EV_* */
+    BLINK_GENL_A_LATE,       /* u64 */
+    BLINK_GENL_A_SKIPPED,    /* u64 */
+    BLINK_GENL_A_REPLAYED,   /* u64 */
+    BLINK_GENL_A_PAD,
+    __BLINK_GENL_A_MAX
+};
+#define BLINK_GENL_A_MAX (__BLINK_GENL_A_MAX - 1)
+
+/* Qué cambió; también es la acción de las cadenas de notificación */
+enum {
+    BLINK_EV_PERIOD  = 1,
+    BLINK_EV_MODE    = 2,
+    BLINK_EV_OVERRUN = 3,    /* flancos tarde, solo el motor hrtimer */
+};
+
+#endif /* BLINK_GENL_H */
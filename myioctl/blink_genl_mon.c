@@ -0,0 +1,207 @@
+// gcc -O2 -Wall -o blink_genl_mon blink_genl_mon.c
+//
+// Cliente de la familia generic netlink "blink" sin libnl:
+//   blink_genl_mon [id:ms ...]
+// Aplica los periodos en un solo CMD_SET, muestra el estado (CMD_GET) y
+// se queda escuchando el grupo "events". Sin sondeo: un read por cambio.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include "blink_ioctl.h"
+#include "blink_genl.h"
+
+#define GA_DATA(g)  ((struct nlattr *)((char *)(g) + GENL_HDRLEN))
+#define NLA_DATA(a) ((void *)((char *)(a) + NLA_HDRLEN))
+#define NLA_LEN(a)  ((int)(a)->nla_len - NLA_HDRLEN)
+
+#define nla_for_each(a, head, len) \
+    for (a = (head); (len) >= (int)sizeof(*a) && a->nla_len >= sizeof(*a) && \
+         a->nla_len <= (len); \
+         (len) -= NLA_ALIGN(a->nla_len), a = (struct nlattr *)((char *)a + NLA_ALIGN(a->nla_len)))
+
+static const char *names[] = { "KTHREAD", "TIMER", "HRTIMER" };
+static const char *modes[] = { "blink", "on", "off", "stopped" };
+
+struct msg {
+    struct nlmsghdr n;
+    struct genlmsghdr g;
+    char buf[1024];
+};
+
+static void put_attr(struct nlmsghdr *n, uint16_t type, const void *data, int len)
+{
+    struct nlattr *a = (struct nlattr *)((char *)n + NLMSG_ALIGN(n->nlmsg_len));
+
+    a->nla_type = type;
+    a->nla_len = NLA_HDRLEN + len;
+    if (len) memcpy(NLA_DATA(a), data, len);
+    n->nlmsg_len = NLMSG_ALIGN(n->nlmsg_len) + NLA_ALIGN(a->nla_len);
+}
+
+static struct nlattr *nest_start(struct nlmsghdr *n, uint16_t type)
+{
+    struct nlattr *a = (struct nlattr *)((char *)n + NLMSG_ALIGN(n->nlmsg_len));
+
+    put_attr(n, type | NLA_F_NESTED, NULL, 0);
+    return a;
+}
+
+static void nest_end(struct nlmsghdr *n, struct nlattr *a)
+{
+    a->nla_len = (char *)n + n->nlmsg_len - (char *)a;
+}
+
+static void msg_init(struct msg *m, uint16_t family, uint8_t cmd, uint16_t flags)
+{
+    memset(m, 0, sizeof(*m));
+    m->n.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+    m->n.nlmsg_type = family;
+    m->n.nlmsg_flags = NLM_F_REQUEST | flags;
+    m->g.cmd = cmd;
+    m->g.version = 1;
+}
+
+/* Envía y espera la respuesta (o el ACK de error) en el mismo buffer */
+static int transact(int fd, struct msg *m)
+{
+    int len;
+
+    if (send(fd, m, m->n.nlmsg_len, 0) < 0) return -errno;
+    len = recv(fd, m, sizeof(*m), 0);
+    if (len < 0) return -errno;
+    if (m->n.nlmsg_type == NLMSG_ERROR)
+        return ((struct nlmsgerr *)NLMSG_DATA(&m->n))->error;
+    return len;
+}
+
+/* Id de la familia y del grupo "events" por el controlador de genl */
+static int resolve(int fd, uint16_t *family, uint32_t *grp)
+{
+    struct nlattr *a, *g, *f;
+    struct msg m;
+    int len, l2, l3;
+
+    msg_init(&m, GENL_ID_CTRL, CTRL_CMD_GETFAMILY, 0);
+    put_attr(&m.n, CTRL_ATTR_FAMILY_NAME, BLINK_GENL_NAME, sizeof(BLINK_GENL_NAME));
+    len = transact(fd, &m);
+    if (len < 0) return len;
+
+    *family = 0;
+    *grp = 0;
+    len = m.n.nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+    nla_for_each(a, GA_DATA(&m.g), len) {
+        if (a->nla_type == CTRL_ATTR_FAMILY_ID)
+            *family = *(uint16_t *)NLA_DATA(a);
+        if ((a->nla_type & NLA_TYPE_MASK) != CTRL_ATTR_MCAST_GROUPS)
+            continue;
+        l2 = NLA_LEN(a);
+        nla_for_each(g, (struct nlattr *)NLA_DATA(a), l2) {
+            const char *name = NULL;
+            uint32_t id = 0;
+
+            l3 = NLA_LEN(g);
+            nla_for_each(f, (struct nlattr *)NLA_DATA(g), l3) {
+                if (f->nla_type == CTRL_ATTR_MCAST_GRP_NAME) name = NLA_DATA(f);
+                if (f->nla_type == CTRL_ATTR_MCAST_GRP_ID) id = *(uint32_t *)NLA_DATA(f);
+            }
+            if (name && !strcmp(name, BLINK_GENL_MCGRP)) *grp = id;
+        }
+    }
+    return *family && *grp ? 0 : -ENOENT;
+}
+
+/* Un A_ENTRY de respuesta o los atributos de un evento */
+static void print_attrs(const char *tag, struct nlattr *head, int len)
+{
+    uint64_t v64;
+    uint32_t v;
+    struct nlattr *a;
+
+    printf("%s", tag);
+    nla_for_each(a, head, len) {
+        v = *(uint32_t *)NLA_DATA(a);
+        switch (a->nla_type & NLA_TYPE_MASK) {
+        case BLINK_GENL_A_ID:
+            printf(" %s", v < BLINK_ID__MAX ? names[v] : "?"); break;
+        case BLINK_GENL_A_MS:    printf(" ms=%u", v); break;
+        case BLINK_GENL_A_MODE:  printf(" mode=%s", v < BLINK_MODE__MAX ? modes[v] : "?"); break;
+        case BLINK_GENL_A_ERRNO: printf(" err=%s", strerror(-(int32_t)v)); break;
+        case BLINK_GENL_A_EVENT: printf(" ev=%u", v); break;
+        case BLINK_GENL_A_LATE:
+        case BLINK_GENL_A_SKIPPED:
+        case BLINK_GENL_A_REPLAYED:
+            memcpy(&v64, NLA_DATA(a), sizeof(v64));
+            printf(" %s=%llu", a->nla_type == BLINK_GENL_A_LATE ? "late" :
+                   a->nla_type == BLINK_GENL_A_SKIPPED ? "skipped" : "replayed",
+                   (unsigned long long)v64);
+            break;
+        }
+    }
+    printf("\n");
+}
+
+static void print_entries(const char *tag, struct msg *m)
+{
+    int len = m->n.nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+    struct nlattr *a;
+
+    nla_for_each(a, GA_DATA(&m->g), len)
+        if ((a->nla_type & NLA_TYPE_MASK) == BLINK_GENL_A_ENTRY)
+            print_attrs(tag, (struct nlattr *)NLA_DATA(a), NLA_LEN(a));
+}
+
+int main(int argc, char **argv)
+{
+    struct sockaddr_nl sa = { .nl_family = AF_NETLINK };
+    uint16_t family;
+    uint32_t grp, id, ms;
+    struct nlattr *e;
+    struct msg m;
+    int fd, i, ret;
+
+    fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_GENERIC);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&sa, sizeof(sa))) { perror("netlink"); return 1; }
+
+    ret = resolve(fd, &family, &grp);
+    if (ret) { fprintf(stderr, "familia \"%s\": %s\n", BLINK_GENL_NAME, strerror(-ret)); return 1; }
+
+    /* Lote: todas las entradas en un solo mensaje */
+    if (argc > 1) {
+        msg_init(&m, family, BLINK_GENL_CMD_SET, 0);
+        for (i = 1; i < argc; i++) {
+            if (sscanf(argv[i], "%u:%u", &id, &ms) != 2) {
+                fprintf(stderr, "uso: %s [id:ms ...]\n", argv[0]);
+                return 1;
+            }
+            e = nest_start(&m.n, BLINK_GENL_A_ENTRY);
+            put_attr(&m.n, BLINK_GENL_A_ID, &id, sizeof(id));
+            put_attr(&m.n, BLINK_GENL_A_MS, &ms, sizeof(ms));
+            nest_end(&m.n, e);
+        }
+        ret = transact(fd, &m);
+        if (ret < 0) { fprintf(stderr, "SET: %s\n", strerror(-ret)); return 1; }
+        print_entries("set", &m);
+    }
+
+    msg_init(&m, family, BLINK_GENL_CMD_GET, 0);
+    ret = transact(fd, &m);
+    if (ret < 0) { fprintf(stderr, "GET: %s\n", strerror(-ret)); return 1; }
+    print_entries("get", &m);
+
+    if (setsockopt(fd, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &grp, sizeof(grp))) {
+        perror("NETLINK_ADD_MEMBERSHIP");
+        return 1;
+    }
+    for (;;) {
+        ret = recv(fd, &m, sizeof(m), 0);
+        if (ret < 0) { perror("recv"); return 1; }
+        if (m.n.nlmsg_type != family || m.g.cmd != BLINK_GENL_CMD_EVENT) continue;
+        print_attrs("event", GA_DATA(&m.g), m.n.nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN));
+    }
+}
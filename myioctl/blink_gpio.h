@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef BLINK_GPIO_H
+#define BLINK_GPIO_H
+
+/*
+ * Cambio de línea y polaridad del LED en caliente, común a los motores
+ * sin DT. La tabla de lookup del módulo es la fuente de verdad: se
+ * reapunta y se pide el GPIO otra vez, sin pasar por un nuevo probe.
+ */
+#include <linux/gpio/consumer.h>
+#include <linux/gpio/machine.h>
+
+static inline unsigned int blink_gpio_line(const struct gpiod_lookup_table *lt)
+{
+	return lt->table[0].chip_hwnum;
+}
+
+static inline bool blink_gpio_active_low(const struct gpiod_lookup_table *lt)
+{
+	return lt->table[0].flags & GPIO_ACTIVE_LOW;
+}
+
+static inline void blink_gpio_set_lookup(struct gpiod_lookup_table *lt,
+					 unsigned int line, bool active_low)
+{
+	gpiod_remove_lookup_table(lt);
+	lt->table[0].chip_hwnum = line;
+	lt->table[0].flags = active_low ? GPIO_ACTIVE_LOW : GPIO_ACTIVE_HIGH;
+	gpiod_add_lookup_table(lt);
+}
+
+/*
+ * Pide la línea nueva mientras la vieja sigue tomada: si falla (línea
+ * ocupada o fuera del chip) la tabla vuelve a como estaba y el LED no se
+ * entera. El llamador suelta la vieja con blink_gpio_put().
+ */
+static inline struct gpio_desc *blink_gpio_get(struct device *dev,
+					       struct gpiod_lookup_table *lt,
+					       unsigned int line, bool active_low)
+{
+	unsigned int old_line = blink_gpio_line(lt);
+	bool old_low = blink_gpio_active_low(lt);
+	struct gpio_desc *d;
+
+	blink_gpio_set_lookup(lt, line, active_low);
+	d = devm_gpiod_get(dev, "led", GPIOD_OUT_LOW);
+	if (IS_ERR(d))
+		blink_gpio_set_lookup(lt, old_line, old_low);
+	return d;
+}
+
+static inline void blink_gpio_put(struct device *dev, struct gpio_desc *d)
+{
+	gpiod_set_value_cansleep(d, 0);
+	devm_gpiod_put(dev, d);
+}
+
+/* Misma línea: basta con invertir la polaridad del descriptor */
+static inline void blink_gpio_polarity(struct gpiod_lookup_table *lt,
+				       struct gpio_desc *d, bool active_low)
+{
+	if (gpiod_is_active_low(d) != active_low)
+		gpiod_toggle_active_low(d);
+	blink_gpio_set_lookup(lt, blink_gpio_line(lt), active_low);
+}
+
+#endif
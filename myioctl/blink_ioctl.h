@@ -22,6 +22,24 @@ enum {
     BLINK_ID__MAX
 };
 
+/*
+ * Modo de una línea. Fuera de BLINK el motor queda parado (sin timer ni
+ * hilo que despierte a la CPU) y el dispositivo entra en runtime suspend
+ * por autosuspend; el periodo se guarda para cuando vuelva a BLINK.
+ */
+enum {
+    BLINK_MODE_BLINK   = 0,
+    BLINK_MODE_ON      = 1,   /* fija encendida */
+    BLINK_MODE_OFF     = 2,   /* fija apagada */
+    BLINK_MODE_STOPPED = 3,   /* congelada en el nivel que tenía */
+    BLINK_MODE__MAX
+};
+
+struct blink_ioc_mode {
+    __u32 id;        /* uno de BLINK_ID_* */
+    __u32 mode;      /* uno de BLINK_MODE_* */
+};
+
 /* SET / GET del periodo por valor */
 struct blink_ioc_ms {
     __u32 id;        /* uno de BLINK_ID_* */
@@ -42,9 +60,17 @@ struct blink_ioc_echo {
     __u32 pad;
 };
 
+/*
+ * Los mismos SET_MS / GET_MS van también por io_uring (IORING_OP_URING_CMD,
+ * SQE normal de 64 bytes): sqe->cmd_op = BLINK_IOC_SET_MS o BLINK_IOC_GET_MS
+ * y sqe->cmd = struct blink_ioc_ms. cqe->res es 0 (SET), el periodo en ms
+ * (GET) o -errno. Ver blinkctl_uring.c.
+ */
 #define BLINK_IOC_SET_MS          _IOW (BLINK_IOC_MAGIC, 0x01, struct blink_ioc_ms)
 #define BLINK_IOC_GET_MS          _IOWR(BLINK_IOC_MAGIC, 0x02, struct blink_ioc_ms)
 #define BLINK_IOC_SET_MS_FROM_PTR _IOW (BLINK_IOC_MAGIC, 0x03, struct blink_ioc_ptr)
 #define BLINK_IOC_ECHO            _IOWR(BLINK_IOC_MAGIC, 0x04, struct blink_ioc_echo)
+#define BLINK_IOC_SET_MODE        _IOW (BLINK_IOC_MAGIC, 0x05, struct blink_ioc_mode)
+#define BLINK_IOC_GET_MODE        _IOWR(BLINK_IOC_MAGIC, 0x06, struct blink_ioc_mode)
 
 #endif /* BLINK_IOCTL_H */
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Diario binario de las operaciones de control de los blinkers (formato
+ * en blink_journal.h). Un canal relay con un buffer por CPU: escribir es
+ * copiar 24 bytes con las IRQ cortadas, sin locks compartidos.
+ *
+ * Sin lector el buffer se llena y los registros nuevos se descartan;
+ * debugfs blink_journal/dropped lleva la cuenta. enable=0 lo apaga.
+ */
+#include <linux/module.h>
+#include <linux/relay.h>
+#include <linux/debugfs.h>
+#include <linux/sched.h>
+#include <linux/timekeeping.h>
+
+#include "blink_api.h"
+#include "blink_journal.h"
+
+static bool enable = true;
+module_param(enable, bool, 0644);
+MODULE_PARM_DESC(enable, "Registrar operaciones (1) o no (0).");
+
+static unsigned int subbuf_size = 16384;
+module_param(subbuf_size, uint, 0444);
+MODULE_PARM_DESC(subbuf_size, "Bytes por sub-buffer relay.");
+
+static unsigned int n_subbufs = 8;
+module_param(n_subbufs, uint, 0444);
+MODULE_PARM_DESC(n_subbufs, "Sub-buffers relay por CPU.");
+
+static struct dentry *dir;
+static struct rchan *chan;
+static atomic_t dropped;
+
+void blink_journal_log(u16 op, u16 id, u32 val, s32 ret)
+{
+	struct blink_jrec r;
+
+	if (!READ_ONCE(enable))
+		return;
+
+	r.ts_ns = ktime_get_ns();
+	r.pid = task_tgid_nr(current);
+	r.op = op;
+	r.id = id;
+	r.val = val;
+	r.ret = ret;
+	relay_write(chan, &r, sizeof(r));
+}
+EXPORT_SYMBOL_GPL(blink_journal_log);
+
+/* Buffer lleno: no sobrescribir, lo ya escrito es lo que se quiere replicar */
+static int blink_journal_subbuf_start(struct rchan_buf *buf, void *subbuf,
+				      void *prev_subbuf, size_t prev_padding)
+{
+	if (relay_buf_full(buf)) {
+		atomic_inc(&dropped);
+		return 0;
+	}
+	return 1;
+}
+
+static struct dentry *blink_journal_create(const char *name, struct dentry *parent,
+					   umode_t mode, struct rchan_buf *buf,
+					   int *is_global)
+{
+	return debugfs_create_file(name, mode, parent, buf, &relay_file_operations);
+}
+
+static int blink_journal_remove(struct dentry *d)
+{
+	debugfs_remove(d);
+	return 0;
+}
+
+static const struct rchan_callbacks blink_journal_cb = {
+	.subbuf_start    = blink_journal_subbuf_start,
+	.create_buf_file = blink_journal_create,
+	.remove_buf_file = blink_journal_remove,
+};
+
+static int __init blink_journal_init(void)
+{
+	/* El formato lo leen herramientas de user space: no puede cambiar */
+	BUILD_BUG_ON(sizeof(struct blink_jrec) != 24);
+
+	if (subbuf_size < sizeof(struct blink_jrec) || !n_subbufs)
+		return -EINVAL;
+
+	dir = debugfs_create_dir("blink_journal", NULL);
+	chan = relay_open("cpu", dir, subbuf_size, n_subbufs, &blink_journal_cb, NULL);
+	if (!chan) {
+		debugfs_remove_recursive(dir);
+		return -ENOMEM;
+	}
+	debugfs_create_atomic_t("dropped", 0444, dir, &dropped);
+	return 0;
+}
+
+static void __exit blink_journal_exit(void)
+{
+	relay_close(chan);
+	debugfs_remove_recursive(dir);
+}
+
+module_init(blink_journal_init);
+module_exit(blink_journal_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Jaime Garcia Coronel j.gcoronel@condumex.com.mx");
+MODULE_DESCRIPTION("Diario relay por CPU de las operaciones de control de los blinkers");
@@ -0,0 +1,40 @@
+#ifndef BLINK_JOURNAL_H
+#define BLINK_JOURNAL_H
+
+#include <linux/types.h>   /* __u16, __u32, __u64 en kernel y en user space */
+
+/*
+ * Diario de operaciones de control (blink_journal.ko). Cada operación deja
+ * un registro fijo en el buffer relay de la CPU que la ejecutó:
+ *   /sys/kernel/debug/blink_journal/cpu<N>
+ * Leer consume. Los ficheros se leen por separado y se ordenan por ts_ns,
+ * que es el reloj monótono común a todas las CPUs. Ver blink_journal_replay.c.
+ *
+ * El mismo cambio puede aparecer en dos capas: un SET_MS por /dev/blinkctl
+ * deja IOC_SET_MS y también API_SET_MS. Para reproducir el tráfico hay que
+ * elegir una de las dos.
+ */
+enum {
+    BLINK_JOP_IOC_SET_MS   = 1,    /* /dev/blinkctl: ioctl o io_uring */
+    BLINK_JOP_IOC_GET_MS   = 2,
+    BLINK_JOP_IOC_SET_MODE = 3,
+    BLINK_JOP_IOC_GET_MODE = 4,
+    BLINK_JOP_IOC_ECHO     = 5,    /* val = bytes */
+
+    BLINK_JOP_API_SET_MS   = 16,   /* *_set_period exportada: val = ms pedido, sin ajustar */
+    BLINK_JOP_API_SET_MODE = 17,   /* *_set_mode exportada */
+
+    BLINK_JOP_WRITE_MS     = 32,   /* write() ASCII en /dev/hrtimer_blink */
+    BLINK_JOP_WRITE_CMDS   = 33,   /* write() binario: val = comandos del lote */
+};
+
+struct blink_jrec {
+    __u64 ts_ns;     /* ktime_get_ns() */
+    __u32 pid;       /* tgid del llamador */
+    __u16 op;        /* BLINK_JOP_* */
+    __u16 id;        /* BLINK_ID_*, 0 si no aplica */
+    __u32 val;       /* ms, modo o tamaño según op */
+    __s32 ret;       /* 0, valor devuelto o -errno */
+};
+
+#endif /* BLINK_JOURNAL_H */
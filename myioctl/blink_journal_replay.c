@@ -0,0 +1,163 @@
+// gcc -O2 -Wall -o blink_journal_replay blink_journal_replay.c
+//
+// Reproduce un diario de blink_journal.ko contra /dev/blinkctl:
+//   cat /sys/kernel/debug/blink_journal/cpu* > j.bin     (en producción)
+//   blink_journal_replay [-a] [-s factor] [-n vueltas] j.bin ...
+//
+// Los registros se ordenan por ts_ns y se lanzan con los intervalos
+// originales divididos por el factor (-s 10: diez veces más rápido; -s 0:
+// sin esperas, ráfaga a máxima velocidad). Por defecto se repiten los
+// IOC_*; con -a los API_* y WRITE_MS, convertidos a ioctl. Mezclar las
+// dos capas duplicaría los cambios.
+//
+// Al final: operaciones por segundo, latencia del ioctl y cuántos
+// resultados difieren del registrado (otro estado de partida, otro kernel).
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include "blink_ioctl.h"
+#include "blink_journal.h"
+
+static struct blink_jrec *recs;
+static size_t nrecs, cap;
+
+static int load(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    struct blink_jrec r;
+
+    if (!fp) { perror(path); return -1; }
+    while (fread(&r, sizeof(r), 1, fp) == 1) {
+        if (nrecs == cap) {
+            cap = cap ? cap * 2 : 4096;
+            recs = realloc(recs, cap * sizeof(*recs));
+            if (!recs) { perror("realloc"); exit(1); }
+        }
+        recs[nrecs++] = r;
+    }
+    fclose(fp);
+    return 0;
+}
+
+static int by_ts(const void *a, const void *b)
+{
+    const struct blink_jrec *x = a, *y = b;
+
+    return x->ts_ns < y->ts_ns ? -1 : x->ts_ns > y->ts_ns;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void sleep_until(uint64_t t)
+{
+    struct timespec ts = { .tv_sec = t / 1000000000ull, .tv_nsec = t % 1000000000ull };
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        ;
+}
+
+/* Un registro como ioctl; 1 si no se puede reproducir con esta selección */
+static int issue(int fd, const struct blink_jrec *r, int api, int *res)
+{
+    struct blink_ioc_ms a = { .id = r->id, .ms = r->val };
+    struct blink_ioc_mode m = { .id = r->id, .mode = r->val };
+    char buf[256];   /* el kernel rechaza len > 256 antes de copiar */
+    struct blink_ioc_echo e = { .user_ptr = (uintptr_t)buf, .len = r->val };
+    unsigned long cmd;
+    void *arg;
+
+    switch (r->op) {
+    case BLINK_JOP_IOC_SET_MS:   if (api) return 1; cmd = BLINK_IOC_SET_MS;   arg = &a; break;
+    case BLINK_JOP_IOC_GET_MS:   if (api) return 1; cmd = BLINK_IOC_GET_MS;   arg = &a; break;
+    case BLINK_JOP_IOC_SET_MODE: if (api) return 1; cmd = BLINK_IOC_SET_MODE; arg = &m; break;
+    case BLINK_JOP_IOC_GET_MODE: if (api) return 1; cmd = BLINK_IOC_GET_MODE; arg = &m; break;
+    case BLINK_JOP_IOC_ECHO:
+        if (api) return 1;
+        /* len tal cual: un -EINVAL registrado debe repetirse */
+        memset(buf, 'a', sizeof(buf));
+        cmd = BLINK_IOC_ECHO; arg = &e;
+        break;
+    case BLINK_JOP_API_SET_MS:
+    case BLINK_JOP_WRITE_MS:     if (!api) return 1; cmd = BLINK_IOC_SET_MS;   arg = &a; break;
+    case BLINK_JOP_API_SET_MODE: if (!api) return 1; cmd = BLINK_IOC_SET_MODE; arg = &m; break;
+    default:                     return 1;   /* WRITE_CMDS: el lote no se guarda */
+    }
+
+    *res = ioctl(fd, cmd, arg) ? -errno : 0;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    double speed = 1.0;
+    int api = 0, loops = 1, opt, fd, res, l;
+    uint64_t t0, ts0, t, dt, sum = 0, max = 0;
+    unsigned long ops = 0, skipped = 0, differ = 0;
+    size_t i;
+
+    while ((opt = getopt(argc, argv, "as:n:")) != -1) {
+        switch (opt) {
+        case 'a': api = 1; break;
+        case 's': speed = atof(optarg); break;
+        case 'n': loops = atoi(optarg); break;
+        default:
+            fprintf(stderr, "uso: %s [-a] [-s factor] [-n vueltas] diario...\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc || speed < 0 || loops < 1) {
+        fprintf(stderr, "uso: %s [-a] [-s factor] [-n vueltas] diario...\n", argv[0]);
+        return 1;
+    }
+
+    for (; optind < argc; optind++)
+        if (load(argv[optind])) return 1;
+    if (!nrecs) { fprintf(stderr, "diario vacío\n"); return 1; }
+    /* Un fichero por CPU: se intercalan por el reloj común */
+    qsort(recs, nrecs, sizeof(*recs), by_ts);
+
+    fd = open("/dev/blinkctl", O_RDWR);
+    if (fd < 0) { perror("open /dev/blinkctl"); return 1; }
+
+    t0 = now_ns();
+    for (l = 0; l < loops; l++) {
+        uint64_t base = now_ns();
+
+        ts0 = recs[0].ts_ns;
+        for (i = 0; i < nrecs; i++) {
+            if (speed > 0)
+                sleep_until(base + (uint64_t)((recs[i].ts_ns - ts0) / speed));
+            t = now_ns();
+            if (issue(fd, &recs[i], api, &res)) {
+                skipped++;
+                continue;
+            }
+            dt = now_ns() - t;
+            sum += dt;
+            if (dt > max) max = dt;
+            ops++;
+            if (res != recs[i].ret && !(res == 0 && recs[i].ret > 0))
+                differ++;
+        }
+    }
+    t = now_ns() - t0;
+
+    printf("registros %zu x %d  ops %lu  omitidos %lu  distintos %lu\n",
+           nrecs, loops, ops, skipped, differ);
+    printf("%.3f s  %.0f ops/s  ioctl avg %.2f us max %.2f us\n",
+           t / 1e9, t ? ops * 1e9 / t : 0.0,
+           ops ? sum / 1e3 / ops : 0.0, max / 1e3);
+    close(fd);
+    return 0;
+}
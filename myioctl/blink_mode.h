@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef BLINK_MODE_H
+#define BLINK_MODE_H
+
+/*
+ * Modos BLINK/ON/OFF/STOPPED y runtime PM, comunes a los motores sin DT.
+ * El dispositivo retiene una referencia de runtime PM solo mientras
+ * parpadea; en un modo fijo la suelta y autosuspend lo duerme.
+ */
+#include <linux/pm_runtime.h>
+
+#include "blink_ioctl.h"
+
+#define BLINK_AUTOSUSPEND_MS	1000
+
+static const char * const blink_mode_names[BLINK_MODE__MAX] = {
+	[BLINK_MODE_BLINK]   = "blink",
+	[BLINK_MODE_ON]      = "on",
+	[BLINK_MODE_OFF]     = "off",
+	[BLINK_MODE_STOPPED] = "stopped",
+};
+
+/* Nivel del LED al entrar en un modo fijo; STOPPED conserva el actual */
+static inline int blink_mode_level(unsigned int mode, int cur)
+{
+	switch (mode) {
+	case BLINK_MODE_ON:
+		return 1;
+	case BLINK_MODE_OFF:
+		return 0;
+	default:
+		return cur;
+	}
+}
+
+/* Al final del probe: arranca activo, en BLINK y con la referencia tomada */
+static inline int blink_pm_init(struct device *dev)
+{
+	int ret;
+
+	pm_runtime_set_autosuspend_delay(dev, BLINK_AUTOSUSPEND_MS);
+	pm_runtime_use_autosuspend(dev);
+	pm_runtime_get_noresume(dev);
+	pm_runtime_set_active(dev);
+	ret = devm_pm_runtime_enable(dev);
+	if (ret)
+		pm_runtime_put_noidle(dev);
+	return ret;
+}
+
+/* Antes de volver a parpadear */
+static inline int blink_pm_busy(struct device *dev)
+{
+	return pm_runtime_resume_and_get(dev);
+}
+
+/* Motor ya parado: autosuspend tras BLINK_AUTOSUSPEND_MS */
+static inline void blink_pm_idle(struct device *dev)
+{
+	pm_runtime_mark_last_busy(dev);
+	pm_runtime_put_autosuspend(dev);
+}
+
+/* En remove: soltar la referencia si seguía parpadeando */
+static inline void blink_pm_exit(struct device *dev, unsigned int mode)
+{
+	if (mode == BLINK_MODE_BLINK)
+		pm_runtime_put_noidle(dev);
+}
+
+#endif
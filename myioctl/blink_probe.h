@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef BLINK_PROBE_H
+#define BLINK_PROBE_H
+
+/*
+ * Tiempos de arranque de los motores sin DT, solo lectura en
+ * /sys/module/<mod>/parameters: init_us, probe_us y probe_defers.
+ *
+ * Los drivers usan PROBE_PREFER_ASYNCHRONOUS: el probe corre fuera de
+ * module_init; si el GPIO todavía no existe (expansor lento) devuelve
+ * -EPROBE_DEFER antes de reservar nada más y el core lo reintenta.
+ */
+#include <linux/moduleparam.h>
+#include <linux/platform_device.h>
+#include <linux/ktime.h>
+
+struct blink_boot {
+	unsigned long init_us;		/* module_init */
+	unsigned long probe_us;		/* último probe correcto */
+	unsigned int probe_defers;	/* probes que devolvieron -EPROBE_DEFER */
+};
+
+/* Una vez por módulo, sobre su struct blink_boot estática */
+#define BLINK_BOOT_PARAMS(b)							\
+	module_param_named(init_us, (b).init_us, ulong, 0444);			\
+	MODULE_PARM_DESC(init_us, "Duración de module_init en us");		\
+	module_param_named(probe_us, (b).probe_us, ulong, 0444);		\
+	MODULE_PARM_DESC(probe_us, "Duración del último probe correcto en us"); \
+	module_param_named(probe_defers, (b).probe_defers, uint, 0444);	\
+	MODULE_PARM_DESC(probe_defers, "Veces que el probe devolvió -EPROBE_DEFER")
+
+/* Envuelve el probe real: cuenta los aplazamientos y mide el bueno */
+static inline int blink_probe_timed(struct blink_boot *b, struct platform_device *pdev,
+				    int (*probe)(struct platform_device *))
+{
+	ktime_t t0 = ktime_get();
+	int ret = probe(pdev);
+
+	if (ret == -EPROBE_DEFER)
+		b->probe_defers++;
+	else if (!ret)
+		b->probe_us = ktime_us_delta(ktime_get(), t0);
+	return ret;
+}
+
+static inline void blink_boot_init_done(struct blink_boot *b, ktime_t t0)
+{
+	b->init_us = ktime_us_delta(ktime_get(), t0);
+}
+
+#endif /* BLINK_PROBE_H */
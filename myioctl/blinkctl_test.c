@@ -24,6 +24,18 @@ static int set_ms_from_ptr(int fd, uint32_t id, uint32_t *pms)
     struct blink_ioc_ptr p = { .id = id, .user_ptr = (uintptr_t)pms };
     return ioctl(fd, BLINK_IOC_SET_MS_FROM_PTR, &p);
 }
+static int set_mode(int fd, uint32_t id, uint32_t mode)
+{
+    struct blink_ioc_mode m = { .id = id, .mode = mode };
+    return ioctl(fd, BLINK_IOC_SET_MODE, &m);
+}
+static int get_mode(int fd, uint32_t id, uint32_t *mode)
+{
+    struct blink_ioc_mode m = { .id = id, .mode = 0 };
+    int ret = ioctl(fd, BLINK_IOC_GET_MODE, &m);
+    if (!ret) *mode = m.mode;
+    return ret;
+}
 static int echo_buf(int fd, char *buf, uint32_t len)
 {
     struct blink_ioc_echo e = { .user_ptr = (uintptr_t)buf, .len = len };
@@ -73,6 +85,14 @@ int main(void)
     if (!get_ms(fd, BLINK_ID_HRTIMER, &ms))
         printf("GET HRTIMER -> %u ms\n", ms);
 
+    /* 5) Modos: fija encendida, sin timer; luego vuelve a parpadear */
+    uint32_t mode = 0;
+    printf("MODE TIMER on\n");
+    if (set_mode(fd, BLINK_ID_TIMER, BLINK_MODE_ON)) perror("SET_MODE timer");
+    if (!get_mode(fd, BLINK_ID_TIMER, &mode))
+        printf("GET_MODE TIMER -> %u\n", mode);
+    if (set_mode(fd, BLINK_ID_TIMER, BLINK_MODE_BLINK)) perror("SET_MODE timer");
+
     close(fd);
     return 0;
 }
@@ -0,0 +1,70 @@
+// gcc -O2 -Wall -o blinkctl_uring blinkctl_uring.c -luring
+//
+// SET_MS / GET_MS sobre /dev/blinkctl por io_uring: un solo
+// io_uring_submit_and_wait() para todo el lote.
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <liburing.h>
+#include "blink_ioctl.h"
+
+static struct io_uring_sqe *prep_cmd(struct io_uring *ring, int fd, uint32_t op,
+                                     uint32_t id, uint32_t ms, uint64_t tag)
+{
+    struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+    struct blink_ioc_ms a = { .id = id, .ms = ms };
+
+    io_uring_prep_rw(IORING_OP_URING_CMD, sqe, fd, NULL, 0, 0);
+    sqe->cmd_op = op;
+    memcpy(sqe->cmd, &a, sizeof(a));   /* 16 bytes de comando en SQE de 64 */
+    sqe->user_data = tag;
+    return sqe;
+}
+
+int main(void)
+{
+    static const char *names[] = { "KTHREAD", "TIMER", "HRTIMER" };
+    struct io_uring ring;
+    struct io_uring_cqe *cqe;
+    unsigned int head, seen = 0;
+    int fd, ret;
+
+    fd = open("/dev/blinkctl", O_RDWR);
+    if (fd < 0) { perror("open"); return 1; }
+
+    ret = io_uring_queue_init(16, &ring, 0);
+    if (ret) { fprintf(stderr, "io_uring_queue_init: %s\n", strerror(-ret)); return 1; }
+
+    /* Lote: fijar los tres periodos y leerlos de vuelta */
+    for (uint32_t id = 0; id < BLINK_ID__MAX; id++) {
+        struct io_uring_sqe *set;
+
+        set = prep_cmd(&ring, fd, BLINK_IOC_SET_MS, id, 100 * (id + 1), id);
+        /* IOSQE_IO_LINK: el GET del mismo id corre después de su SET */
+        io_uring_sqe_set_flags(set, IOSQE_IO_LINK);
+        prep_cmd(&ring, fd, BLINK_IOC_GET_MS, id, 0, 0x100 | id);
+    }
+
+    ret = io_uring_submit_and_wait(&ring, 2 * BLINK_ID__MAX);
+    if (ret < 0) { fprintf(stderr, "submit: %s\n", strerror(-ret)); return 1; }
+
+    io_uring_for_each_cqe(&ring, head, cqe) {
+        uint32_t id = cqe->user_data & 0xff;
+        int is_get = cqe->user_data & 0x100;
+
+        if (cqe->res < 0)
+            printf("%s %s: %s\n", is_get ? "GET" : "SET", names[id], strerror(-cqe->res));
+        else if (is_get)
+            printf("GET %s = %d ms\n", names[id], cqe->res);
+        else
+            printf("SET %s ok\n", names[id]);
+        seen++;
+    }
+    io_uring_cq_advance(&ring, seen);
+
+    io_uring_queue_exit(&ring);
+    close(fd);
+    return 0;
+}
@@ -4,6 +4,7 @@
 #include <linux/gpio/consumer.h>
 #include <linux/gpio/machine.h>
 #include <linux/slab.h>
+#include <linux/ktime.h>
 #include <linux/hrtimer.h>
 #include <linux/workqueue.h>
 #include <linux/cdev.h>
@@ -11,17 +12,137 @@
 #include <linux/uaccess.h>
 #include <linux/mutex.h>
 #include <linux/atomic.h>
+#include <linux/spinlock.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/kthread.h>
+#include <linux/delay.h>
+#include <linux/irq_work.h>
 
 #include "blink_api.h"
+#include "blink_probe.h"
+#include "blink_gpio.h"
+#include "blink_cpu.h"
+#include "blink_cost.h"
+#include "blink_mode.h"
+#include "memacct.h"
+#include "blink_cmd.h"
 
 
+/*
+ * Modo de expiración del hrtimer. "default" es el de siempre: hardirq en
+ * un kernel normal y softirq con PREEMPT_RT. "hard" expira en hardirq
+ * también en RT (precisión, pero desaloja todo); "soft" siempre en
+ * softirq (nunca se adelanta a la pila de red).
+ */
+enum blink_expiry {
+	BLINK_EXP_DEFAULT,
+	BLINK_EXP_HARD,
+	BLINK_EXP_SOFT,
+	BLINK_EXP__MAX,
+};
+
+static const char * const blink_expiry_names[] = {
+	[BLINK_EXP_DEFAULT] = "default",
+	[BLINK_EXP_HARD]    = "hard",
+	[BLINK_EXP_SOFT]    = "soft",
+};
+
+static const enum hrtimer_mode blink_expiry_modes[] = {
+	[BLINK_EXP_DEFAULT] = HRTIMER_MODE_REL_PINNED,
+	[BLINK_EXP_HARD]    = HRTIMER_MODE_REL_PINNED_HARD,
+	[BLINK_EXP_SOFT]    = HRTIMER_MODE_REL_PINNED_SOFT,
+};
+
+/* Retraso de cada flanco respecto a su expiración, como cyclictest -h */
+#define BLINK_LAT_BUCKETS 512		/* 1 us por cubeta */
+struct blink_lat {
+	u64 count;
+	u64 sum_ns;
+	u64 min_ns;
+	u64 max_ns;
+	u64 overflow;			/* >= BLINK_LAT_BUCKETS us */
+	u32 hist[BLINK_LAT_BUCKETS];
+};
+
+/*
+ * Qué hacer si el callback llega tarde y el flanco siguiente ya venció:
+ * skip   avanza la forma de onda sin emitir los flancos perdidos; el LED
+ *        queda en el nivel y la fase que tocan ahora.
+ * replay emite los flancos perdidos seguidos (el timer vuelve a saltar
+ *        enseguida) hasta alcanzar el horario.
+ * hold   descarta los perdidos sin cambiar el nivel y salta al primer
+ *        múltiplo del intervalo actual posterior a ahora, como
+ *        hrtimer_forward_now(): no desplaza la fase.
+ */
+enum blink_catchup {
+	BLINK_CU_SKIP,
+	BLINK_CU_REPLAY,
+	BLINK_CU_HOLD,
+	BLINK_CU__MAX,
+};
+
+static const char * const blink_catchup_names[] = {
+	[BLINK_CU_SKIP]   = "skip",
+	[BLINK_CU_REPLAY] = "replay",
+	[BLINK_CU_HOLD]   = "hold",
+};
+
+/* Flancos que se recuperan de una vez; con más atraso se resincroniza */
+#define BLINK_CATCHUP_MAX 256
+
+struct blink_overrun {
+	u64 late;			/* callbacks con el siguiente flanco vencido */
+	u64 skipped;			/* flancos no emitidos (skip/hold) */
+	u64 replayed;			/* flancos emitidos tarde (replay) */
+	u64 resync;			/* atraso > BLINK_CATCHUP_MAX: horario nuevo */
+};
+
+/* Forma de onda; se cambia entera en un flanco */
+struct blink_cfg {
+	u32 period_ms;
+	u32 duty_pct;			/* 0..100 */
+	u32 phase_us;			/* retardo extra una vez, al aplicarse */
+	u32 npat;			/* 0 = periodo/duty */
+	u32 pat[BLINK_PATTERN_MAX];	/* BLINK_PAT_ON | ms */
+};
+
 struct hrtimer_blink {
+	struct device *dev;
 	struct gpio_desc *led;
 	struct hrtimer timer;
 	struct work_struct work;
-	ktime_t half_period;
+	struct delayed_work ovr_work;	/* avisa de overruns, agrupados */
+	struct irq_work ovr_irq;	/* puente desde el callback hard */
 	atomic_t state;
 	bool can_sleep;
+	unsigned int expiry;		/* enum blink_expiry */
+	unsigned int catchup;		/* enum blink_catchup */
+	int cpu;			/* CPU donde expira el timer (PINNED) */
+	struct blink_cpu place;		/* dónde se arma, bajo lock */
+
+	/*
+	 * cfg en vigor y la preparada por write(); cfg_lock desde el hrtimer.
+	 * raw: con expiry=hard el callback corre en hardirq también en RT.
+	 */
+	raw_spinlock_t cfg_lock;
+	struct blink_cfg cfg;
+	struct blink_cfg next;
+	bool has_next;
+	unsigned int step;		/* paso actual del patrón */
+	struct blink_file *next_bf;	/* fd dueño de next */
+	struct blink_lat lat;		/* bajo cfg_lock */
+	struct blink_overrun ovr;	/* bajo cfg_lock */
+	unsigned int replay_run;	/* flancos repetidos seguidos */
+	u64 wakeups;			/* disparos del hrtimer, bajo cfg_lock */
+	unsigned int mode;		/* enum BLINK_MODE_*, bajo lock */
+
+	struct blink_cost cost;		/* coste de callback, work y GPIO */
+
+	/* medición: carga sintética con BH deshabilitado en ctx->cpu */
+	struct dentry *dbg;
+	struct task_struct *load;
+	u32 load_us;
 
 	/* char dev */
 	dev_t devt;
@@ -35,44 +156,496 @@ static char *chip = (char *)"pinctrl-bcm2711";
 module_param(chip, charp, 0444);
 static int gpio = 16; module_param(gpio, int, 0444);
 static bool active_low = false; module_param(active_low, bool, 0444);
-static unsigned int start_ms = 100; module_param(start_ms, uint, 0644);
-MODULE_PARM_DESC(start_ms, "Periodo inicial en ms para /dev/blink0");
+
+/* Escribir el parámetro cambia también el periodo del dispositivo en marcha */
+static unsigned int start_ms = 100;
+static int start_ms_set(const char *val, const struct kernel_param *kp)
+{
+	int ret = param_set_uint(val, kp);
+
+	if (!ret)
+		hrtimer_blink_nodt_set_period(start_ms);
+	return ret;
+}
+
+static const struct kernel_param_ops start_ms_ops = {
+	.set = start_ms_set,
+	.get = param_get_uint,
+};
+module_param_cb(start_ms, &start_ms_ops, &start_ms, 0644);
+MODULE_PARM_DESC(start_ms, "Periodo en ms para /dev/blink0 (se aplica en marcha)");
+static char *expiry = (char *)"default";
+module_param(expiry, charp, 0444);
+MODULE_PARM_DESC(expiry, "Expiración del hrtimer: default, hard o soft");
+static bool defer_work;
+module_param(defer_work, bool, 0444);
+MODULE_PARM_DESC(defer_work, "Con expiry=hard y GPIO que duerme, diferir el flanco a un workqueue");
+static char *catchup = (char *)"skip";
+module_param(catchup, charp, 0444);
+MODULE_PARM_DESC(catchup, "Flancos perdidos: skip, replay o hold");
 
 static struct platform_device *pdev;
 static struct platform_driver drv;
 static struct gpiod_lookup_table *lt;
+static size_t lt_size;
+static struct memacct *acct_ctx, *acct_lookup;
+
+static struct blink_boot boot;
+BLINK_BOOT_PARAMS(boot);
 static struct hrtimer_blink *g_ctx; /* un solo dispositivo */
+static DEFINE_MUTEX(g_ctx_lock);    /* g_ctx frente a remove */
+static BLOCKING_NOTIFIER_HEAD(hrtimer_blink_chain);
+
+
+/* Estado por fd: resultado del último lote binario */
+struct blink_file {
+	unsigned int fate;		/* BLINK_ST_PENDING/APPLIED/CANCELLED, bajo cfg_lock */
+	unsigned int n;
+	struct blink_cmd_status st[BLINK_CMD_MAX];
+};
+
+/* El lote pendiente deja de estarlo: se aplica o se descarta. Con cfg_lock. */
+static void blink_next_done(struct hrtimer_blink *ctx, unsigned int fate)
+{
+	if (ctx->next_bf)
+		ctx->next_bf->fate = fate;
+	ctx->next_bf = NULL;
+}
 
+static void blink_cfg_default(struct blink_cfg *cfg, unsigned int ms)
+{
+	memset(cfg, 0, sizeof(*cfg));
+	cfg->period_ms = ms;
+	cfg->duty_pct = 50;
+}
+
+/* ns hasta el siguiente flanco, tras poner el LED a *on */
+static u64 blink_cfg_next(struct hrtimer_blink *ctx, int *on)
+{
+	const struct blink_cfg *cfg = &ctx->cfg;
+	u64 period = (u64)cfg->period_ms * NSEC_PER_MSEC;
+	u64 t_on = div_u64(period * cfg->duty_pct, 100);
+
+	if (cfg->npat) {
+		u32 p = cfg->pat[ctx->step];
+
+		ctx->step = (ctx->step + 1) % cfg->npat;
+		*on = !!(p & BLINK_PAT_ON);
+		return (u64)(p & ~BLINK_PAT_ON) * NSEC_PER_MSEC;
+	}
+
+	/* 0 % y 100 %: nivel fijo, se revisa una vez por periodo */
+	if (!t_on || t_on == period) {
+		*on = !!t_on;
+		return period;
+	}
+	*on = !*on;
+	return *on ? t_on : period - t_on;
+}
+
+static void blink_lat_add(struct blink_lat *l, s64 ns)
+{
+	u64 us;
+
+	if (ns < 0)
+		ns = 0;
+	us = div_u64(ns, NSEC_PER_USEC);
+
+	if (!l->count || ns < l->min_ns)
+		l->min_ns = ns;
+	if (ns > l->max_ns)
+		l->max_ns = ns;
+	l->count++;
+	l->sum_ns += ns;
+	if (us < BLINK_LAT_BUCKETS)
+		l->hist[us]++;
+	else
+		l->overflow++;
+}
+
+/*
+ * Un GPIO que duerme solo se puede mover desde un workqueue; con
+ * expiry=hard eso significa schedule_work() desde hardirq, que solo se
+ * permite si se pidió explícitamente con defer_work.
+ */
+static int blink_expiry_check(struct hrtimer_blink *ctx, unsigned int e)
+{
+	if (e == BLINK_EXP_HARD && ctx->can_sleep && !defer_work)
+		return -EINVAL;
+	return 0;
+}
+
+/* Avanza la forma de onda hasta el primer flanco posterior a now */
+static unsigned int blink_advance(struct hrtimer_blink *ctx, ktime_t *next,
+				  ktime_t now, int *on)
+{
+	unsigned int n = 0;
+
+	while (!ktime_after(*next, now) && n < BLINK_CATCHUP_MAX) {
+		*next = ktime_add_ns(*next, max_t(u64, blink_cfg_next(ctx, on), 1));
+		n++;
+	}
+	return n;
+}
+
+/*
+ * next = expiración actual + ns (lo que tocaba). Si ya pasó, aplica
+ * ctx->catchup y devuelve la nueva expiración; *on puede cambiar (skip).
+ * Con cfg_lock.
+ */
+static ktime_t blink_catchup(struct hrtimer_blink *ctx, ktime_t next, u64 ns,
+			     ktime_t now, int *on)
+{
+	unsigned int step;
+	ktime_t t;
+	u64 k;
+	int lvl;
+
+	if (ktime_after(next, now)) {
+		ctx->replay_run = 0;
+		return next;
+	}
+	ctx->ovr.late++;
+
+	switch (ctx->catchup) {
+	case BLINK_CU_SKIP:
+		ctx->ovr.skipped += blink_advance(ctx, &next, now, on);
+		break;
+	case BLINK_CU_REPLAY:
+		/* Expiración en el pasado: el hrtimer salta otra vez enseguida */
+		if (ctx->replay_run < BLINK_CATCHUP_MAX) {
+			ctx->replay_run++;
+			ctx->ovr.replayed++;
+			return next;
+		}
+		break;
+	case BLINK_CU_HOLD:
+		/* Solo se cuentan los perdidos; el patrón sigue donde iba */
+		step = ctx->step;
+		lvl = *on;
+		t = next;
+		ctx->ovr.skipped += blink_advance(ctx, &t, now, &lvl);
+		ctx->step = step;
+		k = div64_u64(ktime_to_ns(ktime_sub(now, next)), ns) + 1;
+		return ktime_add_ns(next, k * ns);
+	}
+
+	if (!ktime_after(next, now)) {
+		ctx->ovr.resync++;
+		ctx->replay_run = 0;
+		next = ktime_add_ns(now, ns);
+	}
+	return next;
+}
 
 static void blink_work(struct work_struct *w)
 {
 	struct hrtimer_blink *ctx = container_of(w, struct hrtimer_blink, work);
-	gpiod_set_value_cansleep(ctx->led, atomic_read(&ctx->state));
+	u64 t0 = blink_cost_start();
+
+	blink_cost_gpio_cansleep(&ctx->cost, ctx->led, atomic_read(&ctx->state));
+	blink_cost_end(&ctx->cost, BLINK_COST_WORK, t0);
+}
+
+/* Los contadores acumulados, como mucho un aviso por BLINK_OVR_NOTIFY_MS */
+#define BLINK_OVR_NOTIFY_MS	100
+
+static void blink_ovr_work(struct work_struct *w)
+{
+	struct hrtimer_blink *ctx = container_of(to_delayed_work(w),
+						 struct hrtimer_blink, ovr_work);
+	struct blink_event e = { .id = BLINK_ID_HRTIMER };
+
+	raw_spin_lock_irq(&ctx->cfg_lock);
+	e.late = ctx->ovr.late;
+	e.skipped = ctx->ovr.skipped;
+	e.replayed = ctx->ovr.replayed;
+	raw_spin_unlock_irq(&ctx->cfg_lock);
+	blocking_notifier_call_chain(&hrtimer_blink_chain, BLINK_EV_OVERRUN, &e);
+}
+
+/*
+ * Con expiry=hard el callback no encola works (ver blink_expiry_check):
+ * el aviso pasa por irq_work, que en RT corre en hilo.
+ */
+static void blink_ovr_irq(struct irq_work *w)
+{
+	struct hrtimer_blink *ctx = container_of(w, struct hrtimer_blink, ovr_irq);
+
+	if (!delayed_work_pending(&ctx->ovr_work))
+		schedule_delayed_work(&ctx->ovr_work,
+				      msecs_to_jiffies(BLINK_OVR_NOTIFY_MS));
 }
 
 static enum hrtimer_restart blink_hrtimer(struct hrtimer *t)
 {
 	struct hrtimer_blink *ctx = container_of(t, struct hrtimer_blink, timer);
-	int on = !atomic_read(&ctx->state);
+	int on = atomic_read(&ctx->state);
+	ktime_t now = ktime_get();
+	ktime_t next = hrtimer_get_expires(t);
+	u64 extra = 0, ns, late, t0 = blink_cost_start();
+
+	WRITE_ONCE(ctx->cpu, smp_processor_id());
+
+	/* Lote pendiente: se cambia la forma de onda justo en este flanco */
+	raw_spin_lock(&ctx->cfg_lock);
+	ctx->wakeups++;
+	blink_lat_add(&ctx->lat, ktime_to_ns(ktime_sub(now, next)));
+	if (ctx->has_next) {
+		ctx->cfg = ctx->next;
+		ctx->has_next = false;
+		ctx->step = 0;
+		blink_next_done(ctx, BLINK_ST_APPLIED);
+		extra = (u64)ctx->cfg.phase_us * NSEC_PER_USEC;
+	}
+	ns = max_t(u64, blink_cfg_next(ctx, &on) + extra, 1);
+	late = ctx->ovr.late;
+	next = blink_catchup(ctx, ktime_add_ns(next, ns), ns, now, &on);
+	late = ctx->ovr.late != late;
+	raw_spin_unlock(&ctx->cfg_lock);
+
+	/* Un aviso pendiente ya recoge este */
+	if (late)
+		irq_work_queue(&ctx->ovr_irq);
 
 	atomic_set(&ctx->state, on);
 
+	/* can_sleep con expiry=hard solo llega aquí con defer_work */
 	if (ctx->can_sleep)
 		schedule_work(&ctx->work);
 	else
-		gpiod_set_value(ctx->led, on);
+		blink_cost_gpio(&ctx->cost, ctx->led, on);
 
-	hrtimer_forward_now(&ctx->timer, ctx->half_period);
+	hrtimer_set_expires(t, next);
+	blink_cost_end(&ctx->cost, BLINK_COST_CB, t0);
 	return HRTIMER_RESTART;
 }
 
-/* --- char dev ops --- */
-static ssize_t blink_write(struct file *f, const char __user *buf, size_t len, loff_t *off)
+struct blink_arm {
+	struct hrtimer_blink *ctx;
+	ktime_t t;
+	enum hrtimer_mode mode;
+};
+
+static void blink_arm_fn(void *data)
+{
+	struct blink_arm *a = data;
+
+	hrtimer_start(&a->ctx->timer, a->t, a->mode);
+}
+
+/*
+ * PINNED deja el timer en la CPU que llama a hrtimer_start(): se arma
+ * desde la CPU que elige la política. Con ctx->lock y el timer parado.
+ */
+static void blink_arm(struct hrtimer_blink *ctx, ktime_t t, enum hrtimer_mode mode)
+{
+	struct blink_arm a = { .ctx = ctx, .t = t, .mode = mode };
+
+	cpus_read_lock();
+	smp_call_function_single(blink_cpu_pick(&ctx->place), blink_arm_fn, &a, 1);
+	cpus_read_unlock();
+}
+
+/* Cambio inmediato de periodo (ASCII y API exportada): reinicia el timer */
+static void blink_restart(struct hrtimer_blink *ctx, unsigned int ms)
+{
+	mutex_lock(&ctx->lock);
+	hrtimer_cancel(&ctx->timer);
+	raw_spin_lock_irq(&ctx->cfg_lock);
+	blink_cfg_default(&ctx->cfg, ms);
+	ctx->has_next = false;
+	blink_next_done(ctx, BLINK_ST_CANCELLED);
+	ctx->replay_run = 0;
+	raw_spin_unlock_irq(&ctx->cfg_lock);
+	/* En un modo fijo solo se guarda el periodo */
+	if (ctx->mode == BLINK_MODE_BLINK)
+		blink_arm(ctx, ms_to_ktime(ms) / 2, blink_expiry_modes[ctx->expiry]);
+	mutex_unlock(&ctx->lock);
+	blink_notify(&hrtimer_blink_chain, BLINK_ID_HRTIMER, BLINK_EV_PERIOD, ms);
+}
+
+/* Cambia el modo de expiración: el timer se reinicializa parado */
+static int blink_set_expiry(struct hrtimer_blink *ctx, unsigned int e)
+{
+	unsigned int ms;
+	int ret = blink_expiry_check(ctx, e);
+
+	if (ret)
+		return ret;
+
+	mutex_lock(&ctx->lock);
+	hrtimer_cancel(&ctx->timer);
+	ctx->expiry = e;
+	hrtimer_init(&ctx->timer, CLOCK_MONOTONIC, blink_expiry_modes[e]);
+	ctx->timer.function = blink_hrtimer;
+	raw_spin_lock_irq(&ctx->cfg_lock);
+	memset(&ctx->lat, 0, sizeof(ctx->lat));
+	ms = ctx->cfg.period_ms;
+	raw_spin_unlock_irq(&ctx->cfg_lock);
+	if (ctx->mode == BLINK_MODE_BLINK)
+		blink_arm(ctx, ms_to_ktime(ms) / 2, blink_expiry_modes[e]);
+	mutex_unlock(&ctx->lock);
+	return 0;
+}
+
+/*
+ * Fuera de BLINK ni hrtimer ni work: cero disparos. Un lote binario
+ * pendiente se aplica en el primer flanco al volver a BLINK.
+ */
+static int blink_set_mode(struct hrtimer_blink *ctx, unsigned int mode)
+{
+	unsigned int old, ms;
+	int ret = 0;
+
+	if (mode >= BLINK_MODE__MAX)
+		return -EINVAL;
+
+	mutex_lock(&ctx->lock);
+	old = ctx->mode;
+	if (mode == BLINK_MODE_BLINK) {
+		if (old != BLINK_MODE_BLINK) {
+			ret = blink_pm_busy(ctx->dev);
+			if (!ret) {
+				ctx->mode = mode;
+				raw_spin_lock_irq(&ctx->cfg_lock);
+				ms = ctx->cfg.period_ms;
+				ctx->replay_run = 0;
+				raw_spin_unlock_irq(&ctx->cfg_lock);
+				blink_arm(ctx, ms_to_ktime(ms) / 2,
+					  blink_expiry_modes[ctx->expiry]);
+			}
+		}
+		goto out;
+	}
+
+	if (old == BLINK_MODE_BLINK) {
+		hrtimer_cancel(&ctx->timer);
+		cancel_work_sync(&ctx->work);
+	}
+	atomic_set(&ctx->state, blink_mode_level(mode, atomic_read(&ctx->state)));
+	gpiod_set_value_cansleep(ctx->led, atomic_read(&ctx->state));
+	ctx->mode = mode;
+	if (old == BLINK_MODE_BLINK)
+		blink_pm_idle(ctx->dev);
+out:
+	mutex_unlock(&ctx->lock);
+	if (!ret && mode != old)
+		blink_notify(&hrtimer_blink_chain, BLINK_ID_HRTIMER, BLINK_EV_MODE, mode);
+	return ret;
+}
+
+static int blink_cmd_apply(struct blink_cfg *cfg, const struct blink_cmd *c)
+{
+	if (c->magic != BLINK_CMD_MAGIC)
+		return -EINVAL;
+
+	switch (c->op) {
+	case BLINK_CMD_PERIOD:
+		if (!c->arg) return -EINVAL;
+		cfg->period_ms = c->arg;
+		return 0;
+	case BLINK_CMD_DUTY:
+		if (c->arg > 100) return -ERANGE;
+		cfg->duty_pct = c->arg;
+		return 0;
+	case BLINK_CMD_PHASE:
+		cfg->phase_us = c->arg;
+		return 0;
+	case BLINK_CMD_PATTERN_STEP:
+		if (!(c->arg & ~BLINK_PAT_ON)) return -EINVAL;
+		if (cfg->npat >= BLINK_PATTERN_MAX) return -ENOSPC;
+		cfg->pat[cfg->npat++] = c->arg;
+		return 0;
+	case BLINK_CMD_PATTERN_CLEAR:
+		cfg->npat = 0;
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+/*
+ * Lote binario: se aplica sobre la cfg pendiente (o la vigente) en una
+ * copia; si todo es válido se deja en ctx->next para el próximo flanco.
+ */
+static ssize_t blink_write_cmds(struct hrtimer_blink *ctx, struct blink_file *bf,
+				const char __user *buf, size_t len)
+{
+	struct blink_cmd *cmds;
+	struct blink_cfg cfg;
+	unsigned int i, n = len / sizeof(*cmds);
+	int err = 0;
+
+	if (len % sizeof(*cmds) || n > BLINK_CMD_MAX)
+		return -EINVAL;
+
+	cmds = memdup_user(buf, len);
+	if (IS_ERR(cmds))
+		return PTR_ERR(cmds);
+
+	mutex_lock(&ctx->lock);
+	raw_spin_lock_irq(&ctx->cfg_lock);
+	cfg = ctx->has_next ? ctx->next : ctx->cfg;
+	raw_spin_unlock_irq(&ctx->cfg_lock);
+
+	/* El retardo de fase es de un solo uso por lote */
+	cfg.phase_us = 0;
+
+	for (i = 0; i < n; i++) {
+		bf->st[i].seq = cmds[i].seq;
+		bf->st[i].op = cmds[i].op;
+		bf->st[i].err = 0;
+		bf->st[i].state = BLINK_ST_SKIPPED;
+		if (err)
+			continue;
+		err = blink_cmd_apply(&cfg, &cmds[i]);
+		if (err) {
+			bf->st[i].state = BLINK_ST_ERROR;
+			bf->st[i].err = err;
+		}
+	}
+	bf->n = n;
+
+	if (!err) {
+		for (i = 0; i < n; i++)
+			bf->st[i].state = BLINK_ST_PENDING;
+		raw_spin_lock_irq(&ctx->cfg_lock);
+		ctx->next = cfg;
+		ctx->has_next = true;
+		/* El lote anterior, si seguía pendiente, ya no se aplicará */
+		blink_next_done(ctx, BLINK_ST_CANCELLED);
+		bf->fate = BLINK_ST_PENDING;
+		ctx->next_bf = bf;
+		raw_spin_unlock_irq(&ctx->cfg_lock);
+	}
+	mutex_unlock(&ctx->lock);
+
+	kfree(cmds);
+	return err ? -EINVAL : len;
+}
+
+/* --- char dev ops: todas con g_ctx_lock, el fd sobrevive al unbind --- */
+static ssize_t blink_write_locked(struct file *f, const char __user *buf, size_t len, loff_t *off)
 {
 	char tmp[32];
 	unsigned long ms;
+	u8 first;
 
 	if (!g_ctx) return -ENODEV;
+	if (!len) return 0;
+	if (get_user(first, buf)) return -EFAULT;
+	if (first == BLINK_CMD_MAGIC) {
+		ssize_t ret;
+
+		/* read() devolverá el estado de este lote desde el principio */
+		*off = 0;
+		ret = blink_write_cmds(g_ctx, f->private_data, buf, len);
+		blink_journal_log(BLINK_JOP_WRITE_CMDS, BLINK_ID_HRTIMER,
+				  len / sizeof(struct blink_cmd), ret < 0 ? ret : 0);
+		return ret;
+	}
+
 	if (len >= sizeof(tmp)) return -EINVAL;
 	if (copy_from_user(tmp, buf, len)) return -EFAULT;
 	tmp[len] = '\0';
@@ -80,48 +653,604 @@ static ssize_t blink_write(struct file *f, const char __user *buf, size_t len, l
 	if (kstrtoul(tmp, 10, &ms)) return -EINVAL;
 	if (ms < 1) ms = 1;
 
+	blink_restart(g_ctx, ms);
+	blink_journal_log(BLINK_JOP_WRITE_MS, BLINK_ID_HRTIMER, ms, 0);
+	return len;
+}
+
+static ssize_t blink_write(struct file *f, const char __user *buf, size_t len, loff_t *off)
+{
+	ssize_t ret;
+
+	mutex_lock(&g_ctx_lock);
+	ret = blink_write_locked(f, buf, len, off);
+	mutex_unlock(&g_ctx_lock);
+	return ret;
+}
+
+/* Estado por comando del último lote de este fd */
+static ssize_t blink_read(struct file *f, char __user *buf, size_t len, loff_t *off)
+{
+	struct blink_file *bf = f->private_data;
+	struct blink_cmd_status st[BLINK_CMD_MAX];
+	unsigned int i, n, fate;
+
+	mutex_lock(&g_ctx_lock);
+	if (!g_ctx) {
+		mutex_unlock(&g_ctx_lock);
+		return -ENODEV;
+	}
+
+	/* bf->st lo reescribe blink_write_cmds() con ctx->lock */
 	mutex_lock(&g_ctx->lock);
-	g_ctx->half_period = ktime_set(0, (u64)ms * 1000000ULL / 2);
-	hrtimer_cancel(&g_ctx->timer);
-	hrtimer_start(&g_ctx->timer, g_ctx->half_period, HRTIMER_MODE_REL_PINNED);
+	raw_spin_lock_irq(&g_ctx->cfg_lock);
+	fate = bf->fate;
+	raw_spin_unlock_irq(&g_ctx->cfg_lock);
+
+	n = bf->n;
+	for (i = 0; i < n; i++) {
+		st[i] = bf->st[i];
+		if (st[i].state == BLINK_ST_PENDING)
+			st[i].state = fate;
+	}
 	mutex_unlock(&g_ctx->lock);
+	mutex_unlock(&g_ctx_lock);
 
-	return len;
+	return simple_read_from_buffer(buf, len, off, st, n * sizeof(st[0]));
+}
+
+static int blink_open(struct inode *i, struct file *f)
+{
+	int ret = -ENODEV;
+
+	mutex_lock(&g_ctx_lock);
+	if (g_ctx) {
+		f->private_data = memacct_kzalloc(acct_ctx, sizeof(struct blink_file), GFP_KERNEL);
+		ret = f->private_data ? 0 : -ENOMEM;
+	}
+	mutex_unlock(&g_ctx_lock);
+	return ret;
 }
 
-static int blink_open(struct inode *i, struct file *f) { return g_ctx ? 0 : -ENODEV; }
-static int blink_release(struct inode *i, struct file *f) { return 0; }
+static int blink_release(struct inode *i, struct file *f)
+{
+	/* Un lote pendiente se aplica igual, pero ya no hay a quién avisar */
+	mutex_lock(&g_ctx_lock);
+	if (g_ctx) {
+		raw_spin_lock_irq(&g_ctx->cfg_lock);
+		if (g_ctx->next_bf == f->private_data)
+			g_ctx->next_bf = NULL;
+		raw_spin_unlock_irq(&g_ctx->cfg_lock);
+	}
+	mutex_unlock(&g_ctx_lock);
+	memacct_kfree(acct_ctx, f->private_data, sizeof(struct blink_file));
+	return 0;
+}
 
 static const struct file_operations blink_fops = {
 	.owner   = THIS_MODULE,
 	.open    = blink_open,
 	.release = blink_release,
+	.read    = blink_read,
 	.write   = blink_write,
 };
 
-static int hrtimer_blink_probe(struct platform_device *pdev)
+/*
+ * Atributos del dispositivo (/sys/devices/platform/hrtimer-blink-nodt.0):
+ * periodo, línea y polaridad se aplican sobre la marcha.
+ */
+static ssize_t period_ms_show(struct device *dev, struct device_attribute *attr,
+			      char *buf)
 {
-	struct hrtimer_blink *ctx;
+	struct hrtimer_blink *ctx = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%u\n", READ_ONCE(ctx->cfg.period_ms));
+}
+
+static ssize_t period_ms_store(struct device *dev, struct device_attribute *attr,
+			       const char *buf, size_t len)
+{
+	unsigned int ms;
+	int ret = kstrtouint(buf, 0, &ms);
+
+	if (ret)
+		return ret;
+	blink_restart(dev_get_drvdata(dev), ms ?: 1);
+	return len;
+}
+static DEVICE_ATTR_RW(period_ms);
+
+/*
+ * Con el timer y el work parados nadie toca ctx->led; el timer vuelve en
+ * su misma expiración absoluta, así el cambio no mueve la fase.
+ */
+static int hrtimer_blink_set_led(struct device *dev, unsigned int line, bool low)
+{
+	struct hrtimer_blink *ctx = dev_get_drvdata(dev);
+	unsigned int old_line = blink_gpio_line(lt);
+	bool old_low = blink_gpio_active_low(lt);
+	struct gpio_desc *d = NULL;
+	int ret = 0;
+
+	mutex_lock(&ctx->lock);
+	if (line != old_line) {
+		d = blink_gpio_get(dev, lt, line, low);
+		if (IS_ERR(d)) {
+			ret = PTR_ERR(d);
+			goto out;
+		}
+		/* Misma regla que blink_expiry_check() para la línea nueva */
+		if (ctx->expiry == BLINK_EXP_HARD && gpiod_cansleep(d) && !defer_work) {
+			blink_gpio_put(dev, d);
+			blink_gpio_set_lookup(lt, old_line, old_low);
+			ret = -EINVAL;
+			goto out;
+		}
+	}
+
+	hrtimer_cancel(&ctx->timer);
+	cancel_work_sync(&ctx->work);
+	if (d) {
+		blink_gpio_put(dev, ctx->led);
+		ctx->led = d;
+		ctx->can_sleep = gpiod_cansleep(d);
+	} else {
+		blink_gpio_polarity(lt, ctx->led, low);
+	}
+	gpiod_set_value_cansleep(ctx->led, atomic_read(&ctx->state));
+	if (ctx->mode == BLINK_MODE_BLINK)
+		blink_arm(ctx, hrtimer_get_expires(&ctx->timer),
+			  blink_expiry_modes[ctx->expiry] & ~HRTIMER_MODE_REL);
+out:
+	mutex_unlock(&ctx->lock);
+	return ret;
+}
+
+static ssize_t gpio_show(struct device *dev, struct device_attribute *attr,
+			 char *buf)
+{
+	return sysfs_emit(buf, "%u\n", blink_gpio_line(lt));
+}
+
+static ssize_t gpio_store(struct device *dev, struct device_attribute *attr,
+			  const char *buf, size_t len)
+{
+	unsigned int line;
+	int ret = kstrtouint(buf, 0, &line);
+
+	if (!ret)
+		ret = hrtimer_blink_set_led(dev, line, blink_gpio_active_low(lt));
+	return ret ? ret : len;
+}
+static DEVICE_ATTR_RW(gpio);
+
+static ssize_t active_low_show(struct device *dev, struct device_attribute *attr,
+			       char *buf)
+{
+	return sysfs_emit(buf, "%d\n", blink_gpio_active_low(lt));
+}
+
+static ssize_t active_low_store(struct device *dev, struct device_attribute *attr,
+				const char *buf, size_t len)
+{
+	bool low;
+	int ret = kstrtobool(buf, &low);
+
+	if (!ret)
+		ret = hrtimer_blink_set_led(dev, blink_gpio_line(lt), low);
+	return ret ? ret : len;
+}
+static DEVICE_ATTR_RW(active_low);
+
+static ssize_t mode_show(struct device *dev, struct device_attribute *attr,
+			 char *buf)
+{
+	struct hrtimer_blink *ctx = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%s\n", blink_mode_names[READ_ONCE(ctx->mode)]);
+}
+
+static ssize_t mode_store(struct device *dev, struct device_attribute *attr,
+			  const char *buf, size_t len)
+{
+	int mode = sysfs_match_string(blink_mode_names, buf);
+
+	if (mode < 0)
+		return mode;
+	mode = blink_set_mode(dev_get_drvdata(dev), mode);
+	return mode ? mode : len;
+}
+static DEVICE_ATTR_RW(mode);
+
+/* En un modo fijo no debe moverse: no hay hrtimer armado */
+static ssize_t wakeups_show(struct device *dev, struct device_attribute *attr,
+			    char *buf)
+{
+	struct hrtimer_blink *ctx = dev_get_drvdata(dev);
+	u64 n;
+
+	raw_spin_lock_irq(&ctx->cfg_lock);
+	n = ctx->wakeups;
+	raw_spin_unlock_irq(&ctx->cfg_lock);
+	return sysfs_emit(buf, "%llu\n", n);
+}
+static DEVICE_ATTR_RO(wakeups);
+
+/* Migra el timer a la CPU nueva en su misma expiración absoluta */
+static ssize_t placement_show(struct device *dev, struct device_attribute *attr,
+			      char *buf)
+{
+	struct hrtimer_blink *ctx = dev_get_drvdata(dev);
+
+	return blink_cpu_show(&ctx->place, buf);
+}
+
+static ssize_t placement_store(struct device *dev, struct device_attribute *attr,
+			       const char *buf, size_t len)
+{
+	struct hrtimer_blink *ctx = dev_get_drvdata(dev);
+	unsigned int policy;
+	cpumask_var_t m;
 	int ret;
+
+	if (!alloc_cpumask_var(&m, GFP_KERNEL))
+		return -ENOMEM;
+	ret = blink_cpu_parse(&ctx->place, buf, &policy, m);
+	if (ret)
+		goto out;
+
+	mutex_lock(&ctx->lock);
+	ctx->place.policy = policy;
+	cpumask_copy(&ctx->place.want, m);
+	if (ctx->mode == BLINK_MODE_BLINK) {
+		hrtimer_cancel(&ctx->timer);
+		blink_arm(ctx, hrtimer_get_expires(&ctx->timer),
+			  blink_expiry_modes[ctx->expiry] & ~HRTIMER_MODE_REL);
+	}
+	mutex_unlock(&ctx->lock);
+out:
+	free_cpumask_var(m);
+	return ret ? ret : len;
+}
+static DEVICE_ATTR_RW(placement);
+
+static struct attribute *hrtimer_blink_attrs[] = {
+	&dev_attr_period_ms.attr,
+	&dev_attr_gpio.attr,
+	&dev_attr_active_low.attr,
+	&dev_attr_mode.attr,
+	&dev_attr_wakeups.attr,
+	&dev_attr_placement.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(hrtimer_blink);
+
+/* --- debugfs: modo de expiración, latencia de flancos y carga sintética --- */
+/*
+ * Comparar modos bajo carga (cambiar de modo pone el histograma a cero):
+ *   cd /sys/kernel/debug/hrtimer_blink
+ *   echo 500 > load_us
+ *   echo soft > expiry; sleep 30; cat latency > soft.hist
+ *   echo hard > expiry; sleep 30; cat latency > hard.hist
+ *   echo 0 > load_us
+ * overruns cuenta los flancos que llegaron tarde y qué hizo catchup; cost,
+ * lo que costó cada flanco en CPU (ver blink_cost.h).
+ */
+
+/* "a [b] c": opciones con la vigente entre corchetes */
+static void blink_show_choice(struct seq_file *m, const char * const *names,
+			      int n, unsigned int cur)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		seq_printf(m, i == cur ? "[%s] " : "%s ", names[i]);
+	seq_putc(m, '\n');
+}
+
+static int blink_read_choice(const char __user *ubuf, size_t len,
+			     const char * const *names, int n)
+{
+	char name[16];
+
+	if (len >= sizeof(name))
+		return -EINVAL;
+	if (copy_from_user(name, ubuf, len))
+		return -EFAULT;
+	name[len] = '\0';
+	return __sysfs_match_string(names, n, name);
+}
+
+static int blink_expiry_show(struct seq_file *m, void *v)
+{
+	struct hrtimer_blink *ctx = m->private;
+
+	blink_show_choice(m, blink_expiry_names, BLINK_EXP__MAX, ctx->expiry);
+	return 0;
+}
+
+static int blink_expiry_open(struct inode *i, struct file *f)
+{
+	return single_open(f, blink_expiry_show, i->i_private);
+}
+
+static ssize_t blink_expiry_write(struct file *f, const char __user *ubuf,
+				  size_t len, loff_t *off)
+{
+	struct hrtimer_blink *ctx = file_inode(f)->i_private;
+	int e, ret;
+
+	e = blink_read_choice(ubuf, len, blink_expiry_names, BLINK_EXP__MAX);
+	if (e < 0)
+		return e;
+	ret = blink_set_expiry(ctx, e);
+	return ret ? ret : len;
+}
+
+static const struct file_operations blink_expiry_fops = {
+	.owner   = THIS_MODULE,
+	.open    = blink_expiry_open,
+	.read    = seq_read,
+	.write   = blink_expiry_write,
+	.llseek  = seq_lseek,
+	.release = single_release,
+};
+
+static int blink_catchup_show(struct seq_file *m, void *v)
+{
+	struct hrtimer_blink *ctx = m->private;
+
+	blink_show_choice(m, blink_catchup_names, BLINK_CU__MAX,
+			  READ_ONCE(ctx->catchup));
+	return 0;
+}
+
+static int blink_catchup_open(struct inode *i, struct file *f)
+{
+	return single_open(f, blink_catchup_show, i->i_private);
+}
+
+/* Efecto en el próximo flanco tardío, sin parar el timer */
+static ssize_t blink_catchup_write(struct file *f, const char __user *ubuf,
+				   size_t len, loff_t *off)
+{
+	struct hrtimer_blink *ctx = file_inode(f)->i_private;
+	int c;
+
+	c = blink_read_choice(ubuf, len, blink_catchup_names, BLINK_CU__MAX);
+	if (c < 0)
+		return c;
+
+	raw_spin_lock_irq(&ctx->cfg_lock);
+	ctx->catchup = c;
+	ctx->replay_run = 0;
+	raw_spin_unlock_irq(&ctx->cfg_lock);
+	return len;
+}
+
+static const struct file_operations blink_catchup_fops = {
+	.owner   = THIS_MODULE,
+	.open    = blink_catchup_open,
+	.read    = seq_read,
+	.write   = blink_catchup_write,
+	.llseek  = seq_lseek,
+	.release = single_release,
+};
+
+static int blink_overruns_show(struct seq_file *m, void *v)
+{
+	struct hrtimer_blink *ctx = m->private;
+	struct blink_overrun o;
+
+	raw_spin_lock_irq(&ctx->cfg_lock);
+	o = ctx->ovr;
+	raw_spin_unlock_irq(&ctx->cfg_lock);
+
+	seq_printf(m, "late %llu\nskipped %llu\nreplayed %llu\nresync %llu\n",
+		   o.late, o.skipped, o.replayed, o.resync);
+	return 0;
+}
+
+static int blink_overruns_open(struct inode *i, struct file *f)
+{
+	return single_open(f, blink_overruns_show, i->i_private);
+}
+
+/* Cualquier escritura pone los contadores a cero */
+static ssize_t blink_overruns_write(struct file *f, const char __user *ubuf,
+				    size_t len, loff_t *off)
+{
+	struct hrtimer_blink *ctx = file_inode(f)->i_private;
+
+	raw_spin_lock_irq(&ctx->cfg_lock);
+	memset(&ctx->ovr, 0, sizeof(ctx->ovr));
+	raw_spin_unlock_irq(&ctx->cfg_lock);
+	return len;
+}
+
+static const struct file_operations blink_overruns_fops = {
+	.owner   = THIS_MODULE,
+	.open    = blink_overruns_open,
+	.read    = seq_read,
+	.write   = blink_overruns_write,
+	.llseek  = seq_lseek,
+	.release = single_release,
+};
+
+static int blink_latency_show(struct seq_file *m, void *v)
+{
+	struct hrtimer_blink *ctx = m->private;
+	struct blink_lat *l;
+	unsigned int e;
+	int i;
+
+	/* Copia: no se imprime con el lock del hrtimer tomado */
+	l = kmalloc(sizeof(*l), GFP_KERNEL);
+	if (!l)
+		return -ENOMEM;
+	raw_spin_lock_irq(&ctx->cfg_lock);
+	*l = ctx->lat;
+	e = ctx->expiry;
+	raw_spin_unlock_irq(&ctx->cfg_lock);
+
+	seq_printf(m, "# expiry %s cpu %d load_us %u\n", blink_expiry_names[e],
+		   READ_ONCE(ctx->cpu), READ_ONCE(ctx->load_us));
+	seq_printf(m, "# edges %llu min %llu avg %llu max %llu ns\n", l->count,
+		   l->min_ns, l->count ? div64_u64(l->sum_ns, l->count) : 0,
+		   l->max_ns);
+	for (i = 0; i < BLINK_LAT_BUCKETS; i++)
+		if (l->hist[i])
+			seq_printf(m, "%06d %u\n", i, l->hist[i]);
+	seq_printf(m, "# overflow %llu\n", l->overflow);
+
+	kfree(l);
+	return 0;
+}
+
+static int blink_latency_open(struct inode *i, struct file *f)
+{
+	return single_open(f, blink_latency_show, i->i_private);
+}
+
+/* Cualquier escritura pone el histograma a cero */
+static ssize_t blink_latency_write(struct file *f, const char __user *ubuf,
+				   size_t len, loff_t *off)
+{
+	struct hrtimer_blink *ctx = file_inode(f)->i_private;
+
+	raw_spin_lock_irq(&ctx->cfg_lock);
+	memset(&ctx->lat, 0, sizeof(ctx->lat));
+	raw_spin_unlock_irq(&ctx->cfg_lock);
+	return len;
+}
+
+static const struct file_operations blink_latency_fops = {
+	.owner   = THIS_MODULE,
+	.open    = blink_latency_open,
+	.read    = seq_read,
+	.write   = blink_latency_write,
+	.llseek  = seq_lseek,
+	.release = single_release,
+};
+
+/*
+ * Carga sintética: load_us con BH deshabilitado y otro tanto dormido, en
+ * la CPU del timer. Retrasa el softirq como lo haría la pila de red; un
+ * timer "hard" no debería notarlo.
+ */
+static int blink_load_fn(void *data)
+{
+	struct hrtimer_blink *ctx = data;
+
+	while (!kthread_should_stop()) {
+		u32 us = READ_ONCE(ctx->load_us), i;
+
+		local_bh_disable();
+		for (i = 0; i < us; i += 100)
+			udelay(min_t(u32, us - i, 100));
+		local_bh_enable();
+		usleep_range(us, us + 100);
+	}
+	return 0;
+}
+
+static void blink_load_stop(struct hrtimer_blink *ctx)
+{
+	if (ctx->load) {
+		kthread_stop(ctx->load);
+		ctx->load = NULL;
+	}
+}
+
+static int blink_load_get(void *data, u64 *val)
+{
+	struct hrtimer_blink *ctx = data;
+
+	*val = READ_ONCE(ctx->load_us);
+	return 0;
+}
+
+static int blink_load_set(void *data, u64 val)
+{
+	struct hrtimer_blink *ctx = data;
+	struct task_struct *t;
+	int cpu, ret = 0;
+
+	if (val > USEC_PER_SEC)
+		return -ERANGE;
+
+	mutex_lock(&ctx->lock);
+	WRITE_ONCE(ctx->load_us, val);
+	if (!val) {
+		blink_load_stop(ctx);
+	} else if (!ctx->load) {
+		cpu = READ_ONCE(ctx->cpu);
+		t = kthread_create(blink_load_fn, ctx, "blink_load/%d", cpu);
+		if (IS_ERR(t)) {
+			ret = PTR_ERR(t);
+		} else {
+			kthread_bind(t, cpu);
+			ctx->load = t;
+			wake_up_process(t);
+		}
+	}
+	mutex_unlock(&ctx->lock);
+	return ret;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(blink_load_fops, blink_load_get, blink_load_set, "%llu\n");
+
+static void blink_debugfs_init(struct hrtimer_blink *ctx)
+{
+	ctx->dbg = debugfs_create_dir("hrtimer_blink", NULL);
+	debugfs_create_file("expiry", 0644, ctx->dbg, ctx, &blink_expiry_fops);
+	debugfs_create_file("latency", 0644, ctx->dbg, ctx, &blink_latency_fops);
+	debugfs_create_file("catchup", 0644, ctx->dbg, ctx, &blink_catchup_fops);
+	debugfs_create_file("overruns", 0644, ctx->dbg, ctx, &blink_overruns_fops);
+	debugfs_create_file_unsafe("load_us", 0644, ctx->dbg, ctx, &blink_load_fops);
+	blink_cost_debugfs(ctx->dbg, &ctx->cost);
+}
+
+static int hrtimer_blink_do_probe(struct platform_device *pdev)
+{
+	struct hrtimer_blink *ctx;
+	int ret, e, c;
 	unsigned int ms = start_ms ?: 1;
 
-	ctx = devm_kzalloc(&pdev->dev, sizeof(*ctx), GFP_KERNEL);
+	e = sysfs_match_string(blink_expiry_names, expiry);
+	if (e < 0)
+		return dev_err_probe(&pdev->dev, -EINVAL, "expiry=%s\n", expiry);
+	c = sysfs_match_string(blink_catchup_names, catchup);
+	if (c < 0)
+		return dev_err_probe(&pdev->dev, -EINVAL, "catchup=%s\n", catchup);
+
+	ctx = memacct_devm_kzalloc(acct_ctx, &pdev->dev, sizeof(*ctx), GFP_KERNEL);
 	if (!ctx) return -ENOMEM;
 
 	mutex_init(&ctx->lock);
+	raw_spin_lock_init(&ctx->cfg_lock);
+	ctx->dev = &pdev->dev;
+	ctx->mode = BLINK_MODE_BLINK;
+	ret = blink_cost_init(&pdev->dev, &ctx->cost);
+	if (ret) return ret;
 
 	ctx->led = devm_gpiod_get(&pdev->dev, "led", GPIOD_OUT_LOW);
 	if (IS_ERR(ctx->led))
 		return dev_err_probe(&pdev->dev, PTR_ERR(ctx->led), "gpiod_get\n");
 
 	ctx->can_sleep = gpiod_cansleep(ctx->led);
+	ctx->expiry = e;
+	ctx->catchup = c;
+	if (blink_expiry_check(ctx, e))
+		return dev_err_probe(&pdev->dev, -EINVAL,
+				     "expiry=hard con un GPIO que duerme requiere defer_work=1\n");
 
 	INIT_WORK(&ctx->work, blink_work);
-	hrtimer_init(&ctx->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL_PINNED);
+	INIT_DELAYED_WORK(&ctx->ovr_work, blink_ovr_work);
+	init_irq_work(&ctx->ovr_irq, blink_ovr_irq);
+	hrtimer_init(&ctx->timer, CLOCK_MONOTONIC, blink_expiry_modes[e]);
 	ctx->timer.function = blink_hrtimer;
 	atomic_set(&ctx->state, 0);
-	ctx->half_period = ktime_set(0, (u64)ms * 1000000ULL / 2);
-	hrtimer_start(&ctx->timer, ctx->half_period, HRTIMER_MODE_REL_PINNED);
+	blink_cfg_default(&ctx->cfg, ms);
 
 	/* char device */
 	ret = alloc_chrdev_region(&ctx->devt, 0, 1, "blink");
@@ -137,12 +1266,27 @@ static int hrtimer_blink_probe(struct platform_device *pdev)
 	ctx->devnode = device_create(ctx->cls, NULL, ctx->devt, NULL, "blink0");
 	if (IS_ERR(ctx->devnode)) { ret = PTR_ERR(ctx->devnode); goto err_class; }
 
+	ret = blink_pm_init(&pdev->dev);
+	if (ret) goto err_dev;
+
 	platform_set_drvdata(pdev, ctx);
+	mutex_lock(&g_ctx_lock);
 	g_ctx = ctx;
+	mutex_unlock(&g_ctx_lock);
+	blink_cpu_init(&ctx->place, BLINK_ID_HRTIMER, HK_TYPE_TIMER);
+	ctx->cpu = raw_smp_processor_id();
+	blink_debugfs_init(ctx);
+
+	/* Al final: si algo de arriba falla (o se difiere) no queda un
+	 * timer armado sobre un ctx que devres va a liberar */
+	blink_arm(ctx, ms_to_ktime(ms) / 2, blink_expiry_modes[e]);
 
-	dev_info(&pdev->dev, "hrtimer blink: %u ms (escribe ms en /dev/blink0)\n", ms);
+	dev_info(&pdev->dev, "hrtimer blink: %u ms, expiry %s (escribe ms en /dev/blink0)\n",
+		 ms, blink_expiry_names[e]);
 	return 0;
 
+err_dev:
+	device_destroy(ctx->cls, ctx->devt);
 err_class:
 	class_destroy(ctx->cls);
 err_cdev:
@@ -156,61 +1300,125 @@ static int hrtimer_blink_remove(struct platform_device *pdev)
 {
 	struct hrtimer_blink *ctx = platform_get_drvdata(pdev);
 
+	/* Primero: ni la API ni los fd abiertos pueden rearmar el timer */
+	mutex_lock(&g_ctx_lock);
+	g_ctx = NULL;
+	mutex_unlock(&g_ctx_lock);
+
+	debugfs_remove_recursive(ctx->dbg);
+	blink_load_stop(ctx);
 	hrtimer_cancel(&ctx->timer);
 	cancel_work_sync(&ctx->work);
+	irq_work_sync(&ctx->ovr_irq);
+	cancel_delayed_work_sync(&ctx->ovr_work);
 	gpiod_set_value_cansleep(ctx->led, 0);
+	blink_pm_exit(&pdev->dev, ctx->mode);
 
 	if (ctx->devnode) device_destroy(ctx->cls, ctx->devt);
 	if (ctx->cls)     class_destroy(ctx->cls);
 	cdev_del(&ctx->cdev);
 	unregister_chrdev_region(ctx->devt, 1);
-	g_ctx = NULL;
 	return 0;
 }
 
+static int hrtimer_blink_probe(struct platform_device *pdev)
+{
+	return blink_probe_timed(&boot, pdev, hrtimer_blink_do_probe);
+}
+
 static struct platform_driver drv = {
 	.probe  = hrtimer_blink_probe,
 	.remove = hrtimer_blink_remove,
 	.driver = {
 		.name = "hrtimer-blink-nodt",
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
+		.dev_groups = hrtimer_blink_groups,
 	},
 };
 
 
 int hrtimer_blink_nodt_set_period(unsigned int ms)
 {
-    if (!g_ctx) return -ENODEV;
-    if (ms < 1) ms = 1;
+    int ret = 0;
 
-    mutex_lock(&g_ctx->lock);
-    g_ctx->half_period = ktime_set(0, (u64)ms * 1000000ULL / 2);
-    hrtimer_cancel(&g_ctx->timer);
-    hrtimer_start(&g_ctx->timer, g_ctx->half_period, HRTIMER_MODE_REL_PINNED);
-    mutex_unlock(&g_ctx->lock);
-    return 0;
+    mutex_lock(&g_ctx_lock);
+    if (g_ctx)
+        blink_restart(g_ctx, ms ?: 1);
+    else
+        ret = -ENODEV;
+    mutex_unlock(&g_ctx_lock);
+    blink_journal_log(BLINK_JOP_API_SET_MS, BLINK_ID_HRTIMER, ms, ret);
+    return ret;
 }
 EXPORT_SYMBOL_GPL(hrtimer_blink_nodt_set_period);
 
 int hrtimer_blink_nodt_get_period(unsigned int *ms)
 {
-    u64 ns;
-    if (!g_ctx || !ms) return -EINVAL;
-    /* half_period a ms = (ns*2)/1e6 */
-    ns = ktime_to_ns(g_ctx->half_period) * 2ULL;
-    *ms = (unsigned int)(ns / 1000000ULL);
-    return 0;
+    int ret = -EINVAL;
+
+    mutex_lock(&g_ctx_lock);
+    if (g_ctx && ms) {
+        *ms = READ_ONCE(g_ctx->cfg.period_ms);
+        ret = 0;
+    }
+    mutex_unlock(&g_ctx_lock);
+    return ret;
 }
 EXPORT_SYMBOL_GPL(hrtimer_blink_nodt_get_period);
 
+int hrtimer_blink_nodt_set_mode(unsigned int mode)
+{
+    int ret;
+
+    mutex_lock(&g_ctx_lock);
+    ret = g_ctx ? blink_set_mode(g_ctx, mode) : -ENODEV;
+    mutex_unlock(&g_ctx_lock);
+    blink_journal_log(BLINK_JOP_API_SET_MODE, BLINK_ID_HRTIMER, mode, ret);
+    return ret;
+}
+EXPORT_SYMBOL_GPL(hrtimer_blink_nodt_set_mode);
+
+int hrtimer_blink_nodt_get_mode(unsigned int *mode)
+{
+    int ret = -EINVAL;
+
+    mutex_lock(&g_ctx_lock);
+    if (g_ctx && mode) {
+        *mode = READ_ONCE(g_ctx->mode);
+        ret = 0;
+    }
+    mutex_unlock(&g_ctx_lock);
+    return ret;
+}
+EXPORT_SYMBOL_GPL(hrtimer_blink_nodt_get_mode);
+
+/* Avisos de periodo, modo y overrun, en contexto de proceso (blink_genl) */
+int hrtimer_blink_nodt_register_notifier(struct notifier_block *nb)
+{
+    return blocking_notifier_chain_register(&hrtimer_blink_chain, nb);
+}
+EXPORT_SYMBOL_GPL(hrtimer_blink_nodt_register_notifier);
+
+int hrtimer_blink_nodt_unregister_notifier(struct notifier_block *nb)
+{
+    return blocking_notifier_chain_unregister(&hrtimer_blink_chain, nb);
+}
+EXPORT_SYMBOL_GPL(hrtimer_blink_nodt_unregister_notifier);
+
 static int __init hrtimer_blink_init(void)
 {
+	ktime_t t0 = ktime_get();
 	int ret;
 	size_t n = 2;
 
 	ret = platform_driver_register(&drv);
 	if (ret) return ret;
 
-	lt = kzalloc(sizeof(*lt) + n * sizeof(struct gpiod_lookup), GFP_KERNEL);
+	acct_ctx = memacct_register(KBUILD_MODNAME, "ctx");
+	acct_lookup = memacct_register(KBUILD_MODNAME, "lookup");
+
+	lt_size = struct_size(lt, table, n);
+	lt = memacct_kzalloc(acct_lookup, lt_size, GFP_KERNEL);
 	if (!lt) { ret = -ENOMEM; goto err_drv; }
 	lt->dev_id = "hrtimer-blink-nodt.0";
 	lt->table[0] = GPIO_LOOKUP_IDX(
@@ -223,15 +1431,18 @@ static int __init hrtimer_blink_init(void)
 	if (IS_ERR(pdev)) {
 		ret = PTR_ERR(pdev);
 		gpiod_remove_lookup_table(lt);
-		kfree(lt);
+		memacct_kfree(acct_lookup, lt, lt_size);
 		goto err_drv;
 	}
 	pr_info("hrtimer_blink_nodt: chip=%s gpio=%d %s start=%u ms\n",
 		chip, gpio, active_low ? "ACTIVE_LOW" : "ACTIVE_HIGH", start_ms);
+	blink_boot_init_done(&boot, t0);
 	return 0;
 
 err_drv:
 	platform_driver_unregister(&drv);
+	memacct_unregister(acct_lookup);
+	memacct_unregister(acct_ctx);
 	return ret;
 }
 
@@ -241,14 +1452,20 @@ static void __exit hrtimer_blink_exit(void)
 		platform_device_unregister(pdev);
 	if (lt) {
 		gpiod_remove_lookup_table(lt);
-		kfree(lt);
+		memacct_kfree(acct_lookup, lt, lt_size);
 	}
 	platform_driver_unregister(&drv);
+	memacct_unregister(acct_lookup);
+	memacct_unregister(acct_ctx);
 }
 
 module_init(hrtimer_blink_init);
 module_exit(hrtimer_blink_exit);
 
+#ifdef MY_KUNIT
+#include "hrtimer_blink_kunit.c"
+#endif
+
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("Tú");
 MODULE_DESCRIPTION("Blink LED con hrtimer + char (autónomo sin DT)");
@@ -0,0 +1,397 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * KUnit: conversiones de periodo del motor hrtimer.
+ * Se incluye al final de hrtimer_blink_char_nodt.c con "make KUNIT=1".
+ */
+#include "kbench.h"
+
+static void hrtimer_blink_test_square(struct kunit *test)
+{
+	struct hrtimer_blink *ctx;
+	int on = 0;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	blink_cfg_default(&ctx->cfg, 100);
+
+	/* 50 %: medio periodo en cada nivel, alternando */
+	KUNIT_EXPECT_EQ(test, blink_cfg_next(ctx, &on), 50 * NSEC_PER_MSEC);
+	KUNIT_EXPECT_EQ(test, on, 1);
+	KUNIT_EXPECT_EQ(test, blink_cfg_next(ctx, &on), 50 * NSEC_PER_MSEC);
+	KUNIT_EXPECT_EQ(test, on, 0);
+
+	/* Periodo impar: 1 ms -> 500 us por nivel, sin truncar a ms */
+	blink_cfg_default(&ctx->cfg, 1);
+	KUNIT_EXPECT_EQ(test, blink_cfg_next(ctx, &on), 500 * NSEC_PER_USEC);
+}
+
+static void hrtimer_blink_test_duty(struct kunit *test)
+{
+	struct hrtimer_blink *ctx;
+	int on = 0;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	blink_cfg_default(&ctx->cfg, 200);
+
+	ctx->cfg.duty_pct = 25;
+	KUNIT_EXPECT_EQ(test, blink_cfg_next(ctx, &on), 50 * NSEC_PER_MSEC);
+	KUNIT_EXPECT_EQ(test, on, 1);
+	KUNIT_EXPECT_EQ(test, blink_cfg_next(ctx, &on), 150 * NSEC_PER_MSEC);
+	KUNIT_EXPECT_EQ(test, on, 0);
+
+	/* Extremos: nivel fijo y se revisa una vez por periodo */
+	ctx->cfg.duty_pct = 0;
+	KUNIT_EXPECT_EQ(test, blink_cfg_next(ctx, &on), 200 * NSEC_PER_MSEC);
+	KUNIT_EXPECT_EQ(test, on, 0);
+	ctx->cfg.duty_pct = 100;
+	KUNIT_EXPECT_EQ(test, blink_cfg_next(ctx, &on), 200 * NSEC_PER_MSEC);
+	KUNIT_EXPECT_EQ(test, on, 1);
+}
+
+static void hrtimer_blink_test_pattern(struct kunit *test)
+{
+	struct hrtimer_blink *ctx;
+	int on = 0;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	blink_cfg_default(&ctx->cfg, 100);
+	ctx->cfg.pat[0] = BLINK_PAT_ON | 10;
+	ctx->cfg.pat[1] = 30;
+	ctx->cfg.npat = 2;
+
+	KUNIT_EXPECT_EQ(test, blink_cfg_next(ctx, &on), 10 * NSEC_PER_MSEC);
+	KUNIT_EXPECT_EQ(test, on, 1);
+	KUNIT_EXPECT_EQ(test, blink_cfg_next(ctx, &on), 30 * NSEC_PER_MSEC);
+	KUNIT_EXPECT_EQ(test, on, 0);
+	/* Vuelve al primer paso */
+	KUNIT_EXPECT_EQ(test, blink_cfg_next(ctx, &on), 10 * NSEC_PER_MSEC);
+}
+
+static void hrtimer_blink_test_cmd_apply(struct kunit *test)
+{
+	struct blink_cfg cfg;
+	struct blink_cmd c = { .magic = BLINK_CMD_MAGIC };
+	unsigned int i;
+
+	blink_cfg_default(&cfg, 100);
+
+	c.op = BLINK_CMD_PERIOD; c.arg = 0;
+	KUNIT_EXPECT_EQ(test, blink_cmd_apply(&cfg, &c), -EINVAL);
+	c.arg = 40;
+	KUNIT_EXPECT_EQ(test, blink_cmd_apply(&cfg, &c), 0);
+	KUNIT_EXPECT_EQ(test, cfg.period_ms, 40U);
+
+	c.op = BLINK_CMD_DUTY; c.arg = 101;
+	KUNIT_EXPECT_EQ(test, blink_cmd_apply(&cfg, &c), -ERANGE);
+
+	c.op = BLINK_CMD_PATTERN_STEP; c.arg = BLINK_PAT_ON | 5;
+	for (i = 0; i < BLINK_PATTERN_MAX; i++)
+		KUNIT_EXPECT_EQ(test, blink_cmd_apply(&cfg, &c), 0);
+	KUNIT_EXPECT_EQ(test, blink_cmd_apply(&cfg, &c), -ENOSPC);
+
+	c.op = 0xff;
+	KUNIT_EXPECT_EQ(test, blink_cmd_apply(&cfg, &c), -EOPNOTSUPP);
+	c.magic = 0;
+	KUNIT_EXPECT_EQ(test, blink_cmd_apply(&cfg, &c), -EINVAL);
+}
+
+static void hrtimer_blink_test_get_period(struct kunit *test)
+{
+	struct hrtimer_blink *ctx;
+	unsigned int ms = 0;
+
+	KUNIT_EXPECT_EQ(test, hrtimer_blink_nodt_get_period(NULL), -EINVAL);
+
+	/* Con el dispositivo real presente no se toca g_ctx */
+	if (g_ctx)
+		kunit_skip(test, "dispositivo real activo");
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	blink_cfg_default(&ctx->cfg, 333);
+
+	g_ctx = ctx;
+	KUNIT_EXPECT_EQ(test, hrtimer_blink_nodt_get_period(&ms), 0);
+	g_ctx = NULL;
+	KUNIT_EXPECT_EQ(test, ms, 333U);
+}
+
+static void hrtimer_blink_test_lat(struct kunit *test)
+{
+	struct blink_lat *l;
+
+	l = kunit_kzalloc(test, sizeof(*l), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, l);
+
+	blink_lat_add(l, 1500);
+	blink_lat_add(l, 1900);
+	blink_lat_add(l, -20);			/* antes de tiempo cuenta como 0 */
+	blink_lat_add(l, (s64)BLINK_LAT_BUCKETS * NSEC_PER_USEC);
+
+	KUNIT_EXPECT_EQ(test, l->count, 4ULL);
+	KUNIT_EXPECT_EQ(test, l->hist[1], 2U);
+	KUNIT_EXPECT_EQ(test, l->hist[0], 1U);
+	KUNIT_EXPECT_EQ(test, l->overflow, 1ULL);
+	KUNIT_EXPECT_EQ(test, l->min_ns, 0ULL);
+	KUNIT_EXPECT_EQ(test, l->max_ns, (u64)BLINK_LAT_BUCKETS * NSEC_PER_USEC);
+}
+
+static void hrtimer_blink_test_expiry(struct kunit *test)
+{
+	struct hrtimer_blink *ctx;
+	bool defer = defer_work;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+
+	KUNIT_EXPECT_EQ(test, blink_expiry_check(ctx, BLINK_EXP_HARD), 0);
+
+	/* GPIO que duerme: hard solo con defer_work */
+	ctx->can_sleep = true;
+	defer_work = false;
+	KUNIT_EXPECT_EQ(test, blink_expiry_check(ctx, BLINK_EXP_HARD), -EINVAL);
+	KUNIT_EXPECT_EQ(test, blink_expiry_check(ctx, BLINK_EXP_SOFT), 0);
+	KUNIT_EXPECT_EQ(test, blink_expiry_check(ctx, BLINK_EXP_DEFAULT), 0);
+	defer_work = true;
+	KUNIT_EXPECT_EQ(test, blink_expiry_check(ctx, BLINK_EXP_HARD), 0);
+	defer_work = defer;
+}
+
+/*
+ * Callback con expiración en 0 que corre en 175 ms sobre 100 ms al 50 %:
+ * el flanco de 50 ms, 100 ms y 150 ms ya vencieron; a los 175 ms el
+ * LED debería estar apagado y el próximo flanco es el de 200 ms.
+ */
+static struct hrtimer_blink *hrtimer_blink_late(struct kunit *test,
+						unsigned int policy,
+						ktime_t *next, int *on)
+{
+	struct hrtimer_blink *ctx;
+	u64 ns;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	blink_cfg_default(&ctx->cfg, 100);
+	ctx->catchup = policy;
+
+	*on = 0;
+	ns = blink_cfg_next(ctx, on);
+	*next = blink_catchup(ctx, ns, ns, 175 * NSEC_PER_MSEC, on);
+	return ctx;
+}
+
+static void hrtimer_blink_test_catchup_skip(struct kunit *test)
+{
+	struct hrtimer_blink *ctx;
+	ktime_t next;
+	int on;
+
+	ctx = hrtimer_blink_late(test, BLINK_CU_SKIP, &next, &on);
+	KUNIT_EXPECT_EQ(test, next, 200 * NSEC_PER_MSEC);
+	KUNIT_EXPECT_EQ(test, on, 0);
+	KUNIT_EXPECT_EQ(test, ctx->ovr.late, 1ULL);
+	KUNIT_EXPECT_EQ(test, ctx->ovr.skipped, 3ULL);
+}
+
+static void hrtimer_blink_test_catchup_replay(struct kunit *test)
+{
+	struct hrtimer_blink *ctx;
+	ktime_t next;
+	int on;
+
+	/* El flanco de 50 ms sale ya, con el nivel que le tocaba */
+	ctx = hrtimer_blink_late(test, BLINK_CU_REPLAY, &next, &on);
+	KUNIT_EXPECT_EQ(test, next, 50 * NSEC_PER_MSEC);
+	KUNIT_EXPECT_EQ(test, on, 1);
+	KUNIT_EXPECT_EQ(test, ctx->ovr.replayed, 1ULL);
+
+	/* Sin fin de atraso: al llegar al tope se resincroniza */
+	ctx->replay_run = BLINK_CATCHUP_MAX;
+	next = blink_catchup(ctx, 100 * NSEC_PER_MSEC, 50 * NSEC_PER_MSEC,
+			     175 * NSEC_PER_MSEC, &on);
+	KUNIT_EXPECT_EQ(test, next, 225 * NSEC_PER_MSEC);
+	KUNIT_EXPECT_EQ(test, ctx->ovr.resync, 1ULL);
+	KUNIT_EXPECT_EQ(test, ctx->replay_run, 0U);
+}
+
+static void hrtimer_blink_test_catchup_hold(struct kunit *test)
+{
+	struct hrtimer_blink *ctx;
+	ktime_t next;
+	int on;
+
+	/* Primer múltiplo de 50 ms tras ahora, con el nivel de este flanco */
+	ctx = hrtimer_blink_late(test, BLINK_CU_HOLD, &next, &on);
+	KUNIT_EXPECT_EQ(test, next, 200 * NSEC_PER_MSEC);
+	KUNIT_EXPECT_EQ(test, on, 1);
+	KUNIT_EXPECT_EQ(test, ctx->ovr.skipped, 3ULL);
+}
+
+static void hrtimer_blink_test_catchup_on_time(struct kunit *test)
+{
+	struct hrtimer_blink *ctx;
+	int on = 1;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	blink_cfg_default(&ctx->cfg, 100);
+	ctx->replay_run = 3;
+
+	KUNIT_EXPECT_EQ(test, blink_catchup(ctx, 50 * NSEC_PER_MSEC,
+					    50 * NSEC_PER_MSEC, 10 * NSEC_PER_MSEC, &on),
+			50 * NSEC_PER_MSEC);
+	KUNIT_EXPECT_EQ(test, on, 1);
+	KUNIT_EXPECT_EQ(test, ctx->ovr.late, 0ULL);
+	KUNIT_EXPECT_EQ(test, ctx->replay_run, 0U);
+}
+
+static struct blink_event hrtimer_blink_seen;
+
+static int hrtimer_blink_test_nb_call(struct notifier_block *nb,
+				      unsigned long ev, void *data)
+{
+	if (ev == BLINK_EV_OVERRUN)
+		hrtimer_blink_seen = *(struct blink_event *)data;
+	return NOTIFY_OK;
+}
+
+/* El aviso agrupado lleva los acumulados de overrun del motor */
+static void hrtimer_blink_test_ovr_notify(struct kunit *test)
+{
+	struct notifier_block nb = { .notifier_call = hrtimer_blink_test_nb_call };
+	struct hrtimer_blink *ctx;
+	ktime_t next;
+	int on;
+
+	ctx = hrtimer_blink_late(test, BLINK_CU_SKIP, &next, &on);
+	raw_spin_lock_init(&ctx->cfg_lock);
+	INIT_DELAYED_WORK(&ctx->ovr_work, blink_ovr_work);
+
+	memset(&hrtimer_blink_seen, 0, sizeof(hrtimer_blink_seen));
+	KUNIT_ASSERT_EQ(test, hrtimer_blink_nodt_register_notifier(&nb), 0);
+	blink_ovr_work(&ctx->ovr_work.work);
+	hrtimer_blink_nodt_unregister_notifier(&nb);
+
+	KUNIT_EXPECT_EQ(test, hrtimer_blink_seen.id, (u32)BLINK_ID_HRTIMER);
+	KUNIT_EXPECT_EQ(test, hrtimer_blink_seen.late, 1ULL);
+	KUNIT_EXPECT_EQ(test, hrtimer_blink_seen.skipped, 3ULL);
+	KUNIT_EXPECT_EQ(test, hrtimer_blink_seen.replayed, 0ULL);
+}
+
+/* Nunca fuera de housekeeping; pin fijo y spread rotando por instancia */
+static void hrtimer_blink_test_placement(struct kunit *test)
+{
+	const struct cpumask *hk = housekeeping_cpumask(HK_TYPE_TIMER);
+	struct blink_cpu *bc;
+	unsigned int i, n;
+	int first, cpu;
+
+	bc = kunit_kzalloc(test, sizeof(*bc), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, bc);
+
+	cpus_read_lock();
+	first = cpumask_first_and(hk, cpu_online_mask);
+	n = 0;
+	for_each_cpu_and(cpu, hk, cpu_online_mask)
+		n++;
+
+	blink_cpu_init(bc, 5, HK_TYPE_TIMER);
+	bc->policy = BLINK_CPU_PIN;
+	KUNIT_EXPECT_EQ(test, blink_cpu_pick(bc), first);
+
+	bc->policy = BLINK_CPU_SPREAD;
+	for (i = 0; i < 2 * n; i++) {
+		bc->index = i;
+		cpu = blink_cpu_pick(bc);
+		KUNIT_EXPECT_TRUE(test, cpumask_test_cpu(cpu, hk));
+		KUNIT_EXPECT_TRUE(test, cpu_online(cpu));
+		if (i == n)
+			KUNIT_EXPECT_EQ(test, cpu, first);	/* vuelta completa */
+	}
+
+	/* Lista de una sola CPU: spread no tiene a dónde repartir */
+	cpumask_set_cpu(first, &bc->want);
+	bc->index = 3;
+	KUNIT_EXPECT_EQ(test, blink_cpu_pick(bc), first);
+	KUNIT_EXPECT_EQ(test, READ_ONCE(bc->cpu), first);
+	cpus_read_unlock();
+}
+
+static void hrtimer_blink_test_cost(struct kunit *test)
+{
+	struct blink_cost c = {};
+	struct blink_cost_cpu sum = {};
+	int cpu, k;
+
+	/* Sin per-CPU asignado no se cuenta nada (ctx de los otros casos) */
+	blink_cost_end(&c, BLINK_COST_CB, blink_cost_start());
+
+	c.pc = alloc_percpu(struct blink_cost_cpu);
+	KUNIT_ASSERT_NOT_NULL(test, c.pc);
+
+	blink_cost_end(&c, BLINK_COST_CB, blink_cost_start() - 2000);
+	blink_cost_end(&c, BLINK_COST_CB, blink_cost_start() - 500);
+	blink_cost_end(&c, BLINK_COST_GPIO_SLEEP, blink_cost_start() + 1000000);
+
+	for_each_possible_cpu(cpu)
+		for (k = 0; k < BLINK_COST__MAX; k++) {
+			const struct blink_cost_cpu *p = per_cpu_ptr(c.pc, cpu);
+
+			sum.n[k] += p->n[k];
+			sum.ns[k] += p->ns[k];
+			sum.max[k] = max(sum.max[k], p->max[k]);
+		}
+	free_percpu(c.pc);
+
+	KUNIT_EXPECT_EQ(test, sum.n[BLINK_COST_CB], 2ULL);
+	KUNIT_EXPECT_GE(test, sum.ns[BLINK_COST_CB], 2500ULL);
+	KUNIT_EXPECT_GE(test, sum.max[BLINK_COST_CB], 2000ULL);
+	/* Reloj hacia atrás: cuenta el evento con 0 ns */
+	KUNIT_EXPECT_EQ(test, sum.n[BLINK_COST_GPIO_SLEEP], 1ULL);
+	KUNIT_EXPECT_EQ(test, sum.ns[BLINK_COST_GPIO_SLEEP], 0ULL);
+	KUNIT_EXPECT_EQ(test, sum.n[BLINK_COST_WORK], 0ULL);
+}
+
+static void hrtimer_blink_bench_next(struct kunit *test)
+{
+	struct hrtimer_blink *ctx;
+	int on = 0;
+	u64 ns;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	blink_cfg_default(&ctx->cfg, 100);
+	ctx->cfg.duty_pct = 30;
+
+	KBENCH(test, "blink_cfg_next(duty)", 100000, 20, {
+		ns = blink_cfg_next(ctx, &on);
+		OPTIMIZER_HIDE_VAR(ns);
+	});
+}
+
+static struct kunit_case hrtimer_blink_test_cases[] = {
+	KUNIT_CASE(hrtimer_blink_test_square),
+	KUNIT_CASE(hrtimer_blink_test_duty),
+	KUNIT_CASE(hrtimer_blink_test_pattern),
+	KUNIT_CASE(hrtimer_blink_test_cmd_apply),
+	KUNIT_CASE(hrtimer_blink_test_get_period),
+	KUNIT_CASE(hrtimer_blink_test_lat),
+	KUNIT_CASE(hrtimer_blink_test_expiry),
+	KUNIT_CASE(hrtimer_blink_test_catchup_skip),
+	KUNIT_CASE(hrtimer_blink_test_catchup_replay),
+	KUNIT_CASE(hrtimer_blink_test_catchup_hold),
+	KUNIT_CASE(hrtimer_blink_test_catchup_on_time),
+	KUNIT_CASE(hrtimer_blink_test_ovr_notify),
+	KUNIT_CASE(hrtimer_blink_test_placement),
+	KUNIT_CASE(hrtimer_blink_test_cost),
+	KUNIT_CASE(hrtimer_blink_bench_next),
+	{}
+};
+
+static struct kunit_suite hrtimer_blink_test_suite = {
+	.name = "hrtimer_blink",
+	.test_cases = hrtimer_blink_test_cases,
+};
+kunit_test_suite(hrtimer_blink_test_suite);
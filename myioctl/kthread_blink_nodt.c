@@ -4,19 +4,39 @@
 #include <linux/gpio/consumer.h>
 #include <linux/gpio/machine.h>   // gpiod_lookup_table, GPIO_LOOKUP_IDX
 #include <linux/slab.h>
+#include <linux/ktime.h>
 #include <linux/kthread.h>
 #include <linux/delay.h>
 #include <linux/of.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
 
 #include "blink_api.h"
+#include "blink_probe.h"
+#include "blink_gpio.h"
+#include "blink_cpu.h"
+#include "blink_cost.h"
+#include "blink_mode.h"
+#include "memacct.h"
 
 
 struct kthread_blink {
+	struct device *dev;
 	struct gpio_desc *led;
 	struct task_struct *task;
 	unsigned int period_ms;
+	bool on;
+	struct mutex lock;		/* led/on frente a cambios por sysfs */
+	struct mutex mode_lock;		/* mode; fuera de BLINK el hilo está aparcado */
+	unsigned int mode;
+	u64 wakeups;			/* despertares del hilo */
+	struct blink_cpu place;		/* afinidad del hilo, bajo mode_lock */
+	struct blink_cost cost;		/* debugfs kthread_blink/cost */
+	struct dentry *dbg;
 };
 
+static void kthread_blink_apply_period(struct kthread_blink *ctx, unsigned int ms);
+
 static char *chip = (char *)"pinctrl-bcm2711";
 module_param(chip, charp, 0444);
 MODULE_PARM_DESC(chip, "Etiqueta del gpiochip (RPi4: 'pinctrl-bcm2711').");
@@ -29,58 +49,394 @@ static bool active_low = false;
 module_param(active_low, bool, 0444);
 MODULE_PARM_DESC(active_low, "1 si el LED es activo en bajo.");
 
+static struct kthread_blink *g_kb_ctx;  /* NUEVO */
+static DEFINE_MUTEX(g_kb_lock);         /* g_kb_ctx frente a remove */
+static BLOCKING_NOTIFIER_HEAD(kthread_blink_chain);
+
+/* Escribir el parámetro cambia también el periodo del dispositivo en marcha */
 static unsigned int period_ms = 500;
-module_param(period_ms, uint, 0644);
+static int period_ms_set(const char *val, const struct kernel_param *kp)
+{
+	int ret = param_set_uint(val, kp);
+
+	mutex_lock(&g_kb_lock);
+	if (!ret && g_kb_ctx)
+		kthread_blink_apply_period(g_kb_ctx, period_ms);
+	mutex_unlock(&g_kb_lock);
+	return ret;
+}
+
+static const struct kernel_param_ops period_ms_ops = {
+	.set = period_ms_set,
+	.get = param_get_uint,
+};
+module_param_cb(period_ms, &period_ms_ops, &period_ms, 0644);
 MODULE_PARM_DESC(period_ms, "Periodo de parpadeo en ms.");
 
 static struct platform_device *pdev;
 static struct platform_driver drv;
 static struct gpiod_lookup_table *lt;
+static size_t lt_size;
+static struct memacct *acct_ctx, *acct_lookup;
 
+static struct blink_boot boot;
+BLINK_BOOT_PARAMS(boot);
 
-static struct kthread_blink *g_kb_ctx;  /* NUEVO */
+
+/* El hilo recalcula su plazo desde el último flanco al despertar */
+static void kthread_blink_apply_period(struct kthread_blink *ctx, unsigned int ms)
+{
+	WRITE_ONCE(ctx->period_ms, ms ?: 1);
+	wake_up_process(ctx->task);
+	blink_notify(&kthread_blink_chain, BLINK_ID_KTHREAD, BLINK_EV_PERIOD, ms ?: 1);
+}
 
 
 /* === API exportada === */
 int kthread_blink_nodt_set_period(unsigned int ms)
 {
-    if (!g_kb_ctx) return -ENODEV;
-    if (ms < 1) ms = 1;
-    g_kb_ctx->period_ms = ms;
-    return 0;
+    int ret = 0;
+
+    mutex_lock(&g_kb_lock);
+    if (g_kb_ctx)
+        kthread_blink_apply_period(g_kb_ctx, ms);
+    else
+        ret = -ENODEV;
+    mutex_unlock(&g_kb_lock);
+    blink_journal_log(BLINK_JOP_API_SET_MS, BLINK_ID_KTHREAD, ms, ret);
+    return ret;
 }
 EXPORT_SYMBOL_GPL(kthread_blink_nodt_set_period);
 
 int kthread_blink_nodt_get_period(unsigned int *ms)
 {
-    if (!g_kb_ctx || !ms) return -EINVAL;
-    *ms = g_kb_ctx->period_ms;
-    return 0;
+    int ret = -EINVAL;
+
+    mutex_lock(&g_kb_lock);
+    if (g_kb_ctx && ms) {
+        *ms = READ_ONCE(g_kb_ctx->period_ms);
+        ret = 0;
+    }
+    mutex_unlock(&g_kb_lock);
+    return ret;
 }
 EXPORT_SYMBOL_GPL(kthread_blink_nodt_get_period);
+
+/*
+ * Fuera de BLINK el hilo queda en kthread_parkme(): ni timeout ni
+ * despertares. El LED se fija antes de soltar la referencia de PM.
+ */
+static int kthread_blink_set_mode_ctx(struct kthread_blink *ctx, unsigned int mode)
+{
+	unsigned int old;
+	int ret = 0;
+
+	if (mode >= BLINK_MODE__MAX)
+		return -EINVAL;
+
+	mutex_lock(&ctx->mode_lock);
+	old = ctx->mode;
+	if (mode == BLINK_MODE_BLINK) {
+		if (old != BLINK_MODE_BLINK) {
+			ret = blink_pm_busy(ctx->dev);
+			if (!ret) {
+				ctx->mode = mode;
+				kthread_unpark(ctx->task);
+			}
+		}
+		goto out;
+	}
+
+	if (old == BLINK_MODE_BLINK)
+		kthread_park(ctx->task);
+	mutex_lock(&ctx->lock);
+	ctx->on = blink_mode_level(mode, ctx->on);
+	gpiod_set_value_cansleep(ctx->led, ctx->on);
+	mutex_unlock(&ctx->lock);
+	ctx->mode = mode;
+	if (old == BLINK_MODE_BLINK)
+		blink_pm_idle(ctx->dev);
+out:
+	mutex_unlock(&ctx->mode_lock);
+	if (!ret && mode != old)
+		blink_notify(&kthread_blink_chain, BLINK_ID_KTHREAD, BLINK_EV_MODE, mode);
+	return ret;
+}
+
+int kthread_blink_nodt_set_mode(unsigned int mode)
+{
+    int ret;
+
+    mutex_lock(&g_kb_lock);
+    ret = g_kb_ctx ? kthread_blink_set_mode_ctx(g_kb_ctx, mode) : -ENODEV;
+    mutex_unlock(&g_kb_lock);
+    blink_journal_log(BLINK_JOP_API_SET_MODE, BLINK_ID_KTHREAD, mode, ret);
+    return ret;
+}
+EXPORT_SYMBOL_GPL(kthread_blink_nodt_set_mode);
+
+int kthread_blink_nodt_get_mode(unsigned int *mode)
+{
+    int ret = -EINVAL;
+
+    mutex_lock(&g_kb_lock);
+    if (g_kb_ctx && mode) {
+        *mode = READ_ONCE(g_kb_ctx->mode);
+        ret = 0;
+    }
+    mutex_unlock(&g_kb_lock);
+    return ret;
+}
+EXPORT_SYMBOL_GPL(kthread_blink_nodt_get_mode);
+
+/* Avisos de periodo y modo, en contexto de proceso (blink_genl) */
+int kthread_blink_nodt_register_notifier(struct notifier_block *nb)
+{
+    return blocking_notifier_chain_register(&kthread_blink_chain, nb);
+}
+EXPORT_SYMBOL_GPL(kthread_blink_nodt_register_notifier);
+
+int kthread_blink_nodt_unregister_notifier(struct notifier_block *nb)
+{
+    return blocking_notifier_chain_unregister(&kthread_blink_chain, nb);
+}
+EXPORT_SYMBOL_GPL(kthread_blink_nodt_unregister_notifier);
+
 static int blink_thread(void *arg)
 {
 	struct kthread_blink *ctx = arg;
-	bool on = false;
+	unsigned long last, next;
+	u64 t0;
 
 	while (!kthread_should_stop()) {
-		on = !on;
-		gpiod_set_value_cansleep(ctx->led, on);
-		if (msleep_interruptible(ctx->period_ms / 2))
-			break;
+		if (kthread_should_park()) {
+			kthread_parkme();
+			continue;
+		}
+
+		/* Una vuelta = un flanco; el sueño no cuenta */
+		t0 = blink_cost_start();
+		mutex_lock(&ctx->lock);
+		ctx->on = !ctx->on;
+		blink_cost_gpio_cansleep(&ctx->cost, ctx->led, ctx->on);
+		mutex_unlock(&ctx->lock);
+		blink_cost_end(&ctx->cost, BLINK_COST_CB, t0);
+		last = jiffies;
+
+		/*
+		 * Un cambio de periodo, kthread_park() o kthread_stop() despiertan
+		 * al hilo; el estado se pone antes de mirar para no perder el
+		 * wake_up.
+		 */
+		for (;;) {
+			next = last + msecs_to_jiffies(READ_ONCE(ctx->period_ms) / 2);
+			set_current_state(TASK_INTERRUPTIBLE);
+			if (kthread_should_stop() || kthread_should_park() ||
+			    !time_before(jiffies, next))
+				break;
+			schedule_timeout(next - jiffies);
+			WRITE_ONCE(ctx->wakeups, ctx->wakeups + 1);
+		}
+		__set_current_state(TASK_RUNNING);
 	}
+	mutex_lock(&ctx->lock);
 	gpiod_set_value_cansleep(ctx->led, 0);
+	mutex_unlock(&ctx->lock);
 	return 0;
 }
 
-static int kthread_blink_probe(struct platform_device *pdev)
+/*
+ * Atributos del dispositivo (/sys/devices/platform/kthread-blink-nodt.0):
+ * periodo, línea y polaridad se aplican sobre la marcha.
+ */
+static ssize_t period_ms_show(struct device *dev, struct device_attribute *attr,
+			      char *buf)
 {
-	struct kthread_blink *ctx;
+	struct kthread_blink *ctx = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%u\n", READ_ONCE(ctx->period_ms));
+}
+
+static ssize_t period_ms_store(struct device *dev, struct device_attribute *attr,
+			       const char *buf, size_t len)
+{
+	struct kthread_blink *ctx = dev_get_drvdata(dev);
+	unsigned int ms;
+	int ret = kstrtouint(buf, 0, &ms);
+
+	if (ret)
+		return ret;
+	kthread_blink_apply_period(ctx, ms);
+	return len;
+}
+static DEVICE_ATTR_RW(period_ms);
+
+/*
+ * Con ctx->lock el hilo no toca el LED: se cambia y se repone el nivel.
+ * Lo vigente queda en lt; gpio/active_low (0444) son los valores de carga.
+ */
+static int kthread_blink_set_led(struct device *dev, unsigned int line,
+				 bool low)
+{
+	struct kthread_blink *ctx = dev_get_drvdata(dev);
+	struct gpio_desc *d;
+	int ret = 0;
+
+	mutex_lock(&ctx->lock);
+	if (line == blink_gpio_line(lt)) {
+		blink_gpio_polarity(lt, ctx->led, low);
+	} else {
+		d = blink_gpio_get(dev, lt, line, low);
+		if (IS_ERR(d)) {
+			ret = PTR_ERR(d);
+			goto out;
+		}
+		blink_gpio_put(dev, ctx->led);
+		ctx->led = d;
+	}
+	gpiod_set_value_cansleep(ctx->led, ctx->on);
+out:
+	mutex_unlock(&ctx->lock);
+	return ret;
+}
+
+static ssize_t gpio_show(struct device *dev, struct device_attribute *attr,
+			 char *buf)
+{
+	return sysfs_emit(buf, "%u\n", blink_gpio_line(lt));
+}
+
+static ssize_t gpio_store(struct device *dev, struct device_attribute *attr,
+			  const char *buf, size_t len)
+{
+	unsigned int line;
+	int ret = kstrtouint(buf, 0, &line);
+
+	if (!ret)
+		ret = kthread_blink_set_led(dev, line, blink_gpio_active_low(lt));
+	return ret ? ret : len;
+}
+static DEVICE_ATTR_RW(gpio);
+
+static ssize_t active_low_show(struct device *dev, struct device_attribute *attr,
+			       char *buf)
+{
+	return sysfs_emit(buf, "%d\n", blink_gpio_active_low(lt));
+}
+
+static ssize_t active_low_store(struct device *dev, struct device_attribute *attr,
+				const char *buf, size_t len)
+{
+	bool low;
+	int ret = kstrtobool(buf, &low);
+
+	if (!ret)
+		ret = kthread_blink_set_led(dev, blink_gpio_line(lt), low);
+	return ret ? ret : len;
+}
+static DEVICE_ATTR_RW(active_low);
+
+static ssize_t mode_show(struct device *dev, struct device_attribute *attr,
+			 char *buf)
+{
+	struct kthread_blink *ctx = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%s\n", blink_mode_names[READ_ONCE(ctx->mode)]);
+}
+
+static ssize_t mode_store(struct device *dev, struct device_attribute *attr,
+			  const char *buf, size_t len)
+{
+	int mode = sysfs_match_string(blink_mode_names, buf);
+
+	if (mode < 0)
+		return mode;
+	mode = kthread_blink_set_mode_ctx(dev_get_drvdata(dev), mode);
+	return mode ? mode : len;
+}
+static DEVICE_ATTR_RW(mode);
+
+/* En un modo fijo no debe moverse: el hilo está aparcado */
+static ssize_t wakeups_show(struct device *dev, struct device_attribute *attr,
+			    char *buf)
+{
+	struct kthread_blink *ctx = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%llu\n", READ_ONCE(ctx->wakeups));
+}
+static DEVICE_ATTR_RO(wakeups);
+
+/*
+ * Afinidad a una sola CPU: el hilo y su hrtimer de sueño no pisan las
+ * aisladas. Vale también con el hilo aparcado; migra al despertar.
+ */
+static int kthread_blink_place(struct kthread_blink *ctx)
+{
+	int ret;
+
+	cpus_read_lock();
+	ret = set_cpus_allowed_ptr(ctx->task, cpumask_of(blink_cpu_pick(&ctx->place)));
+	cpus_read_unlock();
+	return ret;
+}
+
+static ssize_t placement_show(struct device *dev, struct device_attribute *attr,
+			      char *buf)
+{
+	struct kthread_blink *ctx = dev_get_drvdata(dev);
 
+	return blink_cpu_show(&ctx->place, buf);
+}
+
+static ssize_t placement_store(struct device *dev, struct device_attribute *attr,
+			       const char *buf, size_t len)
+{
+	struct kthread_blink *ctx = dev_get_drvdata(dev);
+	unsigned int policy;
+	cpumask_var_t m;
+	int ret;
 
+	if (!alloc_cpumask_var(&m, GFP_KERNEL))
+		return -ENOMEM;
+	ret = blink_cpu_parse(&ctx->place, buf, &policy, m);
+	if (ret)
+		goto out;
+
+	mutex_lock(&ctx->mode_lock);
+	ctx->place.policy = policy;
+	cpumask_copy(&ctx->place.want, m);
+	ret = kthread_blink_place(ctx);
+	mutex_unlock(&ctx->mode_lock);
+out:
+	free_cpumask_var(m);
+	return ret ? ret : len;
+}
+static DEVICE_ATTR_RW(placement);
+
+static struct attribute *kthread_blink_attrs[] = {
+	&dev_attr_period_ms.attr,
+	&dev_attr_gpio.attr,
+	&dev_attr_active_low.attr,
+	&dev_attr_mode.attr,
+	&dev_attr_wakeups.attr,
+	&dev_attr_placement.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(kthread_blink);
+
+static int kthread_blink_do_probe(struct platform_device *pdev)
+{
+	struct kthread_blink *ctx;
+	int ret;
 
-	ctx = devm_kzalloc(&pdev->dev, sizeof(*ctx), GFP_KERNEL);
+	ctx = memacct_devm_kzalloc(acct_ctx, &pdev->dev, sizeof(*ctx), GFP_KERNEL);
 	if (!ctx) return -ENOMEM;
+	mutex_init(&ctx->lock);
+	mutex_init(&ctx->mode_lock);
+	ctx->dev = &pdev->dev;
+	ctx->mode = BLINK_MODE_BLINK;
+	ret = blink_cost_init(&pdev->dev, &ctx->cost);
+	if (ret) return ret;
 
 	ctx->led = devm_gpiod_get(&pdev->dev, "led", GPIOD_OUT_LOW);
 	if (IS_ERR(ctx->led))
@@ -88,12 +444,25 @@ static int kthread_blink_probe(struct platform_device *pdev)
 
 	ctx->period_ms = period_ms ?: 1;
 
-	ctx->task = kthread_run(blink_thread, ctx, "kthread_blink_nodt");
-	if (IS_ERR(ctx->task))
-		return dev_err_probe(&pdev->dev, PTR_ERR(ctx->task), "kthread_run\n");
+	ret = blink_pm_init(&pdev->dev);
+	if (ret) return ret;
+
+	ctx->task = kthread_create(blink_thread, ctx, "kthread_blink_nodt");
+	if (IS_ERR(ctx->task)) {
+		blink_pm_exit(&pdev->dev, ctx->mode);
+		return dev_err_probe(&pdev->dev, PTR_ERR(ctx->task), "kthread_create\n");
+	}
+	/* Colocado antes del primer despertar */
+	blink_cpu_init(&ctx->place, BLINK_ID_KTHREAD, HK_TYPE_KTHREAD);
+	kthread_blink_place(ctx);
+	ctx->dbg = debugfs_create_dir("kthread_blink", NULL);
+	blink_cost_debugfs(ctx->dbg, &ctx->cost);
+	wake_up_process(ctx->task);
 
 	platform_set_drvdata(pdev, ctx);
+	mutex_lock(&g_kb_lock);
 	g_kb_ctx = ctx;   /* NUEVO */
+	mutex_unlock(&g_kb_lock);
 	dev_info(&pdev->dev, "kthread blink: %u ms\n", ctx->period_ms);
 	return 0;
 }
@@ -101,23 +470,37 @@ static int kthread_blink_probe(struct platform_device *pdev)
 static int kthread_blink_remove(struct platform_device *pdev)
 {
 	struct kthread_blink *ctx = platform_get_drvdata(pdev);
+
+	/* Ningún llamador de la API puede seguir usando ctx tras esto */
+	mutex_lock(&g_kb_lock);
+	g_kb_ctx = NULL;  /* NUEVO */
+	mutex_unlock(&g_kb_lock);
+
+	debugfs_remove_recursive(ctx->dbg);
 	if (ctx && ctx->task)
 		kthread_stop(ctx->task);
-
-    g_kb_ctx = NULL;  /* NUEVO */
+	blink_pm_exit(&pdev->dev, ctx->mode);
 	return 0;
 }
 
+static int kthread_blink_probe(struct platform_device *pdev)
+{
+	return blink_probe_timed(&boot, pdev, kthread_blink_do_probe);
+}
+
 static struct platform_driver drv = {
 	.probe  = kthread_blink_probe,
 	.remove = kthread_blink_remove,
 	.driver = {
 		.name = "kthread-blink-nodt",
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
+		.dev_groups = kthread_blink_groups,
 	},
 };
 
 static int __init kthread_blink_init(void)
 {
+	ktime_t t0 = ktime_get();
 	int ret;
 	size_t n = 2;
 
@@ -125,8 +508,12 @@ static int __init kthread_blink_init(void)
 	ret = platform_driver_register(&drv);
 	if (ret) return ret;
 
+	acct_ctx = memacct_register(KBUILD_MODNAME, "ctx");
+	acct_lookup = memacct_register(KBUILD_MODNAME, "lookup");
+
 	/* 2) Crear y registrar la tabla de lookup para este dev_id */
-	lt = kzalloc(sizeof(*lt) + n * sizeof(struct gpiod_lookup), GFP_KERNEL);
+	lt_size = struct_size(lt, table, n);
+	lt = memacct_kzalloc(acct_lookup, lt_size, GFP_KERNEL);
 	if (!lt) { ret = -ENOMEM; goto err_drv; }
 	lt->dev_id = "kthread-blink-nodt.0";
 	lt->table[0] = GPIO_LOOKUP_IDX(
@@ -140,15 +527,18 @@ static int __init kthread_blink_init(void)
 	if (IS_ERR(pdev)) {
 		ret = PTR_ERR(pdev);
 		gpiod_remove_lookup_table(lt);
-		kfree(lt);
+		memacct_kfree(acct_lookup, lt, lt_size);
 		goto err_drv;
 	}
 	pr_info("kthread_blink_nodt: chip=%s gpio=%d %s period=%u ms\n",
 		chip, gpio, active_low ? "ACTIVE_LOW" : "ACTIVE_HIGH", period_ms);
+	blink_boot_init_done(&boot, t0);
 	return 0;
 
 err_drv:
 	platform_driver_unregister(&drv);
+	memacct_unregister(acct_lookup);
+	memacct_unregister(acct_ctx);
 	return ret;
 }
 
@@ -158,9 +548,11 @@ static void __exit kthread_blink_exit(void)
 		platform_device_unregister(pdev);
 	if (lt) {
 		gpiod_remove_lookup_table(lt);
-		kfree(lt);
+		memacct_kfree(acct_lookup, lt, lt_size);
 	}
 	platform_driver_unregister(&drv);
+	memacct_unregister(acct_lookup);
+	memacct_unregister(acct_ctx);
 }
 
 module_init(kthread_blink_init);
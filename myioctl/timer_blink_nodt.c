@@ -4,37 +4,88 @@
 #include <linux/gpio/consumer.h>
 #include <linux/gpio/machine.h>
 #include <linux/slab.h>
+#include <linux/ktime.h>
 #include <linux/timer.h>
 #include <linux/workqueue.h>
 #include <linux/jiffies.h>
+#include <linux/mutex.h>
 
 #include "blink_api.h"
+#include "blink_probe.h"
+#include "blink_gpio.h"
+#include "blink_cpu.h"
+#include "blink_cost.h"
+#include "blink_mode.h"
+#include "memacct.h"
 
 struct timer_blink {
+	struct device *dev;
 	struct gpio_desc *led;
 	struct timer_list timer;
 	struct work_struct work;
 	unsigned int period_ms;
 	bool state;
+	struct mutex lock;		/* led frente a cambios por sysfs */
+	struct mutex mode_lock;		/* mode; fuera de BLINK no hay timer armado */
+	unsigned int mode;
+	u64 wakeups;			/* disparos del timer */
+	struct blink_cpu place;		/* dónde se arma, bajo mode_lock */
+	struct blink_cost cost;		/* debugfs timer_blink/cost */
+	struct dentry *dbg;
 };
 static struct timer_blink *g_tb_ctx;  /* NUEVO */
+static DEFINE_MUTEX(g_tb_lock);         /* g_tb_ctx frente a remove */
+static BLOCKING_NOTIFIER_HEAD(timer_blink_chain);
+
+/*
+ * TIMER_PINNED: el callback re-arma en su propia CPU, pero un mod_timer()
+ * desde sysfs o ioctl lo movería a la del llamador. Fuera del callback se
+ * arma siempre aquí, en la CPU que elige la política. Con mode_lock.
+ */
+static void timer_blink_arm(struct timer_blink *ctx, unsigned int ms)
+{
+	del_timer_sync(&ctx->timer);
+	ctx->timer.expires = jiffies + msecs_to_jiffies(ms / 2);
+	cpus_read_lock();
+	add_timer_on(&ctx->timer, blink_cpu_pick(&ctx->place));
+	cpus_read_unlock();
+}
 
 /* === API exportada === */
 int timer_blink_nodt_set_period(unsigned int ms)
 {
-    if (!g_tb_ctx) return -ENODEV;
-    if (ms < 1) ms = 1;
-    g_tb_ctx->period_ms = ms;
-    mod_timer(&g_tb_ctx->timer, jiffies + msecs_to_jiffies(ms / 2));
+    unsigned int per = ms ?: 1;
+
+    mutex_lock(&g_tb_lock);
+    if (!g_tb_ctx) {
+        mutex_unlock(&g_tb_lock);
+        blink_journal_log(BLINK_JOP_API_SET_MS, BLINK_ID_TIMER, ms, -ENODEV);
+        return -ENODEV;
+    }
+    mutex_lock(&g_tb_ctx->mode_lock);
+    WRITE_ONCE(g_tb_ctx->period_ms, per);
+    /* En un modo fijo solo se guarda; se usa al volver a BLINK */
+    if (g_tb_ctx->mode == BLINK_MODE_BLINK)
+        timer_blink_arm(g_tb_ctx, per);
+    mutex_unlock(&g_tb_ctx->mode_lock);
+    mutex_unlock(&g_tb_lock);
+    blink_notify(&timer_blink_chain, BLINK_ID_TIMER, BLINK_EV_PERIOD, per);
+    blink_journal_log(BLINK_JOP_API_SET_MS, BLINK_ID_TIMER, ms, 0);
     return 0;
 }
 EXPORT_SYMBOL_GPL(timer_blink_nodt_set_period);
 
 int timer_blink_nodt_get_period(unsigned int *ms)
 {
-    if (!g_tb_ctx || !ms) return -EINVAL;
-    *ms = g_tb_ctx->period_ms;
-    return 0;
+    int ret = -EINVAL;
+
+    mutex_lock(&g_tb_lock);
+    if (g_tb_ctx && ms) {
+        *ms = READ_ONCE(g_tb_ctx->period_ms);
+        ret = 0;
+    }
+    mutex_unlock(&g_tb_lock);
+    return ret;
 }
 EXPORT_SYMBOL_GPL(timer_blink_nodt_get_period);
 
@@ -44,46 +95,333 @@ static char *chip = (char *)"pinctrl-bcm2711";
 module_param(chip, charp, 0444);
 static int gpio = 20; module_param(gpio, int, 0444);
 static bool active_low = false; module_param(active_low, bool, 0444);
-static unsigned int period_ms = 300; module_param(period_ms, uint, 0644);
+
+/* Escribir el parámetro cambia también el periodo del dispositivo en marcha */
+static unsigned int period_ms = 300;
+static int period_ms_set(const char *val, const struct kernel_param *kp)
+{
+	int ret = param_set_uint(val, kp);
+
+	/* Al cargar aún no hay ctx; set_period lo vuelve a mirar con g_tb_lock */
+	if (!ret && READ_ONCE(g_tb_ctx))
+		timer_blink_nodt_set_period(period_ms);
+	return ret;
+}
+
+static const struct kernel_param_ops period_ms_ops = {
+	.set = period_ms_set,
+	.get = param_get_uint,
+};
+module_param_cb(period_ms, &period_ms_ops, &period_ms, 0644);
 
 static struct platform_device *pdev;
 static struct platform_driver drv;
 static struct gpiod_lookup_table *lt;
+static size_t lt_size;
+static struct memacct *acct_ctx, *acct_lookup;
+
+static struct blink_boot boot;
+BLINK_BOOT_PARAMS(boot);
 
 static void blink_work(struct work_struct *w)
 {
 	struct timer_blink *ctx = container_of(w, struct timer_blink, work);
-	gpiod_set_value_cansleep(ctx->led, ctx->state);
+	u64 t0 = blink_cost_start();
+
+	mutex_lock(&ctx->lock);
+	blink_cost_gpio_cansleep(&ctx->cost, ctx->led, READ_ONCE(ctx->state));
+	mutex_unlock(&ctx->lock);
+	blink_cost_end(&ctx->cost, BLINK_COST_WORK, t0);
 }
 
 static void blink_timer(struct timer_list *t)
 {
 	struct timer_blink *ctx = from_timer(ctx, t, timer);
+	u64 t0 = blink_cost_start();
 
+	WRITE_ONCE(ctx->wakeups, ctx->wakeups + 1);
 	ctx->state = !ctx->state;
 	schedule_work(&ctx->work);
-	mod_timer(&ctx->timer, jiffies + msecs_to_jiffies(ctx->period_ms / 2));
+	mod_timer(&ctx->timer, jiffies + msecs_to_jiffies(READ_ONCE(ctx->period_ms) / 2));
+	blink_cost_end(&ctx->cost, BLINK_COST_CB, t0);
 }
 
-static int timer_blink_probe(struct platform_device *pdev)
+/*
+ * Fuera de BLINK no queda timer ni work pendiente: cero disparos. El LED
+ * se fija antes de soltar la referencia de PM.
+ */
+static int timer_blink_set_mode_ctx(struct timer_blink *ctx, unsigned int mode)
+{
+	unsigned int old;
+	int ret = 0;
+
+	if (mode >= BLINK_MODE__MAX)
+		return -EINVAL;
+
+	mutex_lock(&ctx->mode_lock);
+	old = ctx->mode;
+	if (mode == BLINK_MODE_BLINK) {
+		if (old != BLINK_MODE_BLINK) {
+			ret = blink_pm_busy(ctx->dev);
+			if (!ret) {
+				ctx->mode = mode;
+				timer_blink_arm(ctx, ctx->period_ms);
+			}
+		}
+		goto out;
+	}
+
+	if (old == BLINK_MODE_BLINK) {
+		del_timer_sync(&ctx->timer);
+		cancel_work_sync(&ctx->work);
+	}
+	mutex_lock(&ctx->lock);
+	WRITE_ONCE(ctx->state, blink_mode_level(mode, ctx->state));
+	gpiod_set_value_cansleep(ctx->led, ctx->state);
+	mutex_unlock(&ctx->lock);
+	ctx->mode = mode;
+	if (old == BLINK_MODE_BLINK)
+		blink_pm_idle(ctx->dev);
+out:
+	mutex_unlock(&ctx->mode_lock);
+	if (!ret && mode != old)
+		blink_notify(&timer_blink_chain, BLINK_ID_TIMER, BLINK_EV_MODE, mode);
+	return ret;
+}
+
+int timer_blink_nodt_set_mode(unsigned int mode)
+{
+    int ret;
+
+    mutex_lock(&g_tb_lock);
+    ret = g_tb_ctx ? timer_blink_set_mode_ctx(g_tb_ctx, mode) : -ENODEV;
+    mutex_unlock(&g_tb_lock);
+    blink_journal_log(BLINK_JOP_API_SET_MODE, BLINK_ID_TIMER, mode, ret);
+    return ret;
+}
+EXPORT_SYMBOL_GPL(timer_blink_nodt_set_mode);
+
+int timer_blink_nodt_get_mode(unsigned int *mode)
+{
+    int ret = -EINVAL;
+
+    mutex_lock(&g_tb_lock);
+    if (g_tb_ctx && mode) {
+        *mode = READ_ONCE(g_tb_ctx->mode);
+        ret = 0;
+    }
+    mutex_unlock(&g_tb_lock);
+    return ret;
+}
+EXPORT_SYMBOL_GPL(timer_blink_nodt_get_mode);
+
+/* Avisos de periodo y modo, en contexto de proceso (blink_genl) */
+int timer_blink_nodt_register_notifier(struct notifier_block *nb)
+{
+    return blocking_notifier_chain_register(&timer_blink_chain, nb);
+}
+EXPORT_SYMBOL_GPL(timer_blink_nodt_register_notifier);
+
+int timer_blink_nodt_unregister_notifier(struct notifier_block *nb)
+{
+    return blocking_notifier_chain_unregister(&timer_blink_chain, nb);
+}
+EXPORT_SYMBOL_GPL(timer_blink_nodt_unregister_notifier);
+
+/*
+ * Atributos del dispositivo (/sys/devices/platform/timer-blink-nodt.0):
+ * periodo, línea y polaridad se aplican sobre la marcha.
+ */
+static ssize_t period_ms_show(struct device *dev, struct device_attribute *attr,
+			      char *buf)
+{
+	struct timer_blink *ctx = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%u\n", READ_ONCE(ctx->period_ms));
+}
+
+static ssize_t period_ms_store(struct device *dev, struct device_attribute *attr,
+			       const char *buf, size_t len)
+{
+	unsigned int ms;
+	int ret = kstrtouint(buf, 0, &ms);
+
+	if (!ret)
+		ret = timer_blink_nodt_set_period(ms);
+	return ret ? ret : len;
+}
+static DEVICE_ATTR_RW(period_ms);
+
+/* Con ctx->lock el work no toca el LED: se cambia y se repone el nivel */
+static int timer_blink_set_led(struct device *dev, unsigned int line, bool low)
+{
+	struct timer_blink *ctx = dev_get_drvdata(dev);
+	struct gpio_desc *d;
+	int ret = 0;
+
+	mutex_lock(&ctx->lock);
+	if (line == blink_gpio_line(lt)) {
+		blink_gpio_polarity(lt, ctx->led, low);
+	} else {
+		d = blink_gpio_get(dev, lt, line, low);
+		if (IS_ERR(d)) {
+			ret = PTR_ERR(d);
+			goto out;
+		}
+		blink_gpio_put(dev, ctx->led);
+		ctx->led = d;
+	}
+	gpiod_set_value_cansleep(ctx->led, READ_ONCE(ctx->state));
+out:
+	mutex_unlock(&ctx->lock);
+	return ret;
+}
+
+static ssize_t gpio_show(struct device *dev, struct device_attribute *attr,
+			 char *buf)
+{
+	return sysfs_emit(buf, "%u\n", blink_gpio_line(lt));
+}
+
+static ssize_t gpio_store(struct device *dev, struct device_attribute *attr,
+			  const char *buf, size_t len)
+{
+	unsigned int line;
+	int ret = kstrtouint(buf, 0, &line);
+
+	if (!ret)
+		ret = timer_blink_set_led(dev, line, blink_gpio_active_low(lt));
+	return ret ? ret : len;
+}
+static DEVICE_ATTR_RW(gpio);
+
+static ssize_t active_low_show(struct device *dev, struct device_attribute *attr,
+			       char *buf)
+{
+	return sysfs_emit(buf, "%d\n", blink_gpio_active_low(lt));
+}
+
+static ssize_t active_low_store(struct device *dev, struct device_attribute *attr,
+				const char *buf, size_t len)
+{
+	bool low;
+	int ret = kstrtobool(buf, &low);
+
+	if (!ret)
+		ret = timer_blink_set_led(dev, blink_gpio_line(lt), low);
+	return ret ? ret : len;
+}
+static DEVICE_ATTR_RW(active_low);
+
+static ssize_t mode_show(struct device *dev, struct device_attribute *attr,
+			 char *buf)
+{
+	struct timer_blink *ctx = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%s\n", blink_mode_names[READ_ONCE(ctx->mode)]);
+}
+
+static ssize_t mode_store(struct device *dev, struct device_attribute *attr,
+			  const char *buf, size_t len)
+{
+	int mode = sysfs_match_string(blink_mode_names, buf);
+
+	if (mode < 0)
+		return mode;
+	mode = timer_blink_set_mode_ctx(dev_get_drvdata(dev), mode);
+	return mode ? mode : len;
+}
+static DEVICE_ATTR_RW(mode);
+
+/* En un modo fijo no debe moverse: no hay timer armado */
+static ssize_t wakeups_show(struct device *dev, struct device_attribute *attr,
+			    char *buf)
+{
+	struct timer_blink *ctx = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%llu\n", READ_ONCE(ctx->wakeups));
+}
+static DEVICE_ATTR_RO(wakeups);
+
+static ssize_t placement_show(struct device *dev, struct device_attribute *attr,
+			      char *buf)
+{
+	struct timer_blink *ctx = dev_get_drvdata(dev);
+
+	return blink_cpu_show(&ctx->place, buf);
+}
+
+/* El timer se vuelve a armar en la CPU nueva con medio periodo */
+static ssize_t placement_store(struct device *dev, struct device_attribute *attr,
+			       const char *buf, size_t len)
+{
+	struct timer_blink *ctx = dev_get_drvdata(dev);
+	unsigned int policy;
+	cpumask_var_t m;
+	int ret;
+
+	if (!alloc_cpumask_var(&m, GFP_KERNEL))
+		return -ENOMEM;
+	ret = blink_cpu_parse(&ctx->place, buf, &policy, m);
+	if (ret)
+		goto out;
+
+	mutex_lock(&ctx->mode_lock);
+	ctx->place.policy = policy;
+	cpumask_copy(&ctx->place.want, m);
+	if (ctx->mode == BLINK_MODE_BLINK)
+		timer_blink_arm(ctx, ctx->period_ms);
+	mutex_unlock(&ctx->mode_lock);
+out:
+	free_cpumask_var(m);
+	return ret ? ret : len;
+}
+static DEVICE_ATTR_RW(placement);
+
+static struct attribute *timer_blink_attrs[] = {
+	&dev_attr_period_ms.attr,
+	&dev_attr_gpio.attr,
+	&dev_attr_active_low.attr,
+	&dev_attr_mode.attr,
+	&dev_attr_wakeups.attr,
+	&dev_attr_placement.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(timer_blink);
+
+static int timer_blink_do_probe(struct platform_device *pdev)
 {
 	struct timer_blink *ctx;
+	int ret;
 
-	ctx = devm_kzalloc(&pdev->dev, sizeof(*ctx), GFP_KERNEL);
+	ctx = memacct_devm_kzalloc(acct_ctx, &pdev->dev, sizeof(*ctx), GFP_KERNEL);
 	if (!ctx) return -ENOMEM;
-
+	mutex_init(&ctx->lock);
+	mutex_init(&ctx->mode_lock);
+	ctx->dev = &pdev->dev;
+	ctx->mode = BLINK_MODE_BLINK;
+	ret = blink_cost_init(&pdev->dev, &ctx->cost);
+	if (ret) return ret;
 
 	ctx->led = devm_gpiod_get(&pdev->dev, "led", GPIOD_OUT_LOW);
 	if (IS_ERR(ctx->led))
 		return dev_err_probe(&pdev->dev, PTR_ERR(ctx->led), "gpiod_get\n");
 
 	ctx->period_ms = period_ms ?: 1;
+	ret = blink_pm_init(&pdev->dev);
+	if (ret) return ret;
+
 	INIT_WORK(&ctx->work, blink_work);
-	timer_setup(&ctx->timer, blink_timer, 0);
-	mod_timer(&ctx->timer, jiffies + msecs_to_jiffies(ctx->period_ms / 2));
+	timer_setup(&ctx->timer, blink_timer, TIMER_PINNED);
+	blink_cpu_init(&ctx->place, BLINK_ID_TIMER, HK_TYPE_TIMER);
+	ctx->dbg = debugfs_create_dir("timer_blink", NULL);
+	blink_cost_debugfs(ctx->dbg, &ctx->cost);
+	timer_blink_arm(ctx, ctx->period_ms);
 
 	platform_set_drvdata(pdev, ctx);
+	mutex_lock(&g_tb_lock);
 	g_tb_ctx = ctx;   /* NUEVO */
+	mutex_unlock(&g_tb_lock);
 	dev_info(&pdev->dev, "timer blink: %u ms\n", ctx->period_ms);
 	return 0;
 }
@@ -91,30 +429,49 @@ static int timer_blink_probe(struct platform_device *pdev)
 static int timer_blink_remove(struct platform_device *pdev)
 {
 	struct timer_blink *ctx = platform_get_drvdata(pdev);
+
+	/* Antes de del_timer_sync(): set_period ya no puede rearmarlo */
+	mutex_lock(&g_tb_lock);
+	g_tb_ctx = NULL; /* NUEVO */
+	mutex_unlock(&g_tb_lock);
+
+	debugfs_remove_recursive(ctx->dbg);
 	del_timer_sync(&ctx->timer);
 	cancel_work_sync(&ctx->work);
 	gpiod_set_value_cansleep(ctx->led, 0);
-	g_tb_ctx = NULL; /* NUEVO */
+	blink_pm_exit(&pdev->dev, ctx->mode);
 	return 0;
 }
 
+static int timer_blink_probe(struct platform_device *pdev)
+{
+	return blink_probe_timed(&boot, pdev, timer_blink_do_probe);
+}
+
 static struct platform_driver drv = {
 	.probe  = timer_blink_probe,
 	.remove = timer_blink_remove,
 	.driver = {
 		.name = "timer-blink-nodt",
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
+		.dev_groups = timer_blink_groups,
 	},
 };
 
 static int __init timer_blink_init(void)
 {
+	ktime_t t0 = ktime_get();
 	int ret;
 	size_t n = 2;
 
 	ret = platform_driver_register(&drv);
 	if (ret) return ret;
 
-	lt = kzalloc(sizeof(*lt) + n * sizeof(struct gpiod_lookup), GFP_KERNEL);
+	acct_ctx = memacct_register(KBUILD_MODNAME, "ctx");
+	acct_lookup = memacct_register(KBUILD_MODNAME, "lookup");
+
+	lt_size = struct_size(lt, table, n);
+	lt = memacct_kzalloc(acct_lookup, lt_size, GFP_KERNEL);
 	if (!lt) { ret = -ENOMEM; goto err_drv; }
 	lt->dev_id = "timer-blink-nodt.0";
 	lt->table[0] = GPIO_LOOKUP_IDX(
@@ -127,15 +484,18 @@ static int __init timer_blink_init(void)
 	if (IS_ERR(pdev)) {
 		ret = PTR_ERR(pdev);
 		gpiod_remove_lookup_table(lt);
-		kfree(lt);
+		memacct_kfree(acct_lookup, lt, lt_size);
 		goto err_drv;
 	}
 	pr_info("timer_blink_nodt: chip=%s gpio=%d %s period=%u ms\n",
 		chip, gpio, active_low ? "ACTIVE_LOW" : "ACTIVE_HIGH", period_ms);
+	blink_boot_init_done(&boot, t0);
 	return 0;
 
 err_drv:
 	platform_driver_unregister(&drv);
+	memacct_unregister(acct_lookup);
+	memacct_unregister(acct_ctx);
 	return ret;
 }
 
@@ -145,9 +505,11 @@ static void __exit timer_blink_exit(void)
 		platform_device_unregister(pdev);
 	if (lt) {
 		gpiod_remove_lookup_table(lt);
-		kfree(lt);
+		memacct_kfree(acct_lookup, lt, lt_size);
 	}
 	platform_driver_unregister(&drv);
+	memacct_unregister(acct_lookup);
+	memacct_unregister(acct_ctx);
 }
 
 module_init(timer_blink_init);